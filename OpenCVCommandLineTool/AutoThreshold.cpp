@@ -0,0 +1,572 @@
+﻿/// ----------------------- AutoThreshold -----------------------
+///
+/// 说明：基于直方图的全局阈值方法，见 AutoThreshold.h。
+///
+/// ----------------------- AutoThreshold -----------------------
+
+#include "AutoThreshold.h"
+#include "PixelKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+	const int kThresholdBins = 256;
+
+	const char* const kMethodNames[kThresholdMethodCount] = {
+		"default", "huang", "intermodes", "isodata", "li", "max_entropy", "mean", "min_error",
+		"minimum", "moments", "otsu", "percentile", "renyi_entropy", "shanbhag", "triangle", "yen"
+	};
+
+	// 累积和：count[i] = Σ h[0..i]，first[i] = Σ j * h[j]，second[i] = Σ j² * h[j]
+	struct CumulativeSums {
+		std::vector<double> count, first, second;
+
+		explicit CumulativeSums(const std::vector<double>& h) : count(h.size()), first(h.size()), second(h.size()) {
+			double c = 0, f = 0, s = 0;
+			for (size_t i = 0; i < h.size(); ++i) {
+				c += h[i];
+				f += i * h[i];
+				s += static_cast<double>(i) * i * h[i];
+				count[i] = c;
+				first[i] = f;
+				second[i] = s;
+			}
+		}
+	};
+
+	// 归一化直方图及其累积分布 p1，p2 = 1 - p1；first / last 为 p1、p2 均不为 0 的下标范围
+	struct Distribution {
+		std::vector<double> p, p1, p2;
+		int first = 0;
+		int last = 0;
+
+		explicit Distribution(const std::vector<double>& h) : p(h.size()), p1(h.size()), p2(h.size()) {
+			const int n = static_cast<int>(h.size());
+			double total = 0;
+			for (double v : h) total += v;
+			double cumulative = 0;
+			for (int i = 0; i < n; ++i) {
+				p[i] = h[i] / total;
+				cumulative += p[i];
+				p1[i] = cumulative;
+				p2[i] = 1.0 - cumulative;
+			}
+			const double eps = std::numeric_limits<double>::epsilon();
+			first = 0;
+			while (first < n - 1 && std::abs(p1[first]) < eps) ++first;
+			last = n - 1;
+			while (last > first && std::abs(p2[last]) < eps) --last;
+		}
+	};
+
+	// -x ln x，x = 0 时取 0
+	inline double entropyTerm(double x) {
+		return x > 0 ? -x * std::log(x) : 0;
+	}
+
+	bool isBimodal(const std::vector<double>& h) {
+		int modes = 0;
+		for (size_t k = 1; k + 1 < h.size(); ++k) {
+			if (h[k - 1] < h[k] && h[k + 1] < h[k]) {
+				if (++modes > 2) return false;
+			}
+		}
+		return modes == 2;
+	}
+
+	// 三点均值反复平滑，直到只剩两个峰；迭代过多时返回 false
+	bool smoothUntilBimodal(std::vector<double>& h) {
+		const int n = static_cast<int>(h.size());
+		for (int iter = 0; !isBimodal(h); ++iter) {
+			if (iter >= 10000) return false;
+			double previous = 0, current = 0, next = h[0];
+			for (int i = 0; i < n - 1; ++i) {
+				previous = current;
+				current = next;
+				next = h[i + 1];
+				h[i] = (previous + current + next) / 3;
+			}
+			h[n - 1] = (current + next) / 3;
+		}
+		return true;
+	}
+
+	// ImageJ 的 IsoData 变体：迭代求两类均值的中点
+	int defaultIsoData(std::vector<double> h) {
+		const int n = static_cast<int>(h.size());
+		// 众数远高于次高峰时压低，避免单一背景值主导
+		int mode = 0;
+		for (int i = 1; i < n; ++i) {
+			if (h[i] > h[mode]) mode = i;
+		}
+		double second = 0;
+		for (int i = 0; i < n; ++i) {
+			if (i != mode) second = std::max(second, h[i]);
+		}
+		if (h[mode] > second * 2 && second != 0) {
+			h[mode] = std::floor(second * 1.5);
+		}
+
+		// 两端的饱和像素不参与
+		h[0] = 0;
+		h[n - 1] = 0;
+		int lo = 0;
+		while (lo < n - 1 && h[lo] == 0) ++lo;
+		int hi = n - 1;
+		while (hi > 0 && h[hi] == 0) --hi;
+		if (lo >= hi) {
+			return n / 2;
+		}
+		const CumulativeSums sums(h);
+		const double base_count = (lo > 0) ? sums.count[lo - 1] : 0;
+		const double base_first = (lo > 0) ? sums.first[lo - 1] : 0;
+		int moving = lo;
+		double result = 0;
+		do {
+			const double count_low = sums.count[moving] - base_count;
+			const double first_low = sums.first[moving] - base_first;
+			const double count_high = sums.count[hi] - sums.count[moving];
+			const double first_high = sums.first[hi] - sums.first[moving];
+			const double mean_low = count_low > 0 ? first_low / count_low : 0;
+			const double mean_high = count_high > 0 ? first_high / count_high : 0;
+			result = (mean_low + mean_high) / 2.0;
+			++moving;
+		} while (moving + 1 <= result && moving < hi - 1);
+		return static_cast<int>(std::lround(result));
+	}
+
+	// Huang：模糊集的香农熵最小
+	int huang(const std::vector<double>& h) {
+		const int n = static_cast<int>(h.size());
+		int first = 0;
+		while (first < n && h[first] == 0) ++first;
+		if (first == n) return -1;
+		int last = n - 1;
+		while (last > first && h[last] == 0) --last;
+		if (first == last) return first;
+
+		const CumulativeSums sums(h);
+		const int range = last - first;
+		std::vector<double> smu(range + 1);
+		for (int i = 0; i <= range; ++i) {
+			const double mu = 1.0 / (1.0 + static_cast<double>(i) / range);
+			smu[i] = entropyTerm(mu) + entropyTerm(1 - mu);
+		}
+
+		int best = first;
+		double best_entropy = std::numeric_limits<double>::max();
+		const double base_count = (first > 0) ? sums.count[first - 1] : 0;
+		const double base_first = (first > 0) ? sums.first[first - 1] : 0;
+		for (int t = first; t < last; ++t) {
+			double entropy = 0;
+			int mu = static_cast<int>(std::lround((sums.first[t] - base_first) / (sums.count[t] - base_count)));
+			for (int i = first; i <= t; ++i) entropy += smu[std::abs(i - mu)] * h[i];
+			mu = static_cast<int>(std::lround((sums.first[last] - sums.first[t]) / (sums.count[last] - sums.count[t])));
+			for (int i = t + 1; i <= last; ++i) entropy += smu[std::abs(i - mu)] * h[i];
+			if (entropy < best_entropy) {
+				best_entropy = entropy;
+				best = t;
+			}
+		}
+		return best;
+	}
+
+	// Intermodes：平滑到双峰后取两峰中点
+	int intermodes(std::vector<double> h) {
+		if (!smoothUntilBimodal(h)) return -1;
+		int sum = 0;
+		for (size_t i = 1; i + 1 < h.size(); ++i) {
+			if (h[i - 1] < h[i] && h[i + 1] < h[i]) sum += static_cast<int>(i);
+		}
+		return sum / 2;
+	}
+
+	// Minimum：平滑到双峰后取两峰之间的谷底
+	int minimum(std::vector<double> h) {
+		if (!smoothUntilBimodal(h)) return -1;
+		for (size_t i = 1; i + 1 < h.size(); ++i) {
+			if (h[i - 1] > h[i] && h[i + 1] >= h[i]) return static_cast<int>(i);
+		}
+		return -1;
+	}
+
+	// IsoData（Ridler）：g 等于两类均值中点的第一个 g
+	int isoData(const std::vector<double>& h) {
+		const int n = static_cast<int>(h.size());
+		int g = 0;
+		for (int i = 1; i < n; ++i) {
+			if (h[i] > 0) {
+				g = i + 1;
+				break;
+			}
+		}
+		const CumulativeSums sums(h);
+		for (; g <= n - 2; ++g) {
+			const double count_low = sums.count[g];
+			const double count_high = sums.count[n - 1] - sums.count[g];
+			if (count_low > 0 && count_high > 0) {
+				const double mean_low = sums.first[g] / count_low;
+				const double mean_high = (sums.first[n - 1] - sums.first[g]) / count_high;
+				if (g == static_cast<int>(std::lround((mean_low + mean_high) / 2.0))) return g;
+			}
+		}
+		return -1;
+	}
+
+	// Li：迭代最小交叉熵
+	int li(const std::vector<double>& h) {
+		const int n = static_cast<int>(h.size());
+		const CumulativeSums sums(h);
+		const double total = sums.count[n - 1];
+		double next = sums.first[n - 1] / total;
+		int threshold = 0;
+		for (int iter = 0; iter < 1000; ++iter) {
+			const double previous = next;
+			threshold = std::min(n - 1, std::max(0, static_cast<int>(previous + 0.5)));
+			const double count_back = sums.count[threshold];
+			const double count_obj = total - count_back;
+			const double mean_back = count_back > 0 ? sums.first[threshold] / count_back : 0;
+			const double mean_obj = count_obj > 0 ? (sums.first[n - 1] - sums.first[threshold]) / count_obj : 0;
+			const double temp = (mean_back - mean_obj) / (std::log(mean_back) - std::log(mean_obj));
+			if (!std::isfinite(temp)) break;
+			next = (temp < -std::numeric_limits<double>::epsilon()) ? static_cast<int>(temp - 0.5) : static_cast<int>(temp + 0.5);
+			if (std::abs(next - previous) <= 0.5) break;
+		}
+		return threshold;
+	}
+
+	// MaxEntropy（Kapur）：两类熵之和最大；类熵 = ln P - Σ p ln p / P，用累积和 O(bins) 计算
+	int maxEntropy(const std::vector<double>& h) {
+		const Distribution d(h);
+		const int n = static_cast<int>(h.size());
+		std::vector<double> plogp(n);
+		double cumulative = 0;
+		for (int i = 0; i < n; ++i) {
+			cumulative += (d.p[i] > 0) ? d.p[i] * std::log(d.p[i]) : 0;
+			plogp[i] = cumulative;
+		}
+		int threshold = -1;
+		double best = -std::numeric_limits<double>::max();
+		for (int t = d.first; t <= d.last; ++t) {
+			if (d.p1[t] <= 0 || d.p2[t] <= 0) continue;
+			const double back = std::log(d.p1[t]) - plogp[t] / d.p1[t];
+			const double obj = std::log(d.p2[t]) - (plogp[n - 1] - plogp[t]) / d.p2[t];
+			if (back + obj > best) {
+				best = back + obj;
+				threshold = t;
+			}
+		}
+		return threshold;
+	}
+
+	int mean(const std::vector<double>& h) {
+		const CumulativeSums sums(h);
+		return static_cast<int>(std::floor(sums.first.back() / sums.count.back()));
+	}
+
+	// MinError（Kittler-Illingworth）的迭代形式，从均值出发
+	int minError(const std::vector<double>& h) {
+		const int n = static_cast<int>(h.size());
+		const CumulativeSums sums(h);
+		const double a_end = sums.count[n - 1], b_end = sums.first[n - 1], c_end = sums.second[n - 1];
+		int threshold = mean(h);
+		int previous = -2;
+		for (int iter = 0; iter < 1000 && threshold != previous; ++iter) {
+			if (threshold < 0 || threshold >= n - 1) return -1;
+			const double a = sums.count[threshold], b = sums.first[threshold], c = sums.second[threshold];
+			if (a <= 0 || a >= a_end) return -1;
+			const double mu = b / a;
+			const double nu = (b_end - b) / (a_end - a);
+			const double p = a / a_end;
+			const double q = (a_end - a) / a_end;
+			const double sigma2 = c / a - mu * mu;
+			const double tau2 = (c_end - c) / (a_end - a) - nu * nu;
+			const double w0 = 1.0 / sigma2 - 1.0 / tau2;
+			const double w1 = mu / sigma2 - nu / tau2;
+			const double w2 = (mu * mu) / sigma2 - (nu * nu) / tau2 + std::log10((sigma2 * q * q) / (tau2 * p * p));
+			const double sqterm = w1 * w1 - w0 * w2;
+			if (sqterm < 0) break;   // 无解时保留当前值
+			previous = threshold;
+			const double temp = (w1 + std::sqrt(sqterm)) / w0;
+			threshold = std::isfinite(temp) ? static_cast<int>(std::floor(temp)) : previous;
+		}
+		return threshold;
+	}
+
+	// Moments（Tsai）：二值化前后保持前三阶矩
+	int moments(const std::vector<double>& h) {
+		const Distribution d(h);
+		double m1 = 0, m2 = 0, m3 = 0;
+		for (size_t i = 0; i < h.size(); ++i) {
+			const double x = static_cast<double>(i);
+			m1 += x * d.p[i];
+			m2 += x * x * d.p[i];
+			m3 += x * x * x * d.p[i];
+		}
+		const double cd = m2 - m1 * m1;
+		const double c0 = (-m2 * m2 + m1 * m3) / cd;
+		const double c1 = (-m3 + m2 * m1) / cd;
+		const double root = std::sqrt(c1 * c1 - 4 * c0);
+		const double z0 = 0.5 * (-c1 - root);
+		const double z1 = 0.5 * (-c1 + root);
+		const double p0 = (z1 - m1) / (z1 - z0);   // 低于阈值一类的比例
+		for (size_t i = 0; i < h.size(); ++i) {
+			if (d.p1[i] > p0) return static_cast<int>(i);
+		}
+		return -1;
+	}
+
+	// Otsu：类间方差最大
+	int otsu(const std::vector<double>& h) {
+		const int n = static_cast<int>(h.size());
+		const CumulativeSums sums(h);
+		const double total = sums.count[n - 1];
+		const double mean_total = sums.first[n - 1] / total;
+		int threshold = -1;
+		double best = -1;
+		for (int t = 0; t < n - 1; ++t) {
+			const double w0 = sums.count[t] / total;
+			if (w0 <= 0 || w0 >= 1) continue;
+			const double mu = sums.first[t] / total;
+			const double between = (mean_total * w0 - mu) * (mean_total * w0 - mu) / (w0 * (1 - w0));
+			if (between > best) {
+				best = between;
+				threshold = t;
+			}
+		}
+		return threshold;
+	}
+
+	// Percentile：低于阈值的像素最接近一半
+	int percentile(const std::vector<double>& h) {
+		const Distribution d(h);
+		int threshold = -1;
+		double best = 1.0;
+		for (size_t i = 0; i < h.size(); ++i) {
+			const double distance = std::abs(d.p1[i] - 0.5);
+			if (distance < best) {
+				best = distance;
+				threshold = static_cast<int>(i);
+			}
+		}
+		return threshold;
+	}
+
+	// RenyiEntropy：alpha = 0.5、1（MaxEntropy）、2 三个阈值的加权组合
+	int renyiEntropy(const std::vector<double>& h) {
+		const Distribution d(h);
+		const int n = static_cast<int>(h.size());
+		const int t_star2 = maxEntropy(h);
+		if (t_star2 < 0) return -1;
+
+		// Σ p^alpha / P^alpha 可由 p^alpha 的累积和得到
+		std::vector<double> sqrt_sum(n), sq_sum(n);
+		double s = 0, q = 0;
+		for (int i = 0; i < n; ++i) {
+			s += std::sqrt(d.p[i]);
+			q += d.p[i] * d.p[i];
+			sqrt_sum[i] = s;
+			sq_sum[i] = q;
+		}
+		int t_star1 = t_star2, t_star3 = t_star2;
+		double best1 = 0, best3 = 0;
+		for (int t = d.first; t <= d.last; ++t) {
+			if (d.p1[t] <= 0 || d.p2[t] <= 0) continue;
+			// alpha = 0.5，系数 1 / (1 - alpha) = 2
+			const double back1 = sqrt_sum[t] / std::sqrt(d.p1[t]);
+			const double obj1 = (sqrt_sum[n - 1] - sqrt_sum[t]) / std::sqrt(d.p2[t]);
+			const double ent1 = (back1 * obj1 > 0) ? 2.0 * std::log(back1 * obj1) : 0;
+			if (ent1 > best1) {
+				best1 = ent1;
+				t_star1 = t;
+			}
+			// alpha = 2，系数 -1
+			const double back3 = sq_sum[t] / (d.p1[t] * d.p1[t]);
+			const double obj3 = (sq_sum[n - 1] - sq_sum[t]) / (d.p2[t] * d.p2[t]);
+			const double ent3 = (back3 * obj3 > 0) ? -std::log(back3 * obj3) : 0;
+			if (ent3 > best3) {
+				best3 = ent3;
+				t_star3 = t;
+			}
+		}
+
+		int t[3] = { t_star1, t_star2, t_star3 };
+		std::sort(t, t + 3);
+		int beta1, beta2, beta3;
+		if (std::abs(t[0] - t[1]) <= 5) {
+			if (std::abs(t[1] - t[2]) <= 5) { beta1 = 1; beta2 = 2; beta3 = 1; }
+			else { beta1 = 0; beta2 = 1; beta3 = 3; }
+		}
+		else {
+			if (std::abs(t[1] - t[2]) <= 5) { beta1 = 3; beta2 = 1; beta3 = 0; }
+			else { beta1 = 1; beta2 = 2; beta3 = 1; }
+		}
+		const double omega = d.p1[t[2]] - d.p1[t[0]];
+		return static_cast<int>(t[0] * (d.p1[t[0]] + 0.25 * omega * beta1) + 0.25 * t[1] * omega * beta2
+			+ t[2] * (d.p2[t[2]] + 0.25 * omega * beta3));
+	}
+
+	// Shanbhag：两类模糊熵之差最小
+	int shanbhag(const std::vector<double>& h) {
+		const Distribution d(h);
+		const int n = static_cast<int>(h.size());
+		int threshold = -1;
+		double best = std::numeric_limits<double>::max();
+		for (int t = d.first; t <= d.last; ++t) {
+			if (d.p1[t] <= 0 || d.p2[t] <= 0) continue;
+			double back = 0;
+			double term = 0.5 / d.p1[t];
+			for (int i = 1; i <= t; ++i) back -= d.p[i] * std::log(1.0 - term * d.p1[i - 1]);
+			back *= term;
+			double obj = 0;
+			term = 0.5 / d.p2[t];
+			for (int i = t + 1; i < n; ++i) obj -= d.p[i] * std::log(1.0 - term * d.p2[i]);
+			obj *= term;
+			const double difference = std::abs(back - obj);
+			if (difference < best) {
+				best = difference;
+				threshold = t;
+			}
+		}
+		return threshold;
+	}
+
+	// Triangle：峰顶到直方图较长一侧末端的连线，取距离连线最远的区间；长尾在左侧时先翻转
+	int triangle(std::vector<double> h) {
+		const int n = static_cast<int>(h.size());
+		int lo = 0;
+		while (lo < n - 1 && h[lo] == 0) ++lo;
+		if (lo > 0) --lo;
+		int hi = n - 1;
+		while (hi > 0 && h[hi] == 0) --hi;
+		if (hi < n - 1) ++hi;
+		int peak = 0;
+		for (int i = 1; i < n; ++i) {
+			if (h[i] > h[peak]) peak = i;
+		}
+		const bool inverted = (peak - lo) < (hi - peak);
+		if (inverted) {
+			std::reverse(h.begin(), h.end());
+			lo = n - 1 - hi;
+			peak = n - 1 - peak;
+		}
+		if (lo == peak) {
+			return inverted ? n - 1 - lo : lo;
+		}
+		double nx = h[peak];
+		double ny = lo - peak;
+		const double length = std::sqrt(nx * nx + ny * ny);
+		nx /= length;
+		ny /= length;
+		const double offset = nx * lo + ny * h[lo];
+		int split = lo;
+		double split_distance = 0;
+		for (int i = lo + 1; i <= peak; ++i) {
+			const double distance = nx * i + ny * h[i] - offset;
+			if (distance > split_distance) {
+				split = i;
+				split_distance = distance;
+			}
+		}
+		--split;
+		return inverted ? n - 1 - split : split;
+	}
+
+	// Yen：最大相关准则
+	int yen(const std::vector<double>& h) {
+		const Distribution d(h);
+		const int n = static_cast<int>(h.size());
+		std::vector<double> p1_sq(n), p2_sq(n);
+		double cumulative = 0;
+		for (int i = 0; i < n; ++i) {
+			cumulative += d.p[i] * d.p[i];
+			p1_sq[i] = cumulative;
+		}
+		p2_sq[n - 1] = 0;
+		for (int i = n - 2; i >= 0; --i) {
+			p2_sq[i] = p2_sq[i + 1] + d.p[i + 1] * d.p[i + 1];
+		}
+		int threshold = -1;
+		double best = -std::numeric_limits<double>::max();
+		for (int t = 0; t < n; ++t) {
+			const double squares = p1_sq[t] * p2_sq[t];
+			const double classes = d.p1[t] * (1.0 - d.p1[t]);
+			const double criterion = -(squares > 0 ? std::log(squares) : 0) + 2 * (classes > 0 ? std::log(classes) : 0);
+			if (criterion > best) {
+				best = criterion;
+				threshold = t;
+			}
+		}
+		return threshold;
+	}
+
+}
+
+
+const char* thresholdMethodName(AutoThresholdMethod method) {
+	return (method >= 0 && method < kThresholdMethodCount) ? kMethodNames[method] : "";
+}
+
+bool parseThresholdMethod(const std::string& name, AutoThresholdMethod& method) {
+	for (int i = 0; i < kThresholdMethodCount; ++i) {
+		if (name == kMethodNames[i]) {
+			method = static_cast<AutoThresholdMethod>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+HistogramResult thresholdHistogram(const cv::Mat& gray) {
+	CV_Assert(gray.channels() == 1);
+	HistogramOptions options;
+	if (gray.depth() == CV_16U) {
+		ChannelStatistics stats = kernelStatistics(gray);
+		const double range = stats.max[0] - stats.min[0] + 1;
+		options.bins = static_cast<int>(std::min<double>(range, kThresholdBins));
+		options.minimum = stats.min[0];
+		options.maximum = stats.max[0] + 1;
+	}
+	return computeHistogram(gray, options);
+}
+
+int autoThreshold(const std::vector<uint64_t>& histogram, AutoThresholdMethod method) {
+	std::vector<double> h(histogram.begin(), histogram.end());
+	double total = 0;
+	for (double v : h) total += v;
+	if (h.size() < 2 || total <= 0) {
+		return -1;
+	}
+
+	int threshold = -1;
+	switch (method) {
+	case kThresholdDefault: threshold = defaultIsoData(h); break;
+	case kThresholdHuang: threshold = huang(h); break;
+	case kThresholdIntermodes: threshold = intermodes(h); break;
+	case kThresholdIsoData: threshold = isoData(h); break;
+	case kThresholdLi: threshold = li(h); break;
+	case kThresholdMaxEntropy: threshold = maxEntropy(h); break;
+	case kThresholdMean: threshold = mean(h); break;
+	case kThresholdMinError: threshold = minError(h); break;
+	case kThresholdMinimum: threshold = minimum(h); break;
+	case kThresholdMoments: threshold = moments(h); break;
+	case kThresholdOtsu: threshold = otsu(h); break;
+	case kThresholdPercentile: threshold = percentile(h); break;
+	case kThresholdRenyiEntropy: threshold = renyiEntropy(h); break;
+	case kThresholdShanbhag: threshold = shanbhag(h); break;
+	case kThresholdTriangle: threshold = triangle(h); break;
+	case kThresholdYen: threshold = yen(h); break;
+	default: break;
+	}
+	const int n = static_cast<int>(h.size());
+	return (threshold >= 0 && threshold < n) ? threshold : -1;
+}
+
+double thresholdLevel(const HistogramResult& histogram, int bin, int depth) {
+	// 区间 bin 的上边界；整数像素 v >= edge 等价于 v > ceil(edge) - 1
+	const double edge = histogram.minimum + (bin + 1) * histogram.bin_width;
+	return (depth == CV_32F) ? edge : std::ceil(edge) - 1;
+}
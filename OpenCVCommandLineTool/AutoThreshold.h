@@ -0,0 +1,58 @@
+﻿/// ----------------------- AutoThreshold -----------------------
+///
+/// 说明：全局自动阈值方法族（与 ImageJ 的 Auto Threshold 方法对应）；
+///      所有方法都只读取同一份单通道直方图，直方图对每幅图像只统计一次，
+///      之后每种方法的开销只与区间数有关（至多 256 个区间，除 Huang / Shanbhag 外均为 O(bins)），
+///      因此可以在一次像素遍历后比较多种方法的结果。
+///
+///      直方图：8U 每个灰度一个区间；16U 按数据的 [min, max] 自适应分箱，
+///      取值个数不超过 256 时每个值一个区间，否则均分为 256 个区间；32F 为数据范围内的 256 个区间。
+///
+///      返回值为区间下标 t：区间 <= t 的像素为低于阈值的一类，其余为高于阈值的一类；失败时返回 -1。
+///
+/// ----------------------- AutoThreshold -----------------------
+
+#pragma once
+#ifndef AUTO_THRESHOLD_H
+#define AUTO_THRESHOLD_H
+
+#include <opencv2/opencv.hpp>
+#include "Histogram.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum AutoThresholdMethod {
+	kThresholdDefault,       // ImageJ 默认方法（IsoData 的变体，忽略过高的众数）
+	kThresholdHuang,
+	kThresholdIntermodes,
+	kThresholdIsoData,
+	kThresholdLi,
+	kThresholdMaxEntropy,
+	kThresholdMean,
+	kThresholdMinError,
+	kThresholdMinimum,
+	kThresholdMoments,
+	kThresholdOtsu,
+	kThresholdPercentile,
+	kThresholdRenyiEntropy,
+	kThresholdShanbhag,
+	kThresholdTriangle,
+	kThresholdYen,
+	kThresholdMethodCount
+};
+
+// 方法名（如 "otsu"、"max_entropy"）与枚举互相转换；未知名称返回 false
+const char* thresholdMethodName(AutoThresholdMethod method);
+bool parseThresholdMethod(const std::string& name, AutoThresholdMethod& method);
+
+// 单通道图像（8U / 16U / 32F）的阈值直方图，分箱规则见上
+HistogramResult thresholdHistogram(const cv::Mat& gray);
+
+// 在直方图上计算阈值区间
+int autoThreshold(const std::vector<uint64_t>& histogram, AutoThresholdMethod method);
+
+// 区间 bin 对应的阈值：像素值 > 返回值即高于阈值；整数位深（depth 非 CV_32F）返回整数
+double thresholdLevel(const HistogramResult& histogram, int bin, int depth);
+
+#endif // AUTO_THRESHOLD_H
@@ -0,0 +1,163 @@
+﻿/// ----------------------- BackgroundSubtraction -----------------------
+///
+/// 说明：大半径背景扣除，见 BackgroundSubtraction.h。
+///
+/// ----------------------- BackgroundSubtraction -----------------------
+
+#include "BackgroundSubtraction.h"
+#include "RankFilters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+
+	// 与 ImageJ 一致的缩小倍数
+	int shrinkFactor(float radius) {
+		if (radius <= 10) return 1;
+		if (radius <= 30) return 2;
+		if (radius <= 100) return 4;
+		return 8;
+	}
+
+	// 一维抛物线腐蚀：out[i] = min_j f[j] + k * (i - j)^2（Felzenszwalb 下包络，O(n)）
+	void parabolicErode(const float* f, float* out, int n, double k, std::vector<int>& v, std::vector<double>& z) {
+		v.resize(n);
+		z.resize(n + 1);
+		int top = 0;
+		v[0] = 0;
+		z[0] = -std::numeric_limits<double>::infinity();
+		z[1] = std::numeric_limits<double>::infinity();
+		for (int q = 1; q < n; ++q) {
+			// z[0] 为负无穷，循环最多退到栈底
+			double s = ((f[q] + k * q * q) - (f[v[top]] + k * v[top] * v[top])) / (2 * k * (q - v[top]));
+			while (s <= z[top]) {
+				--top;
+				s = ((f[q] + k * q * q) - (f[v[top]] + k * v[top] * v[top])) / (2 * k * (q - v[top]));
+			}
+			++top;
+			v[top] = q;
+			z[top] = s;
+			z[top + 1] = std::numeric_limits<double>::infinity();
+		}
+		for (int q = 0, i = 0; q < n; ++q) {
+			while (z[i + 1] < q) ++i;
+			const double d = q - v[i];
+			out[q] = static_cast<float>(f[v[i]] + k * d * d);
+		}
+	}
+
+	// 二维抛物面腐蚀（sign = -1 时为膨胀）：先逐行，再逐列
+	void paraboloidPass(cv::Mat& image, double k, float sign) {
+		const int rows = image.rows;
+		const int cols = image.cols;
+		cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+			std::vector<float> line(cols), out(cols);
+			std::vector<int> v;
+			std::vector<double> z;
+			for (int y = range.start; y < range.end; ++y) {
+				float* p = image.ptr<float>(y);
+				for (int x = 0; x < cols; ++x) line[x] = sign * p[x];
+				parabolicErode(line.data(), out.data(), cols, k, v, z);
+				for (int x = 0; x < cols; ++x) p[x] = sign * out[x];
+			}
+		});
+		cv::parallel_for_(cv::Range(0, cols), [&](const cv::Range& range) {
+			std::vector<float> line(rows), out(rows);
+			std::vector<int> v;
+			std::vector<double> z;
+			for (int x = range.start; x < range.end; ++x) {
+				for (int y = 0; y < rows; ++y) line[y] = sign * image.at<float>(y, x);
+				parabolicErode(line.data(), out.data(), rows, k, v, z);
+				for (int y = 0; y < rows; ++y) image.at<float>(y, x) = sign * out[y];
+			}
+		});
+	}
+
+	// 块内最小值缩小
+	cv::Mat shrinkMin(const cv::Mat& image, int factor) {
+		cv::Mat small((image.rows + factor - 1) / factor, (image.cols + factor - 1) / factor, CV_32FC1);
+		cv::parallel_for_(cv::Range(0, small.rows), [&](const cv::Range& range) {
+			for (int sy = range.start; sy < range.end; ++sy) {
+				float* out = small.ptr<float>(sy);
+				const int y1 = std::min((sy + 1) * factor, image.rows);
+				for (int sx = 0; sx < small.cols; ++sx) {
+					const int x0 = sx * factor;
+					const int x1 = std::min(x0 + factor, image.cols);
+					float m = std::numeric_limits<float>::max();
+					for (int y = sy * factor; y < y1; ++y) {
+						const float* p = image.ptr<float>(y);
+						for (int x = x0; x < x1; ++x) m = std::min(m, p[x]);
+					}
+					out[sx] = m;
+				}
+			}
+		});
+		return small;
+	}
+
+	// 暗背景约定下的背景估计（亮背景时调用方先取反）
+	cv::Mat estimateFast(const cv::Mat& plane, float radius) {
+		const int factor = shrinkFactor(radius);
+		cv::Mat background = (factor > 1) ? shrinkMin(plane, factor) : plane.clone();
+
+		// 球半径 r 在顶点处的曲率为 1 / (2r)；缩小后距离按 factor 缩放
+		const double k = static_cast<double>(factor) * factor / (2.0 * radius);
+		paraboloidPass(background, k, 1.f);   // 腐蚀
+		paraboloidPass(background, k, -1.f);  // 膨胀
+
+		if (factor > 1) {
+			cv::resize(background, background, plane.size(), 0, 0, cv::INTER_LINEAR);
+			// 插值可能高于原图，开运算的结果不应超过原图
+			background = cv::min(background, plane);
+		}
+		return background;
+	}
+
+	cv::Mat estimateExact(const cv::Mat& plane, float radius) {
+		cv::Mat background;
+		rankMinimum(plane, background, radius, true);
+		rankMaximum(background, background, radius, true);
+		return background;
+	}
+
+}
+
+
+void subtractBackground(const cv::Mat& src, cv::Mat& dst, float radius, bool light_background,
+	BackgroundMethod method, bool dont_subtract) {
+	if (src.empty()) {
+		std::cerr << "Error: Image is empty." << std::endl;
+		return;
+	}
+	if (radius <= 0) {
+		std::cerr << "Error: Radius must be positive." << std::endl;
+		return;
+	}
+
+	const int depth = src.depth();
+	std::vector<cv::Mat> planes;
+	cv::split(src, planes);
+	for (cv::Mat& plane : planes) {
+		cv::Mat values;
+		plane.convertTo(values, CV_32F);
+		// 亮背景取反后按暗背景处理：闭运算 = -开运算(-f)
+		if (light_background) {
+			values = -values;
+		}
+
+		cv::Mat background = (method == kBackgroundFast) ? estimateFast(values, radius) : estimateExact(values, radius);
+
+		cv::Mat result;
+		if (dont_subtract) {
+			result = light_background ? cv::Mat(-background) : background;
+		}
+		else {
+			result = values - background;
+		}
+		result.convertTo(plane, depth);
+	}
+	cv::merge(planes, dst);
+}
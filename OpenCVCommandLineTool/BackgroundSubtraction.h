@@ -0,0 +1,28 @@
+﻿/// ----------------------- BackgroundSubtraction -----------------------
+///
+/// 说明：大半径背景扣除（顶帽变换）；
+///      1. 快速模式：与 ImageJ 的 Subtract Background 类似，先按半径把图像缩小（块内取最小值），
+///         在低分辨率上做滚动抛物面开运算，再双线性插值回原尺寸并截断到不超过原图，最后相减；
+///         抛物面结构元可分离，每个方向用下包络（lower envelope）算法，开销与半径无关；
+///      2. 精确模式：圆形平坦结构元的开 / 闭运算，最小值、最大值滤波按行分解（见 RankFilters）。
+///      暗背景（亮目标）：结果 = 原图 - 开运算；亮背景（暗目标）：结果 = 闭运算 - 原图。
+///      多通道图像逐通道处理，结果位深与输入相同。
+///
+/// ----------------------- BackgroundSubtraction -----------------------
+
+#pragma once
+#ifndef BACKGROUND_SUBTRACTION_H
+#define BACKGROUND_SUBTRACTION_H
+
+#include <opencv2/opencv.hpp>
+
+enum BackgroundMethod {
+	kBackgroundFast,
+	kBackgroundExact
+};
+
+// dont_subtract 为 true 时输出背景本身
+void subtractBackground(const cv::Mat& src, cv::Mat& dst, float radius, bool light_background,
+	BackgroundMethod method, bool dont_subtract = false);
+
+#endif // BACKGROUND_SUBTRACTION_H
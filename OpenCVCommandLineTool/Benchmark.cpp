@@ -0,0 +1,649 @@
+﻿/// ----------------------- Benchmark -----------------------
+///
+/// 说明：性能基准测试，见 Benchmark.h。
+///
+/// ----------------------- Benchmark -----------------------
+
+#include "Benchmark.h"
+#include "Histogram.h"
+#include "AutoThreshold.h"
+#include "RankFilters.h"
+#include "KernelConvolution.h"
+#include "RecursiveGaussian.h"
+#include "BackgroundSubtraction.h"
+#include "TileExecutor.h"
+#include "Thinning.h"
+#include "Morphology.h"
+#include "BitMask.h"
+#include "ParticleAnalyzer.h"
+#include "Reconstruction.h"
+#include "DistanceMap.h"
+#include "Watershed.h"
+#include "Measurements.h"
+#include "PolygonTracing.h"
+#include "Selection.h"
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+namespace {
+
+	// 生成指定像素数（百万）的近似正方形随机图像
+	cv::Mat syntheticImage(double megapixels, int type) {
+		int side = static_cast<int>(std::sqrt(megapixels * 1e6));
+		cv::Mat image(side, side, type);
+		double high = (CV_MAT_DEPTH(type) == CV_16U) ? 65536.0 : (CV_MAT_DEPTH(type) == CV_32F ? 1.0 : 256.0);
+		cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(high));
+		return image;
+	}
+
+	std::string typeName(int type) {
+		static const char* depth_names[] = { "8U", "8S", "16U", "16S", "32S", "32F", "64F" };
+		return std::string(depth_names[CV_MAT_DEPTH(type)]) + "C" + std::to_string(CV_MAT_CN(type));
+	}
+
+	double parseMegapixels(const std::vector<std::string>& args, size_t index, double fallback) {
+		if (args.size() > index) {
+			try {
+				return std::stod(args[index]);
+			}
+			catch (const std::exception&) {
+				std::cout << "Error: Invalid megapixel count '" << args[index] << "', using " << fallback << ".\n";
+			}
+		}
+		return fallback;
+	}
+
+	/// ----------------------- 直方图 -----------------------
+	// bench histogram [megapixels=100]
+	void benchHistogram(const std::vector<std::string>& args) {
+		double megapixels = parseMegapixels(args, 1, 100);
+		const int types[] = { CV_8UC1, CV_8UC3, CV_16UC1, CV_16UC3, CV_32FC1 };
+
+		std::cout << "histogram, " << megapixels << " MP, " << cv::getNumThreads() << " threads\n";
+		for (int type : types) {
+			cv::Mat image = syntheticImage(megapixels, type);
+
+			HistogramOptions options;
+			double engine_ms = measureMilliseconds([&]() { computeHistogram(image, options); });
+
+			std::cout << "  " << std::setw(6) << typeName(type) << "  engine " << std::fixed << std::setprecision(1)
+				<< engine_ms << " ms";
+
+			// 原实现仅支持单通道 calcHist，作为对照
+			if (CV_MAT_CN(type) == 1) {
+				int hist_size = 256;
+				float range[] = { 0, (CV_MAT_DEPTH(type) == CV_16U) ? 65536.f : (CV_MAT_DEPTH(type) == CV_32F ? 1.f : 256.f) };
+				const float* hist_range = { range };
+				double calc_ms = measureMilliseconds([&]() {
+					cv::Mat hist;
+					cv::calcHist(&image, 1, 0, cv::Mat(), hist, 1, &hist_size, &hist_range);
+				});
+				std::cout << "  calcHist " << calc_ms << " ms";
+			}
+			std::cout << std::defaultfloat << "\n";
+		}
+	}
+
+	/// ----------------------- 排序滤波 -----------------------
+	// bench rank [megapixels=4]；32F 随机图像的取值几乎互不相同，测量分桶中值
+	void benchRank(const std::vector<std::string>& args) {
+		double megapixels = parseMegapixels(args, 1, 4);
+		const int types[] = { CV_8UC1, CV_16UC1, CV_32FC1 };
+		const int radii[] = { 2, 5, 10, 20, 50 };
+
+		std::cout << "rank filters, " << megapixels << " MP, " << cv::getNumThreads() << " threads\n";
+		for (int type : types) {
+			cv::Mat image = syntheticImage(megapixels, type);
+			for (int radius : radii) {
+				cv::Mat result;
+				int kernel_size = 2 * radius + 1;
+				cv::Mat element = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(kernel_size, kernel_size));
+
+				double min_ms = measureMilliseconds([&]() { rankMinimum(image, result, static_cast<float>(radius)); });
+				double min_circular_ms = measureMilliseconds([&]() { rankMinimum(image, result, static_cast<float>(radius), true); });
+				double erode_ms = measureMilliseconds([&]() { cv::morphologyEx(image, result, cv::MORPH_ERODE, element); });
+				double median_ms = measureMilliseconds([&]() { rankMedian(image, result, static_cast<float>(radius)); }, 1);
+
+				std::cout << "  " << std::setw(6) << typeName(type) << "  r=" << std::setw(2) << radius << std::fixed << std::setprecision(1)
+					<< "  min " << min_ms << " ms  min(circular) " << min_circular_ms << " ms  morphologyEx " << erode_ms << " ms"
+					<< "  median " << median_ms << " ms";
+
+				// medianBlur 对 16 位图像只支持 3 和 5 的核
+				if (CV_MAT_DEPTH(type) == CV_8U || kernel_size <= 5) {
+					double blur_ms = measureMilliseconds([&]() { cv::medianBlur(image, result, kernel_size); }, 1);
+					std::cout << "  medianBlur " << blur_ms << " ms";
+				}
+				std::cout << std::defaultfloat << "\n";
+			}
+		}
+	}
+
+	/// ----------------------- 卷积 -----------------------
+	// bench convolve [megapixels=4]
+	void benchConvolve(const std::vector<std::string>& args) {
+		double megapixels = parseMegapixels(args, 1, 4);
+		const int sizes[] = { 3, 7, 15, 31, 63 };
+		const char* strategy_names[] = { "direct", "separable", "fft" };
+		cv::Mat image = syntheticImage(megapixels, CV_32FC1);
+
+		std::cout << "convolve, " << megapixels << " MP, " << cv::getNumThreads() << " threads\n";
+		for (int size : sizes) {
+			// 可分离的高斯核与随机稠密核
+			cv::Mat gaussian = cv::getGaussianKernel(size, -1, CV_32F);
+			cv::Mat dense(size, size, CV_32FC1);
+			cv::randu(dense, cv::Scalar::all(-1), cv::Scalar::all(1));
+			const cv::Mat kernels[] = { gaussian * gaussian.t(), dense };
+			const char* kernel_names[] = { "gaussian", "dense" };
+
+			for (int k = 0; k < 2; ++k) {
+				std::ostringstream text;
+				for (int y = 0; y < size; ++y) {
+					for (int x = 0; x < size; ++x) {
+						text << kernels[k].at<float>(y, x) << ' ';
+					}
+					text << '\n';
+				}
+				std::shared_ptr<const AnalyzedKernel> analyzed = analyzeKernel(text.str());
+				cv::Mat result;
+				double analyzed_ms = measureMilliseconds([&]() { convolveAnalyzed(image, result, *analyzed); });
+				double filter2d_ms = measureMilliseconds([&]() { cv::filter2D(image, result, -1, analyzed->kernel); });
+
+				std::cout << "  " << std::setw(8) << kernel_names[k] << " " << std::setw(2) << size << "x" << std::setw(2) << size
+					<< "  rank " << std::setw(2) << analyzed->rank << "  " << std::setw(9) << strategy_names[analyzed->strategy]
+					<< std::fixed << std::setprecision(1) << "  " << analyzed_ms << " ms  filter2D " << filter2d_ms << " ms"
+					<< std::defaultfloat << "\n";
+			}
+		}
+	}
+
+	/// ----------------------- 高斯 -----------------------
+	// bench gaussian [megapixels=16]
+	void benchGaussian(const std::vector<std::string>& args) {
+		double megapixels = parseMegapixels(args, 1, 16);
+		const double sigmas[] = { 2, 5, 10, 25, 50, 100 };
+		const int types[] = { CV_8UC1, CV_16UC1, CV_32FC1 };
+
+		std::cout << "gaussian, " << megapixels << " MP, " << cv::getNumThreads() << " threads\n";
+		for (int type : types) {
+			cv::Mat image = syntheticImage(megapixels, type);
+			for (double sigma : sigmas) {
+				cv::Mat result;
+				double recursive_ms = measureMilliseconds([&]() { recursiveGaussian(image, result, sigma); });
+				double unsharp_ms = measureMilliseconds([&]() { recursiveUnsharpMask(image, result, sigma, 0.6); });
+				double opencv_ms = measureMilliseconds([&]() { cv::GaussianBlur(image, result, cv::Size(0, 0), sigma); }, 1);
+
+				std::cout << "  " << std::setw(6) << typeName(type) << "  sigma " << std::setw(3) << sigma << std::fixed << std::setprecision(1)
+					<< "  recursive " << recursive_ms << " ms  unsharp " << unsharp_ms << " ms  GaussianBlur " << opencv_ms << " ms"
+					<< std::defaultfloat << "\n";
+			}
+		}
+	}
+
+	/// ----------------------- 背景扣除 -----------------------
+	// bench tophat [megapixels=4]
+	void benchTopHat(const std::vector<std::string>& args) {
+		double megapixels = parseMegapixels(args, 1, 4);
+		const float radii[] = { 10, 25, 50, 100 };
+		cv::Mat image = syntheticImage(megapixels, CV_8UC1);
+
+		std::cout << "tophat, " << megapixels << " MP, " << cv::getNumThreads() << " threads\n";
+		for (float radius : radii) {
+			cv::Mat result;
+			int kernel_size = static_cast<int>(2 * radius + 1);
+			cv::Mat element = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(kernel_size, kernel_size));
+
+			double fast_ms = measureMilliseconds([&]() { subtractBackground(image, result, radius, false, kBackgroundFast); });
+			double exact_ms = measureMilliseconds([&]() { subtractBackground(image, result, radius, false, kBackgroundExact); });
+			double opencv_ms = measureMilliseconds([&]() { cv::morphologyEx(image, result, cv::MORPH_TOPHAT, element); }, 1);
+
+			std::cout << "  r=" << std::setw(3) << radius << std::fixed << std::setprecision(1)
+				<< "  fast " << fast_ms << " ms  exact " << exact_ms << " ms  morphologyEx " << opencv_ms << " ms"
+				<< std::defaultfloat << "\n";
+		}
+	}
+
+	/// ----------------------- 分块执行 -----------------------
+	// bench tiles [megapixels=16] [tile_size=512]：线程数从 1 到硬件线程数的加速比
+	void benchTiles(const std::vector<std::string>& args) {
+		double megapixels = parseMegapixels(args, 1, 16);
+		TileOptions options;
+		if (args.size() > 2) {
+			options.tile_size = std::max(16, std::atoi(args[2].c_str()));
+		}
+		const int max_threads = TileExecutor::threadCount(TileOptions());
+		cv::Mat image = syntheticImage(megapixels, CV_8UC1);
+
+		struct Case {
+			const char* name;
+			int halo;
+			TileOperation op;
+		};
+		const Case cases[] = {
+			{ "median r=5", 5, [](const cv::Mat& in, cv::Mat& out) { rankMedian(in, out, 5); } },
+			{ "minimum r=20", 20, [](const cv::Mat& in, cv::Mat& out) { rankMinimum(in, out, 20, true); } },
+			{ "erode x3", 3, [](const cv::Mat& in, cv::Mat& out) { cv::erode(in, out, cv::Mat(), cv::Point(-1, -1), 3); } },
+		};
+
+		std::vector<int> thread_counts;
+		for (int threads = 1; threads < max_threads; threads *= 2) {
+			thread_counts.push_back(threads);
+		}
+		thread_counts.push_back(max_threads);
+
+		std::cout << "tiles, " << megapixels << " MP, tile " << options.tile_size << " px\n";
+		for (const Case& c : cases) {
+			double single_ms = 0;
+			for (int threads : thread_counts) {
+				options.threads = threads;
+				double ms = measureMilliseconds([&]() {
+					cv::Mat work = image.clone();
+					TileExecutor::run(work, c.halo, c.op, -1, options);
+				});
+				if (threads == 1) single_ms = ms;
+				std::cout << "  " << std::setw(14) << c.name << "  threads " << std::setw(3) << threads << std::fixed << std::setprecision(1)
+					<< "  " << ms << " ms  speedup " << std::setprecision(2) << single_ms / ms << std::defaultfloat << "\n";
+			}
+		}
+	}
+
+	/// ----------------------- 骨架化 -----------------------
+	// bench skeletonize [megapixels=4]：合成粗斑块掩码上，查找表细化与原先的腐蚀 / 膨胀迭代比较
+	void benchSkeletonize(const std::vector<std::string>& args) {
+		double megapixels = parseMegapixels(args, 1, 4);
+		cv::Mat noise = syntheticImage(megapixels, CV_8UC1);
+		cv::Mat mask;
+		cv::GaussianBlur(noise, noise, cv::Size(), 8);
+		cv::threshold(noise, mask, 128, 255, cv::THRESH_BINARY);
+
+		cv::Mat result;
+		double lut_ms = measureMilliseconds([&]() { thinBinary(mask, result); });
+		double morph_ms = measureMilliseconds([&]() {
+			cv::Mat image = mask.clone();
+			cv::Mat skel(image.size(), CV_8UC1, cv::Scalar(0));
+			cv::Mat temp, eroded;
+			cv::Mat element = cv::getStructuringElement(cv::MORPH_CROSS, cv::Size(3, 3));
+			while (true) {
+				cv::erode(image, eroded, element);
+				cv::dilate(eroded, temp, element);
+				cv::subtract(image, temp, temp);
+				cv::bitwise_or(skel, temp, skel);
+				eroded.copyTo(image);
+				if (cv::countNonZero(image) == 0) break;
+			}
+		}, 1);
+
+		std::cout << "skeletonize, " << megapixels << " MP, " << cv::countNonZero(mask) << " foreground pixels\n"
+			<< std::fixed << std::setprecision(1)
+			<< "  lut thinning " << lut_ms << " ms  erode/dilate loop " << morph_ms << " ms"
+			<< std::defaultfloat << "\n";
+	}
+
+	/// ----------------------- 颗粒分析 -----------------------
+	// bench particles [megapixels=16]：合成斑点掩码上，分条并查集标记 + 统计与 connectedComponentsWithStats 比较
+	void benchParticles(const std::vector<std::string>& args) {
+		double megapixels = parseMegapixels(args, 1, 16);
+		cv::Mat noise = syntheticImage(megapixels, CV_8UC1);
+		cv::Mat mask;
+		cv::GaussianBlur(noise, noise, cv::Size(), 2);
+		cv::threshold(noise, mask, 140, 255, cv::THRESH_BINARY);
+
+		ParticleResult result;
+		double striped_ms = measureMilliseconds([&]() { result = analyzeParticles(mask, noise); });
+		double opencv_ms = measureMilliseconds([&]() {
+			cv::Mat labels, stats, centroids;
+			cv::connectedComponentsWithStats(mask, labels, stats, centroids, 8, CV_32S);
+		});
+
+		std::cout << "particles, " << megapixels << " MP, " << result.components << " components\n"
+			<< std::fixed << std::setprecision(1)
+			<< "  striped union-find (with perimeter / mean) " << striped_ms << " ms  connectedComponentsWithStats " << opencv_ms << " ms"
+			<< std::defaultfloat << "\n";
+	}
+
+	/// ----------------------- 形态学重建 -----------------------
+	// bench reconstruct [megapixels=16]：填洞（重建）与带边框 floodFill 比较，另测 EDM 的 h 极大值
+	void benchReconstruct(const std::vector<std::string>& args) {
+		double megapixels = parseMegapixels(args, 1, 16);
+		cv::Mat noise = syntheticImage(megapixels, CV_8UC1);
+		cv::Mat mask;
+		cv::GaussianBlur(noise, noise, cv::Size(), 3);
+		cv::threshold(noise, mask, 128, 255, cv::THRESH_BINARY);
+
+		cv::Mat filled;
+		double reconstruct_ms = measureMilliseconds([&]() { fillHolesMask(mask, filled); });
+		double flood_ms = measureMilliseconds([&]() {
+			cv::Mat padded;
+			cv::copyMakeBorder(mask, padded, 1, 1, 1, 1, cv::BORDER_CONSTANT, cv::Scalar(0));
+			cv::floodFill(padded, cv::Point(0, 0), cv::Scalar(255));
+			cv::Mat holes = ~padded(cv::Rect(1, 1, mask.cols, mask.rows));
+			cv::bitwise_or(mask, holes, holes);
+		});
+
+		cv::Mat dist, maxima;
+		euclideanDistanceMap(mask, dist);
+		double maxima_ms = measureMilliseconds([&]() { hMaxima(dist, 0.5, maxima); });
+
+		std::cout << "reconstruct, " << megapixels << " MP\n"
+			<< std::fixed << std::setprecision(1)
+			<< "  fill holes: reconstruction " << reconstruct_ms << " ms  floodFill " << flood_ms << " ms\n"
+			<< "  h-maxima of EDM (h = 0.5) " << maxima_ms << " ms"
+			<< std::defaultfloat << "\n";
+	}
+
+	/// ----------------------- 距离映射 -----------------------
+	// bench edm [megapixels=16]：精确可分离 EDM 与 distanceTransform（精确 / 5x5 掩模）比较
+	void benchEdm(const std::vector<std::string>& args) {
+		double megapixels = parseMegapixels(args, 1, 16);
+		cv::Mat noise = syntheticImage(megapixels, CV_8UC1);
+		cv::Mat mask;
+		cv::GaussianBlur(noise, noise, cv::Size(), 6);
+		cv::threshold(noise, mask, 120, 255, cv::THRESH_BINARY);
+
+		cv::Mat exact, precise, approximate;
+		double separable_ms = measureMilliseconds([&]() { euclideanDistanceMap(mask, exact); });
+		double precise_ms = measureMilliseconds([&]() { cv::distanceTransform(mask, precise, cv::DIST_L2, cv::DIST_MASK_PRECISE); });
+		double mask5_ms = measureMilliseconds([&]() { cv::distanceTransform(mask, approximate, cv::DIST_L2, 5); });
+
+		double max_error = cv::norm(exact, approximate, cv::NORM_INF);
+		std::cout << "edm, " << megapixels << " MP\n"
+			<< std::fixed << std::setprecision(1)
+			<< "  separable " << separable_ms << " ms  distanceTransform precise " << precise_ms
+			<< " ms  5x5 " << mask5_ms << " ms\n"
+			<< std::setprecision(3) << "  max 5x5 error " << max_error << " px"
+			<< std::defaultfloat << "\n";
+	}
+
+	/// ----------------------- 分水岭 -----------------------
+	// bench watershed [megapixels=16]：EDM 桶队列分水岭与 cv::watershed（同一组种子，EDM 转为 8UC3）比较
+	void benchWatershed(const std::vector<std::string>& args) {
+		double megapixels = parseMegapixels(args, 1, 16);
+		cv::Mat noise = syntheticImage(megapixels, CV_8UC1);
+		cv::Mat mask;
+		cv::GaussianBlur(noise, noise, cv::Size(), 6);
+		cv::threshold(noise, mask, 120, 255, cv::THRESH_BINARY);
+
+		cv::Mat separated;
+		double bucket_ms = measureMilliseconds([&]() { watershedSeparate(mask, separated); });
+		double opencv_ms = measureMilliseconds([&]() {
+			cv::Mat edm, maxima, markers, relief;
+			euclideanDistanceMap(mask, edm);
+			hMaxima(edm, 0.5, maxima);
+			cv::connectedComponents(maxima, markers, 8, CV_32S);
+			markers.setTo(-1, ~mask);
+			cv::normalize(edm, relief, 0, 255, cv::NORM_MINMAX, CV_8U);
+			cv::cvtColor(255 - relief, relief, cv::COLOR_GRAY2BGR);
+			cv::watershed(relief, markers);
+		}, 1);
+
+		std::cout << "watershed, " << megapixels << " MP, " << cv::countNonZero(mask) - cv::countNonZero(separated) << " line pixels\n"
+			<< std::fixed << std::setprecision(1)
+			<< "  bucket queue (with EDM and seeds) " << bucket_ms << " ms  cv::watershed " << opencv_ms << " ms"
+			<< std::defaultfloat << "\n";
+	}
+
+	/// ----------------------- 二值形态学 -----------------------
+	// bench morphology [megapixels=4] [iterations=50]：分解后的结构元与 3x3 核迭代比较
+	void benchMorphology(const std::vector<std::string>& args) {
+		double megapixels = parseMegapixels(args, 1, 4);
+		int iterations = (args.size() > 2) ? std::max(1, std::atoi(args[2].c_str())) : 50;
+		cv::Mat noise = syntheticImage(megapixels, CV_8UC1);
+		cv::Mat mask;
+		cv::GaussianBlur(noise, noise, cv::Size(), 4);
+		cv::threshold(noise, mask, 128, 255, cv::THRESH_BINARY);
+
+		std::cout << "morphology, " << megapixels << " MP, " << iterations << " iterations\n" << std::fixed << std::setprecision(1);
+		const struct { const char* name; StructuringElement element; int shape; } elements[] = {
+			{ "square", kElementSquare, cv::MORPH_RECT },
+			{ "diamond", kElementDiamond, cv::MORPH_CROSS },
+			{ "disc", kElementDisc, -1 },
+		};
+		cv::Mat result;
+		for (const auto& e : elements) {
+			double decomposed_ms = measureMilliseconds([&]() { binaryErode(mask, result, iterations, 1, e.element, false); });
+			std::cout << "  " << std::setw(7) << e.name << "  decomposed " << decomposed_ms << " ms";
+			if (e.shape >= 0) {
+				cv::Mat kernel = cv::getStructuringElement(e.shape, cv::Size(3, 3));
+				double iterated_ms = measureMilliseconds([&]() { cv::erode(mask, result, kernel, cv::Point(-1, -1), iterations); }, 1);
+				std::cout << "  3x3 x " << iterations << " " << iterated_ms << " ms";
+			}
+			std::cout << "\n";
+		}
+		double counted_ms = measureMilliseconds([&]() { binaryErode(mask, result, iterations, 3, kElementSquare, false); }, 1);
+		std::cout << "  count=3 (lookup table) " << counted_ms << " ms" << std::defaultfloat << "\n";
+	}
+
+	/// ----------------------- 位掩码 -----------------------
+	// bench bitmask [megapixels=16]：每像素 1 位的掩码与 0 / 255 的 8 位掩码比较内存与吞吐
+	void benchBitMask(const std::vector<std::string>& args) {
+		double megapixels = parseMegapixels(args, 1, 16);
+		cv::Mat noise = syntheticImage(megapixels, CV_8UC1);
+		cv::Mat a, b;
+		cv::GaussianBlur(noise, noise, cv::Size(), 4);
+		cv::threshold(noise, a, 128, 255, cv::THRESH_BINARY);
+		cv::threshold(noise, b, 100, 255, cv::THRESH_BINARY_INV);
+
+		BitMask bits_a = BitMask::fromMat(a);
+		BitMask bits_b = BitMask::fromMat(b);
+		std::cout << "bitmask, " << megapixels << " MP\n" << std::fixed << std::setprecision(1)
+			<< "  memory: 8-bit " << a.total() / 1048576.0 << " MiB  packed " << bits_a.byteSize() / 1048576.0 << " MiB\n";
+
+		cv::Mat result;
+		double pack_ms = measureMilliseconds([&]() { BitMask::fromMat(a); });
+		double unpack_ms = measureMilliseconds([&]() { bits_a.toMat(); });
+		std::cout << "  pack " << pack_ms << " ms  unpack " << unpack_ms << " ms\n";
+
+		double and_bits_ms = measureMilliseconds([&]() { BitMask c = bits_a; c &= bits_b; });
+		double and_mat_ms = measureMilliseconds([&]() { cv::bitwise_and(a, b, result); });
+		double xor_bits_ms = measureMilliseconds([&]() { BitMask c = bits_a; c ^= bits_b; });
+		double xor_mat_ms = measureMilliseconds([&]() { cv::bitwise_xor(a, b, result); });
+		size_t count = 0;
+		double count_bits_ms = measureMilliseconds([&]() { count = bits_a.count(); });
+		double count_mat_ms = measureMilliseconds([&]() { cv::countNonZero(a); });
+		std::cout << "  and: packed " << and_bits_ms << " ms  8-bit " << and_mat_ms << " ms\n"
+			<< "  xor: packed " << xor_bits_ms << " ms  8-bit " << xor_mat_ms << " ms\n"
+			<< "  count (" << count << "): packed " << count_bits_ms << " ms  countNonZero " << count_mat_ms << " ms\n";
+
+		const int radii[] = { 1, 10, 50 };
+		for (int radius : radii) {
+			double bits_ms = measureMilliseconds([&]() { BitMask c = bits_a; c.erode(radius, false); });
+			double round_trip_ms = measureMilliseconds([&]() { binaryErode(a, result, radius, 1, kElementSquare, false); });
+			double rank_ms = measureMilliseconds([&]() { rankMinimum(a, result, static_cast<float>(radius)); });
+			std::cout << "  erode r=" << std::setw(2) << radius << ": packed " << bits_ms << " ms  with pack/unpack " << round_trip_ms
+				<< " ms  8-bit van Herk " << rank_ms << " ms\n";
+		}
+		std::cout << std::defaultfloat;
+	}
+
+	/// ----------------------- 自动阈值 -----------------------
+	// bench threshold [megapixels=16]：一次直方图统计与之后全部方法的耗时
+	void benchThreshold(const std::vector<std::string>& args) {
+		double megapixels = parseMegapixels(args, 1, 16);
+		const int types[] = { CV_8UC1, CV_16UC1, CV_32FC1 };
+
+		std::cout << "auto threshold, " << megapixels << " MP, " << cv::getNumThreads() << " threads\n";
+		for (int type : types) {
+			cv::Mat image = syntheticImage(megapixels, type);
+			cv::GaussianBlur(image, image, cv::Size(), 2);
+
+			HistogramResult histogram;
+			double histogram_ms = measureMilliseconds([&]() { histogram = thresholdHistogram(image); });
+			double methods_ms = measureMilliseconds([&]() {
+				for (int i = 0; i < kThresholdMethodCount; ++i) {
+					autoThreshold(histogram.counts[0], static_cast<AutoThresholdMethod>(i));
+				}
+			});
+			std::cout << "  " << std::setw(6) << typeName(type) << "  histogram (" << histogram.bins << " bins) "
+				<< std::fixed << std::setprecision(1) << histogram_ms << " ms  all " << kThresholdMethodCount
+				<< " methods " << std::setprecision(3) << methods_ms << " ms" << std::defaultfloat << "\n";
+		}
+	}
+
+	/// ----------------------- 形状测量 -----------------------
+	// bench measure [megapixels=16] [shapes=5000]：网格上的矩形与多边形，与逐形状整幅掩码 + meanStdDev 比较
+	void benchMeasure(const std::vector<std::string>& args) {
+		double megapixels = parseMegapixels(args, 1, 16);
+		int count = 5000;
+		if (args.size() > 2) {
+			try {
+				count = std::max(1, std::stoi(args[2]));
+			}
+			catch (const std::exception&) {
+				std::cout << "Error: Invalid shape count '" << args[2] << "', using " << count << ".\n";
+			}
+		}
+		cv::Mat image = syntheticImage(megapixels, CV_8UC1);
+
+		const int per_row = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+		const int cell = std::max(4, image.cols / per_row);
+		std::vector<MyShape> shapes;
+		shapes.reserve(count);
+		for (int i = 0; i < count; ++i) {
+			const double x = (i % per_row) * cell;
+			const double y = (i / per_row) * cell;
+			const double size = cell * 0.8;
+			if (i % 2 == 0) {
+				MyShape shape("rect", 0);
+				shape.addPoint(x, y);
+				shape.addPoint(x + size, y + size);
+				shapes.push_back(shape);
+			}
+			else {
+				MyShape shape("polygon", 1);
+				shape.addPoint(x + size / 2, y);
+				shape.addPoint(x + size, y + size / 2);
+				shape.addPoint(x + size / 2, y + size);
+				shape.addPoint(x, y + size / 2);
+				shapes.push_back(shape);
+			}
+		}
+
+		double measure_ms = measureMilliseconds([&]() { measureShapes(image, shapes); });
+		// 对照：每个形状一张整幅图像的掩码，只测前 20 个再按形状数折算
+		const int sampled = std::min(count, 20);
+		double naive_ms = measureMilliseconds([&]() {
+			for (int i = 0; i < sampled; ++i) {
+				cv::Mat mask = cv::Mat::zeros(image.size(), CV_8UC1);
+				Selection region = Selection::fromShape(shapes[i], image.size());
+				if (region.mask.empty()) mask(region.bounds).setTo(255);
+				else region.mask.copyTo(mask(region.bounds));
+				cv::Scalar mean, stddev;
+				cv::meanStdDev(image, mean, stddev, mask);
+			}
+		}, 1) * count / sampled;
+
+		std::cout << "measure, " << megapixels << " MP, " << count << " shapes, " << cv::getNumThreads() << " threads\n"
+			<< std::fixed << std::setprecision(1)
+			<< "  per-shape bounding boxes " << measure_ms << " ms  full-image mask per shape (estimated) " << naive_ms << " ms"
+			<< std::defaultfloat << "\n";
+	}
+
+	/// ----------------------- 掩码转多边形 -----------------------
+	// bench polygonize [instances=2000]：椭圆实例掩码的轮廓追踪与简化，统计顶点数与掩码像素数
+	void benchPolygonize(const std::vector<std::string>& args) {
+		int count = 2000;
+		if (args.size() > 1) {
+			try {
+				count = std::max(1, std::stoi(args[1]));
+			}
+			catch (const std::exception&) {
+				std::cout << "Error: Invalid instance count '" << args[1] << "', using " << count << ".\n";
+			}
+		}
+
+		cv::RNG rng(12345);
+		std::vector<MyShape> instances;
+		instances.reserve(count);
+		int64_t mask_pixels = 0;
+		for (int i = 0; i < count; ++i) {
+			const int width = rng.uniform(20, 120);
+			const int height = rng.uniform(20, 120);
+			SegmentOutput segment;
+			segment._id = 0;
+			segment._confidence = 1.f;
+			segment._box = cv::Rect2f(static_cast<float>(i % 64) * 128, static_cast<float>(i / 64) * 128, static_cast<float>(width), static_cast<float>(height));
+			segment._boxMask = cv::Mat::zeros(height, width, CV_8UC1);
+			cv::ellipse(segment._boxMask, cv::Point(width / 2, height / 2), cv::Size(width / 2 - 1, height / 2 - 1),
+				rng.uniform(0.0, 180.0), 0, 360, cv::Scalar(255), cv::FILLED);
+			mask_pixels += segment._boxMask.total();
+
+			MyShape shape("instance", 2);
+			shape.addPoint(segment._box.x, segment._box.y);
+			shape.addPoint(segment._box.x + width, segment._box.y + height);
+			shape.setSegmentOutput(segment);
+			instances.push_back(shape);
+		}
+
+		const double tolerances[] = { 0.5, 1.0, 2.0 };
+		std::cout << "polygonize, " << count << " instances, " << mask_pixels << " box-mask pixels, "
+			<< TileExecutor::threadCount(TileExecutor::getOptions()) << " threads\n";
+		for (double tolerance : tolerances) {
+			std::vector<MyShape> shapes;
+			double convert_ms = measureMilliseconds([&]() {
+				shapes = instances;
+				convertMasksToPolygons(shapes, tolerance);
+			});
+			size_t vertices = 0;
+			for (const MyShape& shape : shapes) {
+				vertices += shape.getPoints().size();
+			}
+			std::cout << "  tolerance " << tolerance << ": " << std::fixed << std::setprecision(1) << convert_ms << " ms, "
+				<< std::setprecision(1) << static_cast<double>(vertices) / count << " vertices per instance" << std::defaultfloat << "\n";
+		}
+	}
+
+	const std::map<std::string, std::function<void(const std::vector<std::string>&)>>& benchmarks() {
+		static const std::map<std::string, std::function<void(const std::vector<std::string>&)>> table = {
+			{ "histogram", benchHistogram },
+			{ "rank", benchRank },
+			{ "convolve", benchConvolve },
+			{ "gaussian", benchGaussian },
+			{ "tophat", benchTopHat },
+			{ "tiles", benchTiles },
+			{ "skeletonize", benchSkeletonize },
+			{ "morphology", benchMorphology },
+			{ "bitmask", benchBitMask },
+			{ "particles", benchParticles },
+			{ "reconstruct", benchReconstruct },
+			{ "edm", benchEdm },
+			{ "watershed", benchWatershed },
+			{ "threshold", benchThreshold },
+			{ "measure", benchMeasure },
+			{ "polygonize", benchPolygonize },
+		};
+		return table;
+	}
+
+}
+
+
+double measureMilliseconds(const std::function<void()>& fn, int repeats) {
+	double best = 0;
+	for (int i = 0; i < repeats; ++i) {
+		int64 start = cv::getTickCount();
+		fn();
+		double elapsed = (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+		best = (i == 0) ? elapsed : std::min(best, elapsed);
+	}
+	return best;
+}
+
+void runBenchmark(const std::vector<std::string>& args) {
+	const auto& table = benchmarks();
+	auto it = args.empty() ? table.end() : table.find(args[0]);
+	if (it == table.end()) {
+		std::cout << "Available benchmarks:";
+		for (const auto& entry : table) {
+			std::cout << " " << entry.first;
+		}
+		std::cout << "\n";
+		return;
+	}
+	it->second(args);
+}
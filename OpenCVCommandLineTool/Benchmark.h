@@ -0,0 +1,23 @@
+﻿/// ----------------------- Benchmark -----------------------
+///
+/// 说明：性能基准测试；
+///      使用合成图像比较新实现与原有 OpenCV 实现的耗时，结果输出到标准输出。
+///      通过命令 `bench <name> [args...]` 调用，不需要加载图像。
+///
+/// ----------------------- Benchmark -----------------------
+
+#pragma once
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// 运行 fn repeats 次，返回最短耗时（毫秒）
+double measureMilliseconds(const std::function<void()>& fn, int repeats = 3);
+
+// 执行名为 args[0] 的基准测试；未知名称时列出所有可用测试
+void runBenchmark(const std::vector<std::string>& args);
+
+#endif // BENCHMARK_H
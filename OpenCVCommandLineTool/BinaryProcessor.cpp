@@ -1,171 +1,415 @@
 ﻿#include <BinaryProcessor.h>
+#include "PointwisePipeline.h"
+#include "PixelKernels.h"
+#include "Histogram.h"
+#include "AutoThreshold.h"
+#include "LocalStatistics.h"
+#include "TileExecutor.h"
+#include "Thinning.h"
+#include "Reconstruction.h"
+#include "DistanceMap.h"
+#include "Watershed.h"
+
+#include <limits>
+
+
+namespace {
+
+	// 自动阈值使用的单通道图像：彩色转灰度，8U / 16U / 32F 以外的位深转为 32F，不修改原图
+	cv::Mat thresholdSource(const cv::Mat& image) {
+		cv::Mat gray = image;
+		if (gray.channels() == 3) {
+			cv::cvtColor(gray, gray, cv::COLOR_BGR2GRAY);
+		}
+		else if (gray.channels() == 4) {
+			cv::cvtColor(gray, gray, cv::COLOR_BGRA2GRAY);
+		}
+		if (gray.depth() != CV_8U && gray.depth() != CV_16U && gray.depth() != CV_32F) {
+			gray.convertTo(gray, CV_32F);
+		}
+		return gray;
+	}
 
+	// Sauvola 的标准差动态范围 r 未指定时取位深范围的一半：8 位为 128（ImageJ 的默认值），
+	// 16 位为 32768，浮点数据按 [0, 1] 取 0.5
+	double sauvolaRange(int depth) {
+		switch (depth) {
+		case CV_8U: return 128;
+		case CV_8S: return 128;
+		case CV_16U: return 32768;
+		case CV_16S: return 32768;
+		default: return 0.5;
+		}
+	}
+
+	// 按 edm_output 转换距离值：kOverwrite / k8Bit 为 CV_8U（四舍五入，超过 255 截断），k16Bit 为 CV_16U，k32Bit 保持 CV_32F
+	cv::Mat convertEdm(const cv::Mat& edm, EdmOutput output) {
+		cv::Mat converted;
+		switch (output) {
+		case k16Bit: edm.convertTo(converted, CV_16U); break;
+		case k32Bit: converted = edm; break;
+		default: edm.convertTo(converted, CV_8U); break;
+		}
+		return converted;
+	}
+
+}
 
-BinaryProcessor::BinaryProcessor(cv::Mat& img)
-	: image_mat(img), options(BinaryOptions()) {}
+
+BinaryProcessor::BinaryProcessor(cv::Mat& img, BitMask* packed)
+	: image_mat(img), packed(packed), options(BinaryOptions()) {}
 
 
 void BinaryProcessor::setOptions(const BinaryOptions& options) {
 	this->options = options;
 }
 
+const BinaryOptions& BinaryProcessor::getOptions() const {
+	return options;
+}
+
+void BinaryProcessor::unpack() {
+	if (packed && !packed->empty()) {
+		image_mat = packed->toMat();
+		*packed = BitMask();
+	}
+}
+
+void BinaryProcessor::pack() {
+	if (packed && !image_mat.empty()) {
+		*packed = BitMask::fromMat(image_mat);
+		image_mat.release();
+	}
+}
+
+bool BinaryProcessor::usePacked() {
+	if (!packed || options.count > 1 || options.element != kElementSquare) {
+		return false;
+	}
+	if (packed->empty()) {
+		ensureBinary();
+		if (image_mat.empty()) {
+			return false;
+		}
+		pack();
+	}
+	return true;
+}
+
+// 以下操作要求 CV_8UC1 二值图像；其他类型按 “任一通道非零即前景” 转换
+void BinaryProcessor::ensureBinary() {
+	unpack();
+	if (!image_mat.empty() && image_mat.type() != CV_8UC1) {
+		kernelNonZeroMask(image_mat, image_mat);
+	}
+}
+
 #include <opencv2/opencv.hpp>
 
-void BinaryProcessor::makeBinary() {
+// 彩色图像与其他位深只在临时灰度图上转换，图像本身在得到阈值后才被替换为掩码
+void BinaryProcessor::makeBinary(AutoThresholdMethod method) {
+	unpack();
 	if (image_mat.empty()) {
 		std::cerr << "Error: Image is empty." << std::endl;
 		return;
 	}
 
-	// Convert image to grayscale if not already
-	if (image_mat.channels() > 1) {
-		cv::cvtColor(image_mat, image_mat, cv::COLOR_BGR2GRAY);
+	cv::Mat gray = thresholdSource(image_mat);
+	HistogramResult histogram = thresholdHistogram(gray);
+	const int bin = autoThreshold(histogram.counts[0], method);
+	if (bin < 0) {
+		std::cerr << "Error: Method '" << thresholdMethodName(method) << "' found no threshold." << std::endl;
+		return;
 	}
 
-	// Compute histogram
-	int histSize = 256;
-	float range[] = { 0, 256 };
-	const float* histRange = { range };
-	cv::Mat hist;
-	cv::calcHist(&image_mat, 1, 0, cv::Mat(), hist, 1, &histSize, &histRange);
-
-	// Initial threshold estimate: mean pixel value
-	double sum = 0, sumForeground = 0, sumBackground = 0;
-	int countForeground = 0, countBackground = 0;
-	double threshold = cv::mean(image_mat)[0];
-	double newThreshold = 0;
-
-	// Iterative threshold calculation
-	for (int iter = 0; iter < options.iterations; ++iter) {
-		sumForeground = sumBackground = 0;
-		countForeground = countBackground = 0;
-
-		for (int i = 0; i < 256; ++i) {
-			if (i <= threshold) {
-				sumBackground += i * hist.at<float>(i);
-				countBackground += hist.at<float>(i);
-			}
-			else {
-				sumForeground += i * hist.at<float>(i);
-				countForeground += hist.at<float>(i);
-			}
-		}
+	cv::Mat mask;
+	kernelThreshold(gray, mask, thresholdLevel(histogram, bin, gray.depth()), 255, options.black_background);
+	if (mask.depth() != CV_8U) {
+		mask.convertTo(mask, CV_8U);
+	}
+	image_mat = mask;
+	pack();
+}
 
-		double meanBackground = (countBackground > 0) ? sumBackground / countBackground : 0;
-		double meanForeground = (countForeground > 0) ? sumForeground / countForeground : 0;
-		newThreshold = (meanBackground + meanForeground) / 2.0;
+std::vector<double> BinaryProcessor::autoThresholds() const {
+	std::vector<double> thresholds(kThresholdMethodCount, std::numeric_limits<double>::quiet_NaN());
+	const cv::Mat source = (image_mat.empty() && packed && !packed->empty()) ? packed->toMat() : image_mat;
+	if (source.empty()) {
+		return thresholds;
+	}
+	// 一次像素遍历，所有方法共用同一份直方图
+	cv::Mat gray = thresholdSource(source);
+	HistogramResult histogram = thresholdHistogram(gray);
+	for (int i = 0; i < kThresholdMethodCount; ++i) {
+		const int bin = autoThreshold(histogram.counts[0], static_cast<AutoThresholdMethod>(i));
+		if (bin >= 0) {
+			thresholds[i] = thresholdLevel(histogram, bin, gray.depth());
+		}
+	}
+	return thresholds;
+}
 
-		if (std::abs(newThreshold - threshold) < 0.01) break;
-		threshold = newThreshold;
 
-		std::cout << "Threshold: " << threshold << ", Mean Background: " << meanBackground
-			<< ", Mean Foreground: " << meanForeground << std::endl;
+void BinaryProcessor::convertToMask() {
+	unpack();
+	if (image_mat.empty()) {
+		std::cerr << "Error: Image is empty." << std::endl;
+		return;
 	}
 
-	// Apply threshold
-	int thresholdType = options.black_background ? cv::THRESH_BINARY_INV : cv::THRESH_BINARY;
-	cv::threshold(image_mat, image_mat, threshold, 255, thresholdType);
+	// Determine threshold: the mean of the gray image is a linear mix of the channel means,
+	// so no intermediate gray image is needed
+	cv::Scalar channel_mean = cv::mean(image_mat);
+	double threshold = (image_mat.channels() > 1)
+		? 0.114 * channel_mean[0] + 0.587 * channel_mean[1] + 0.299 * channel_mean[2]
+		: channel_mean[0];
 
-	// Apply optional erosion
-	/*if (options.count > 1) {
-		int kernelSize = options.count * 2 - 1;
-		cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(kernelSize, kernelSize));
-		cv::erode(image_mat, image_mat, kernel);
-	}*/
+	// Gray conversion, threshold and inverted LUT (black = 255, white = 0) in a single fused pass
+	PointwisePipeline pipeline;
+	if (image_mat.channels() > 1) {
+		pipeline.addToGray();
+	}
+	pipeline.addThreshold(threshold, 255, !options.black_background);
+	pipeline.addInvert(255);
+	pipeline.apply(image_mat, image_mat);
+	pack();
 }
 
 
-void BinaryProcessor::convertToMask() {
+void BinaryProcessor::localThreshold(LocalThresholdMethod method, float radius, double k, double r) {
+	unpack();
 	if (image_mat.empty()) {
 		std::cerr << "Error: Image is empty." << std::endl;
 		return;
 	}
 
-	// Convert image to grayscale if not already
 	if (image_mat.channels() > 1) {
 		cv::cvtColor(image_mat, image_mat, cv::COLOR_BGR2GRAY);
 	}
 
-	// Determine threshold
-	double threshold = cv::mean(image_mat)[0];
-	int thresholdType = options.black_background ? cv::THRESH_BINARY : cv::THRESH_BINARY_INV;
-
-	// Apply threshold
-	cv::threshold(image_mat, image_mat, threshold, 255, thresholdType);
-
-	// Convert mask to inverted LUT (black = 255, white = 0)
-	image_mat = 255 - image_mat;
+	// 按半径分块执行：每块只为自身及 halo 建积分图与统计量，额外内存与块大小成正比
+	const int r_px = static_cast<int>(radius);
+	const double range = (r > 0) ? r : sauvolaRange(image_mat.depth());
+	// 与 makeBinary 一致：black_background 时高于阈值的像素为 0
+	const uchar above = options.black_background ? 0 : 255;
+	const uchar below = 255 - above;
+	TileExecutor::run(image_mat, r_px, [=](const cv::Mat& in, cv::Mat& out) {
+		cv::Mat local_mean, local_stddev, values;
+		LocalStatistics(in).meanStdDev(local_mean, local_stddev, r_px);
+		in.convertTo(values, CV_32F);
+		out.create(in.size(), CV_8UC1);
+		cv::parallel_for_(cv::Range(0, out.rows), [&](const cv::Range& rows) {
+			for (int y = rows.start; y < rows.end; ++y) {
+				const float* v = values.ptr<float>(y);
+				const float* m = local_mean.ptr<float>(y);
+				const float* s = local_stddev.ptr<float>(y);
+				uchar* o = out.ptr<uchar>(y);
+				for (int x = 0; x < out.cols; ++x) {
+					double threshold = (method == kNiblack)
+						? m[x] + k * s[x]
+						: m[x] * (1 + k * (s[x] / range - 1));
+					o[x] = v[x] > threshold ? above : below;
+				}
+			}
+		});
+	}, CV_8UC1);
+	pack();
 }
 
 
+// 每次迭代向外影响 1 像素，按迭代次数确定 halo 后分块执行；
+// count 为 1 时 iterations 次迭代合并为一次分解后的大结构元，否则按 ImageJ 的 count 语义逐次迭代；
+// 方形结构元且 count 为 1 时直接在打包的位掩码上运算，连续的形态学命令之间不再解包
 void BinaryProcessor::erode() {
-	cv::erode(image_mat, image_mat, cv::Mat(), cv::Point(-1, -1), options.iterations);
+	if (usePacked()) {
+		packed->erode(options.iterations, options.pad_edges_when_eroding);
+		return;
+	}
+	ensureBinary();
+	const BinaryOptions o = options;
+	TileExecutor::run(image_mat, o.iterations, [=](const cv::Mat& in, cv::Mat& out) {
+		binaryErode(in, out, o.iterations, o.count, o.element, o.pad_edges_when_eroding);
+	});
+	pack();
 }
 
 void BinaryProcessor::dilate() {
-	cv::dilate(image_mat, image_mat, cv::Mat(), cv::Point(-1, -1), options.iterations);
+	if (usePacked()) {
+		packed->dilate(options.iterations);
+		return;
+	}
+	ensureBinary();
+	const BinaryOptions o = options;
+	TileExecutor::run(image_mat, o.iterations, [=](const cv::Mat& in, cv::Mat& out) {
+		binaryDilate(in, out, o.iterations, o.count, o.element);
+	});
+	pack();
 }
 
 void BinaryProcessor::open() {
-	cv::morphologyEx(image_mat, image_mat, cv::MORPH_OPEN, cv::Mat(), cv::Point(-1, -1), options.iterations);
+	if (usePacked()) {
+		packed->erode(options.iterations, options.pad_edges_when_eroding);
+		packed->dilate(options.iterations);
+		return;
+	}
+	ensureBinary();
+	const BinaryOptions o = options;
+	TileExecutor::run(image_mat, 2 * o.iterations, [=](const cv::Mat& in, cv::Mat& out) {
+		binaryErode(in, out, o.iterations, o.count, o.element, o.pad_edges_when_eroding);
+		binaryDilate(out, out, o.iterations, o.count, o.element);
+	});
+	pack();
 }
 
 void BinaryProcessor::close() {
-	cv::morphologyEx(image_mat, image_mat, cv::MORPH_CLOSE, cv::Mat(), cv::Point(-1, -1), options.iterations);
+	if (usePacked()) {
+		packed->dilate(options.iterations);
+		packed->erode(options.iterations, options.pad_edges_when_eroding);
+		return;
+	}
+	ensureBinary();
+	const BinaryOptions o = options;
+	TileExecutor::run(image_mat, 2 * o.iterations, [=](const cv::Mat& in, cv::Mat& out) {
+		binaryDilate(in, out, o.iterations, o.count, o.element);
+		binaryErode(out, out, o.iterations, o.count, o.element, o.pad_edges_when_eroding);
+	});
+	pack();
 }
 
+// 二值图像的中值仍为二值，打包的图像处理后重新打包
 void BinaryProcessor::median() {
-	cv::medianBlur(image_mat, image_mat, 5);
+	const bool was_packed = packed && !packed->empty();
+	unpack();
+	TileExecutor::run(image_mat, 2, [](const cv::Mat& in, cv::Mat& out) {
+		cv::medianBlur(in, out, 5);
+	});
+	if (was_packed) {
+		pack();
+	}
 }
 
 void BinaryProcessor::outline() {
+	ensureBinary();
 	cv::Mat edges;
 	cv::Canny(image_mat, edges, 100, 200);
 	image_mat = edges;
+	pack();
 }
 
+// 从图像边界的背景做形态学重建，未到达的背景即为孔洞
 void BinaryProcessor::fillHoles() {
-	cv::floodFill(image_mat, cv::Point(0, 0), cv::Scalar(255));
+	ensureBinary();
+	fillHolesMask(image_mat, image_mat);
+	pack();
 }
 
-void BinaryProcessor::skeletonize() {
-	cv::Mat skel(image_mat.size(), CV_8UC1, cv::Scalar(0));
-	cv::Mat temp;
-	cv::Mat eroded;
-	cv::Mat element = cv::getStructuringElement(cv::MORPH_CROSS, cv::Size(3, 3));
+// 去掉与图像边界相连的物体
+void BinaryProcessor::clearBorder() {
+	ensureBinary();
+	clearBorderMask(image_mat, image_mat);
+	pack();
+}
 
-	while (true) {
-		cv::erode(image_mat, eroded, element);
-		cv::dilate(eroded, temp, element);
-		cv::subtract(image_mat, temp, temp);
-		cv::bitwise_or(skel, temp, skel);
-		eroded.copyTo(image_mat);
-		if (cv::countNonZero(image_mat) == 0) break;
+// 深度不小于 h 的灰度极大值，结果为 0 / 255 掩码
+void BinaryProcessor::hMaxima(double h) {
+	unpack();
+	if (image_mat.empty()) {
+		std::cerr << "Error: Image is empty." << std::endl;
+		return;
+	}
+	if (image_mat.channels() > 1) {
+		cv::cvtColor(image_mat, image_mat, cv::COLOR_BGR2GRAY);
+	}
+	if (image_mat.depth() != CV_8U && image_mat.depth() != CV_16U && image_mat.depth() != CV_32F) {
+		image_mat.convertTo(image_mat, CV_32F);
 	}
-	image_mat = skel;
+	::hMaxima(image_mat, h, image_mat);
+	pack();
+}
+
+// 查找表细化：首轮并行扫描，之后只处理边界点，保持拓扑，结果为单像素宽
+void BinaryProcessor::skeletonize() {
+	ensureBinary();
+	thinBinary(image_mat, image_mat);
+	pack();
 }
 
+// 精确 EDM，输出类型由 edm_output 决定
 void BinaryProcessor::distanceMap() {
-	cv::distanceTransform(image_mat, image_mat, cv::DIST_L2, 5);
-	cv::normalize(image_mat, image_mat, 0, 1.0, cv::NORM_MINMAX);
+	ensureBinary();
+	cv::Mat edm;
+	euclideanDistanceMap(image_mat, edm);
+	image_mat = convertEdm(edm, options.edm_output);
 }
 
+// EDM 的极大值（容差 0.5 像素，与 ImageJ 一致）；kOverwrite 输出 0 / 255 掩码，其他输出为各点的 EDM 值
 void BinaryProcessor::ultimatePoints() {
-	cv::Mat dist;
-	cv::distanceTransform(image_mat, dist, cv::DIST_L2, 5);
-	cv::normalize(dist, dist, 0, 1.0, cv::NORM_MINMAX);
-	cv::threshold(dist, image_mat, 0.5, 1.0, cv::THRESH_BINARY);
+	ensureBinary();
+	cv::Mat edm, points;
+	euclideanDistanceMap(image_mat, edm);
+	::hMaxima(edm, 0.5, points);
+	cv::bitwise_and(points, image_mat, points);
+	if (options.edm_output == kOverwrite) {
+		image_mat = points;
+		pack();
+		return;
+	}
+	cv::Mat values = cv::Mat::zeros(edm.size(), CV_32FC1);
+	edm.copyTo(values, points);
+	image_mat = convertEdm(values, options.edm_output);
 }
 
+// EDM 分水岭：从 EDM 极大值出发桶队列淹没，用 1 像素分界线切开粘连的颗粒
 void BinaryProcessor::watershed() {
-	cv::Mat markers;
-	cv::watershed(image_mat, markers);
-	image_mat = markers;
+	ensureBinary();
+	watershedSeparate(image_mat, image_mat);
+	pack();
 }
 
+// 背景像素按最近颗粒划分，归属不同颗粒的相邻像素之间为分界线；
+// kOverwrite 输出 0 / 255 掩码，其他输出为分界线上到颗粒的距离
 void BinaryProcessor::voronoi() {
-	cv::Mat dist;
-	cv::distanceTransform(image_mat, dist, cv::DIST_L2, 5);
-	cv::threshold(dist, dist, 0.5, 1.0, cv::THRESH_BINARY);
-	cv::normalize(dist, image_mat, 0, 255, cv::NORM_MINMAX, CV_8U);
-}
\ No newline at end of file
+	ensureBinary();
+	cv::Mat background, distance, nearest, labels;
+	cv::compare(image_mat, 0, background, cv::CMP_EQ);
+	euclideanDistanceMap(background, distance, &nearest);
+	cv::connectedComponents(image_mat, labels, 8, CV_32S);
+
+	// 每个像素所属的颗粒（最近颗粒像素的标签）
+	cv::Mat owner(image_mat.size(), CV_32SC1);
+	const int* label_data = labels.ptr<int>();
+	cv::parallel_for_(cv::Range(0, owner.rows), [&](const cv::Range& range) {
+		for (int y = range.start; y < range.end; ++y) {
+			const int* n = nearest.ptr<int>(y);
+			int* o = owner.ptr<int>(y);
+			for (int x = 0; x < owner.cols; ++x) {
+				o[x] = (n[x] >= 0) ? label_data[n[x]] : 0;
+			}
+		}
+	});
+
+	cv::Mat lines(image_mat.size(), CV_8UC1, cv::Scalar(0));
+	cv::parallel_for_(cv::Range(0, owner.rows), [&](const cv::Range& range) {
+		for (int y = range.start; y < range.end; ++y) {
+			const uchar* b = background.ptr<uchar>(y);
+			const int* o = owner.ptr<int>(y);
+			const int* below = (y + 1 < owner.rows) ? owner.ptr<int>(y + 1) : nullptr;
+			uchar* l = lines.ptr<uchar>(y);
+			for (int x = 0; x < owner.cols; ++x) {
+				if (!b[x]) continue;
+				if ((x + 1 < owner.cols && o[x + 1] != o[x]) || (below && below[x] != o[x])) {
+					l[x] = 255;
+				}
+			}
+		}
+	});
+
+	if (options.edm_output == kOverwrite) {
+		image_mat = lines;
+		pack();
+		return;
+	}
+	cv::Mat values = cv::Mat::zeros(distance.size(), CV_32FC1);
+	distance.copyTo(values, lines);
+	image_mat = convertEdm(values, options.edm_output);
+}
@@ -5,6 +5,10 @@
 #define BINARY_PROCESSOR_H
 
 #include <opencv2/opencv.hpp>
+#include "Morphology.h"
+#include "AutoThreshold.h"
+#include "BitMask.h"
+#include <vector>
 
 enum EdmOutput {
 	kOverwrite,
@@ -13,34 +17,54 @@ enum EdmOutput {
 	k32Bit
 };
 
+enum LocalThresholdMethod {
+	kNiblack,
+	kSauvola
+};
+
 struct BinaryOptions {
 	int iterations = 1; // 1-100
 	int count = 1; // 1-8
 	bool black_background = true;
 	bool pad_edges_when_eroding = false;
 	EdmOutput edm_output = kOverwrite;
+	StructuringElement element = kElementSquare; // count 为 1 时 iterations 次迭代对应的结构元
 };
 
 class BinaryProcessor {
 private:
 	cv::Mat& image_mat;
+	BitMask* packed;     // 结果为 0 / 255 掩码时打包存放于此并释放 image_mat；为空指针时不打包
 	BinaryOptions options;
+
+	void ensureBinary(); // 非 CV_8UC1 图像转换为二值掩码
+	void unpack();       // 打包的图像解包回 image_mat
+	void pack();         // image_mat（0 / 255 掩码）打包并释放
+	bool usePacked();    // 方形结构元、count 为 1 时直接在打包数据上做形态学运算（必要时先打包）
 public:
-	BinaryProcessor(cv::Mat& img);
+	// packed 为图像的打包存储（见 MyImage）；选区等临时区域上的处理器不传入，结果保持为 cv::Mat
+	BinaryProcessor(cv::Mat& img, BitMask* packed = nullptr);
 	void setOptions(const BinaryOptions& options);
+	const BinaryOptions& getOptions() const;
 
 	// binary 的一系列功能
-	void makeBinary(); // 二值化
+	void makeBinary(AutoThresholdMethod method = kThresholdDefault); // 全局自动阈值二值化
+	std::vector<double> autoThresholds() const; // 各方法的阈值（按 AutoThresholdMethod 顺序，失败为 NaN），不修改图像
 	void convertToMask(); // 转换为 mask
+	// 局部阈值；Niblack: mean + k * std，Sauvola: mean * (1 + k * (std / r - 1))；
+	// r 不大于 0 时按位深取值（8 位 128，16 位 32768，浮点 0.5）
+	void localThreshold(LocalThresholdMethod method, float radius, double k, double r = 0);
 
-	void erode(); // 膨胀
-	void dilate(); // 腐蚀
+	void erode(); // 腐蚀
+	void dilate(); // 膨胀
 	void open(); // 开运算，先腐蚀再膨胀
 	void close(); // 闭运算，先膨胀再腐蚀
 	void median();
 
 	void outline(); // 提取边缘
 	void fillHoles(); // 填洞
+	void clearBorder(); // 去除与边界相连的物体
+	void hMaxima(double h); // 深度不小于 h 的极大值
 	void skeletonize(); // 骨架化
 
 	void distanceMap(); // 欧氏距离映射EDM
@@ -0,0 +1,271 @@
+﻿/// ----------------------- BitMask -----------------------
+///
+/// 说明：按 64 位字存储的二值掩码，见 BitMask.h。
+///
+/// ----------------------- BitMask -----------------------
+
+#include "BitMask.h"
+
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+	const uint64_t kAllOnes = ~uint64_t(0);
+
+	inline int popcount64(uint64_t v) {
+#ifdef _MSC_VER
+		return static_cast<int>(__popcnt64(v));
+#else
+		return __builtin_popcountll(v);
+#endif
+	}
+
+	// 每行最后一个字中属于图像的位
+	inline uint64_t tailMask(int cols) {
+		const int bits = cols % 64;
+		return bits ? (uint64_t(1) << bits) - 1 : kAllOnes;
+	}
+
+	// out 的第 x 位取 in 的第 x + k 位；超出 [0, 64 * n) 的位取 fill
+	void shiftBits(const uint64_t* in, uint64_t* out, int n, int k, uint64_t fill) {
+		if (k >= 0) {
+			const int q = k / 64;
+			const int b = k % 64;
+			for (int w = 0; w < n; ++w) {
+				const uint64_t lo = (w + q < n) ? in[w + q] : fill;
+				const uint64_t hi = (w + q + 1 < n) ? in[w + q + 1] : fill;
+				out[w] = b ? (lo >> b) | (hi << (64 - b)) : lo;
+			}
+		}
+		else {
+			const int q = -k / 64;
+			const int b = -k % 64;
+			for (int w = 0; w < n; ++w) {
+				const uint64_t hi = (w - q >= 0) ? in[w - q] : fill;
+				const uint64_t lo = (w - q - 1 >= 0) ? in[w - q - 1] : fill;
+				out[w] = b ? (hi << b) | (lo >> (64 - b)) : hi;
+			}
+		}
+	}
+
+	template <bool IsAnd>
+	inline void combine(uint64_t* a, const uint64_t* b, int n) {
+		for (int w = 0; w < n; ++w) {
+			a[w] = IsAnd ? (a[w] & b[w]) : (a[w] | b[w]);
+		}
+	}
+
+	// 窗口长度 window 的一维极值（AND 为腐蚀，OR 为膨胀）：
+	// buffer 的第 x 位变为 buffer[x .. x + window - 1] 的运算结果，倍增法 O(log window) 次平移
+	template <bool IsAnd>
+	void widenWindow(std::vector<uint64_t>& buffer, std::vector<uint64_t>& scratch, int window, uint64_t fill) {
+		const int n = static_cast<int>(buffer.size());
+		int size = 1;
+		while (2 * size <= window) {
+			shiftBits(buffer.data(), scratch.data(), n, size, fill);
+			combine<IsAnd>(buffer.data(), scratch.data(), n);
+			size *= 2;
+		}
+		if (size < window) {
+			shiftBits(buffer.data(), scratch.data(), n, window - size, fill);
+			combine<IsAnd>(buffer.data(), scratch.data(), n);
+		}
+	}
+
+}
+
+
+BitMask::BitMask(int rows, int cols)
+	: rows(rows), cols(cols), words_per_row((cols + 63) / 64), words(static_cast<size_t>(rows) * ((cols + 63) / 64), 0) {}
+
+void BitMask::clearTail() {
+	if (cols % 64 == 0) {
+		return;
+	}
+	const uint64_t tail = tailMask(cols);
+	for (int y = 0; y < rows; ++y) {
+		row(y)[words_per_row - 1] &= tail;
+	}
+}
+
+BitMask BitMask::fromMat(const cv::Mat& mask) {
+	CV_Assert(mask.type() == CV_8UC1);
+	BitMask bits(mask.rows, mask.cols);
+	cv::parallel_for_(cv::Range(0, mask.rows), [&](const cv::Range& range) {
+		for (int y = range.start; y < range.end; ++y) {
+			const uchar* m = mask.ptr<uchar>(y);
+			uint64_t* out = bits.row(y);
+			for (int w = 0; w < bits.words_per_row; ++w) {
+				const int x0 = w * 64;
+				const int x1 = std::min(x0 + 64, mask.cols);
+				uint64_t word = 0;
+				for (int x = x0; x < x1; ++x) {
+					word |= uint64_t(m[x] != 0) << (x - x0);
+				}
+				out[w] = word;
+			}
+		}
+	});
+	return bits;
+}
+
+cv::Mat BitMask::toMat() const {
+	cv::Mat mask(rows, cols, CV_8UC1);
+	cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+		for (int y = range.start; y < range.end; ++y) {
+			const uint64_t* in = row(y);
+			uchar* m = mask.ptr<uchar>(y);
+			for (int x = 0; x < cols; ++x) {
+				m[x] = ((in[x >> 6] >> (x & 63)) & 1) ? 255 : 0;
+			}
+		}
+	});
+	return mask;
+}
+
+int BitMask::getRows() const {
+	return rows;
+}
+
+int BitMask::getCols() const {
+	return cols;
+}
+
+int BitMask::getWordsPerRow() const {
+	return words_per_row;
+}
+
+bool BitMask::empty() const {
+	return rows == 0 || cols == 0;
+}
+
+size_t BitMask::byteSize() const {
+	return words.size() * sizeof(uint64_t);
+}
+
+uint64_t* BitMask::row(int y) {
+	return words.data() + static_cast<size_t>(y) * words_per_row;
+}
+
+const uint64_t* BitMask::row(int y) const {
+	return words.data() + static_cast<size_t>(y) * words_per_row;
+}
+
+bool BitMask::get(int x, int y) const {
+	return (row(y)[x >> 6] >> (x & 63)) & 1;
+}
+
+void BitMask::set(int x, int y, bool value) {
+	uint64_t& word = row(y)[x >> 6];
+	const uint64_t bit = uint64_t(1) << (x & 63);
+	word = value ? (word | bit) : (word & ~bit);
+}
+
+BitMask& BitMask::operator&=(const BitMask& other) {
+	CV_Assert(rows == other.rows && cols == other.cols);
+	for (size_t i = 0; i < words.size(); ++i) words[i] &= other.words[i];
+	return *this;
+}
+
+BitMask& BitMask::operator|=(const BitMask& other) {
+	CV_Assert(rows == other.rows && cols == other.cols);
+	for (size_t i = 0; i < words.size(); ++i) words[i] |= other.words[i];
+	return *this;
+}
+
+BitMask& BitMask::operator^=(const BitMask& other) {
+	CV_Assert(rows == other.rows && cols == other.cols);
+	for (size_t i = 0; i < words.size(); ++i) words[i] ^= other.words[i];
+	return *this;
+}
+
+void BitMask::invert() {
+	for (uint64_t& word : words) word = ~word;
+	clearTail();
+}
+
+size_t BitMask::count() const {
+	size_t total = 0;
+	for (uint64_t word : words) total += popcount64(word);
+	return total;
+}
+
+BitMask BitMask::shifted(int dx, int dy) const {
+	BitMask result(rows, cols);
+	for (int y = 0; y < rows; ++y) {
+		const int source = y - dy;
+		if (source < 0 || source >= rows) continue;
+		shiftBits(row(source), result.row(y), words_per_row, -dx, 0);
+	}
+	result.clearTail();
+	return result;
+}
+
+void BitMask::erode(int radius, bool pad_edges) {
+	if (radius <= 0 || empty()) {
+		return;
+	}
+	const uint64_t fill = pad_edges ? kAllOnes : 0;
+	const int window = 2 * radius + 1;
+	const uint64_t tail = tailMask(cols);
+
+	// 水平：每行放入左右各扩展 radius 位的缓冲区（扩展部分与行尾多余位取 fill），再扩展窗口
+	const int extended_words = (cols + 2 * radius + 63) / 64;
+	cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+		std::vector<uint64_t> source(extended_words, fill), buffer(extended_words), scratch(extended_words);
+		for (int y = range.start; y < range.end; ++y) {
+			uint64_t* r = row(y);
+			std::copy(r, r + words_per_row, source.begin());
+			source[words_per_row - 1] = (r[words_per_row - 1] & tail) | (fill & ~tail);
+			std::fill(source.begin() + words_per_row, source.end(), fill);
+			shiftBits(source.data(), buffer.data(), extended_words, -radius, fill);
+			widenWindow<true>(buffer, scratch, window, fill);
+			std::copy(buffer.begin(), buffer.begin() + words_per_row, r);
+		}
+	});
+
+	// 垂直：上下各扩展 radius 行，行间同样倍增，两个缓冲区交替
+	const int extended_rows = rows + 2 * radius;
+	std::vector<uint64_t> current(static_cast<size_t>(extended_rows) * words_per_row, fill);
+	std::vector<uint64_t> next(current.size());
+	std::copy(words.begin(), words.end(), current.begin() + static_cast<size_t>(radius) * words_per_row);
+	auto step = [&](int offset) {
+		cv::parallel_for_(cv::Range(0, extended_rows), [&](const cv::Range& range) {
+			for (int y = range.start; y < range.end; ++y) {
+				const uint64_t* a = current.data() + static_cast<size_t>(y) * words_per_row;
+				uint64_t* out = next.data() + static_cast<size_t>(y) * words_per_row;
+				if (y + offset < extended_rows) {
+					const uint64_t* b = a + static_cast<size_t>(offset) * words_per_row;
+					for (int w = 0; w < words_per_row; ++w) out[w] = a[w] & b[w];
+				}
+				else {
+					for (int w = 0; w < words_per_row; ++w) out[w] = a[w] & fill;
+				}
+			}
+		});
+		current.swap(next);
+	};
+	int size = 1;
+	while (2 * size <= window) {
+		step(size);
+		size *= 2;
+	}
+	if (size < window) {
+		step(window - size);
+	}
+	std::copy(current.begin(), current.begin() + words.size(), words.begin());
+	clearTail();
+}
+
+void BitMask::dilate(int radius) {
+	if (radius <= 0 || empty()) {
+		return;
+	}
+	// 膨胀是背景的腐蚀：图像外的背景在取反后成为前景，对应 pad_edges
+	invert();
+	erode(radius, true);
+	invert();
+}
@@ -0,0 +1,71 @@
+﻿/// ----------------------- BitMask -----------------------
+///
+/// 说明：每像素 1 位的二值掩码，内存为 0 / 255 的 CV_8UC1 掩码的 1/8；
+///      每行按 64 位字存储，第 x 列为第 x / 64 个字的第 x % 64 位（低位在左），行尾多余的位始终为 0。
+///
+///      逻辑运算、计数与平移都按字进行，一次处理 64 个像素；
+///      内层循环是对连续 uint64_t 数组的简单按位运算，编译器可以自动向量化。
+///
+///      方形结构元的腐蚀 / 膨胀（半径 r，即 3x3 核迭代 r 次）分解为水平与垂直两遍：
+///      每遍用倍增法把窗口从 1 扩展到 2r + 1，每次只需一次平移与一次按位运算，
+///      每 64 像素的开销为 O(log r)。
+///
+///      已知为二值的图像（binary 命令的结果，见 BinaryProcessor）与 Workspace 的 binary_mask 以 BitMask 保存，
+///      只在需要 cv::Mat 时解包；连续的方形腐蚀 / 膨胀 / 开 / 闭运算直接在打包的数据上进行。
+///
+/// ----------------------- BitMask -----------------------
+
+#pragma once
+#ifndef BIT_MASK_H
+#define BIT_MASK_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+class BitMask {
+private:
+	int rows = 0;
+	int cols = 0;
+	int words_per_row = 0;
+	std::vector<uint64_t> words;
+
+	void clearTail();   // 清除每行 cols 之后的位
+
+public:
+	BitMask() = default;
+	BitMask(int rows, int cols);   // 全 0
+
+	// CV_8UC1，非零为 1
+	static BitMask fromMat(const cv::Mat& mask);
+	// 0 / 255 的 CV_8UC1
+	cv::Mat toMat() const;
+
+	int getRows() const;
+	int getCols() const;
+	int getWordsPerRow() const;
+	bool empty() const;
+	size_t byteSize() const;
+
+	uint64_t* row(int y);
+	const uint64_t* row(int y) const;
+	bool get(int x, int y) const;
+	void set(int x, int y, bool value);
+
+	// 逐字逻辑运算，两个掩码尺寸须相同
+	BitMask& operator&=(const BitMask& other);
+	BitMask& operator|=(const BitMask& other);
+	BitMask& operator^=(const BitMask& other);
+	void invert();
+
+	size_t count() const;   // 为 1 的像素数
+
+	// 平移：结果 (x, y) 取原掩码 (x - dx, y - dy)，移入的像素为 0
+	BitMask shifted(int dx, int dy) const;
+
+	// 方形结构元，半径 radius；腐蚀时 pad_edges 为 true 视图像外为前景，否则为背景
+	void erode(int radius, bool pad_edges);
+	void dilate(int radius);
+};
+
+#endif // BIT_MASK_H
@@ -1,4 +1,13 @@
 ﻿#include "CommandHandler.h"
+#include "Benchmark.h"
+#include "TileExecutor.h"
+#include "RankFilters.h"
+#include "KernelConvolution.h"
+#include "PixelKernels.h"
+#include "Selection.h"
+#include "TilePyramid.h"
+#include "ParticleAnalyzer.h"
+#include "Measurements.h"
 
 #include <filesystem>
 #include <fstream>
@@ -8,6 +17,10 @@
 #include <string>
 #include <memory>
 #include <map>
+#include <set>
+#include <cmath>
+#include <atomic>
+#include <nlohmann/json.hpp>
 
 void CommandHandler::handleCommand(const std::string& command, const std::vector<std::string>& args) {
 	if (command == "help") {
@@ -25,11 +38,20 @@ void CommandHandler::handleCommand(const std::string& command, const std::vector
 	else if (command == "batch") {
 		commandBatchModelProcessing(args);
 	}
+	else if (command == "bench") {
+		commandBenchmark(args);
+	}
+	else if (command == "tiles") {
+		commandTiles(args);
+	}
+	else if (command == "stack") {
+		commandStack(args);
+	}
 	else if (!workspace) {
-		std::cout << "Error: No image loaded. Use 'load <image_path>' first.\n";
+		out << "Error: No image loaded. Use 'load <image_path>' first.\n";
 	}
 	else if (command == "export") {
-		commandExport();
+		commandExport(args);
 	}
 	else if (command == "show") {
 		commandShow();
@@ -64,28 +86,55 @@ void CommandHandler::handleCommand(const std::string& command, const std::vector
 	else if (command == "binary") {
 		commandBinary(args);
 	}
+	else if (command == "set_binary_options") {
+		commandSetBinaryOptions(args);
+	}
 	else if (command == "filter") {
 		commandFilter(args);
 	}
+	else if (command == "histogram") {
+		commandHistogram(args);
+	}
+	else if (command == "profile") {
+		commandProfile(args);
+	}
+	else if (command == "select") {
+		commandSelect(args);
+	}
+	else if (command == "analyze_particles") {
+		commandAnalyzeParticles(args);
+	}
+	else if (command == "measure") {
+		commandMeasure(args);
+	}
+	else if (command == "polygonize") {
+		commandPolygonize(args);
+	}
 	else if (command == "quit") {
-		std::cout << "Exiting the program..." << std::endl;
+		out << "Exiting the program..." << std::endl;
 		exit(0);
 	}
 	else {
-		std::cout << "Unknown command: " << command << std::endl;
+		out << "Unknown command: " << command << std::endl;
 	}
 }
 
 void CommandHandler::commandHelp() const {
-	std::cout << "Available commands:\n"
+	out << "Available commands:\n"
 		<< "  help                          - Display this help message\n"
 		<< "  echo <arg>                    - Echo the argument back to you\n"
 		<< "  load <path/to/image>          - Load an image file\n"
+		<< "  load <path/to/image> unchanged - Keep the file's bit depth and channels (memory-maps uncompressed TIFF/BMP)\n"
+		<< "  load <path.raw> <width> <height> [8u|16u|32f] [channels] [offset] - Memory-map a raw frame\n"
 		<< "  unload                        - Unload the current image\n"
 		<< "  export                        - Export the image as binary stream\n"
+		<< "  export pyramid <dir> [tile=256] - Export a Deep Zoom tile pyramid of the image and mask;\n"
+		<< "                                  only tiles whose content changed are rewritten\n"
 		<< "  show                          - Show image (For testing purpose)"
-		<< "  model <path/to/model>         - Use model to generate a JSON annotation file\n"
-		<< "  batch <path/to/model>         - Use model to batch generate...\n"
+		<< "  model <path/to/model> [polygons [tolerance]] - Use model to generate a JSON annotation file;\n"
+		<< "                                  'polygons' stores each instance as a simplified outline polygon\n"
+		<< "  batch <path/to/model> [polygons [tolerance]] - Use model to batch generate... (every page of an open stack)\n"
+		<< "  polygonize [tolerance]        - Turn shapes with an instance mask into simplified polygons (default 1 px)\n"
 		<< "  label list					- list all labels\n"
 		<< "  label add SEC 0 x0 y0 x1 y1   - add an SEC rectangle label\n"
 		<< "  crop <x> <y> <width> <height> - Crop the image\n"
@@ -97,65 +146,150 @@ void CommandHandler::commandHelp() const {
 		<< "  translate <x_offset> <y_offset>   - Translate the image\n"
 		<< "  type 8bit_gray|16bit_gray|32bit_gray  - Convert color depth\n"
 		<< "       |8bit_color|rgb_color\n"
-		<< "  set_brightness_contrast       - Set minimum, maximum, brightness and contrast values."
+		<< "  set_brightness_contrast       - Set display range (minimum, maximum, brightness, contrast). Pixel data is not modified."
 		<< "        [brightness <-127~127>]\n"
 		<< "        [contrast <default=1.0>]\n"
-		<< "        [minimum <0~255>]\n"
-		<< "        [maximum <0~255>]\n"
+		<< "        [min <0~255|0~65535>]\n"
+		<< "        [max <0~255|0~65535>]\n"
+		<< "  set_brightness_contrast reset - Clear the display range\n"
 		<< "  binary                        - Binary\n"
+		<< "  binary make [method]          - Global auto threshold: default|huang|intermodes|isodata|li|max_entropy|mean|min_error|\n"
+		<< "        minimum|moments|otsu|percentile|renyi_entropy|shanbhag|triangle|yen\n"
+		<< "  binary thresholds             - Print the threshold of every method from one histogram\n"
+		<< "  binary local niblack|sauvola [radius] [k] [r] - Local-statistics threshold\n"
+		<< "  set_binary_options [iterations <1-100>] [count <1-8>] [black_background on|off] [pad_edges on|off]\n"
+		<< "        [edm overwrite|8bit|16bit|32bit] [element square|disc|diamond] - Options for binary commands\n"
+		<< "  binary fill_holes|clear_border - Fill enclosed holes / remove objects touching the image edge\n"
+		<< "  binary ultimate_points        - Regional maxima of the distance map\n"
+		<< "  binary h_maxima <h>           - Maxima at least <h> above their surroundings, as a mask\n"
 		<< "  filter                        - Filter\n"
+		<< "  filter median|minimum|maximum [radius] [square|circular] - Rank filters, any radius\n"
+		<< "  filter gaussian [sigma] / filter unsharp [sigma] [weight] - Recursive Gaussian, cost independent of sigma\n"
+		<< "  filter tophat <radius> [light|dark] [fast|exact]       - Background subtraction\n"
+		<< "  filter convolve <a b c ; d e f ; ...> [normalize]        - Convolve with a kernel, rows separated by ';'\n"
+		<< "  histogram [bins <n>] [min <v>] [max <v>] [roi <x> <y> <w> <h>] [mask] [json|csv]\n"
+		<< "                                - Per-channel histogram (8U/16U/32F), machine-readable output\n"
+		<< "  profile line <x0> <y0> <x1> <y1> [...] [width <w>] - Intensity profile along a polyline\n"
+		<< "  profile shape <index> [width <w>]                  - Profile along a shape (closed for polygons, column average for rectangles)\n"
+		<< "  profile shape <index> mask                         - Values under the instance mask of a shape\n"
+		<< "  profile mask                                       - Values under the binary mask\n"
+		<< "  select rect <x> <y> <w> <h>   - Restrict filter/binary/type/set_brightness_contrast to a rectangle\n"
+		<< "  select polygon <x0> <y0> <x1> <y1> <x2> <y2> [...] - Restrict to a polygon\n"
+		<< "  select shape <index>          - Restrict to a shape (its instance mask when present)\n"
+		<< "  select [none]                 - Show / clear the selection\n"
+		<< "  analyze_particles [size <min> <max>] [circularity <min> <max>] [exclude_edges] [4] [mask] [list]\n"
+		<< "                                - Label connected components (the image, or the binary mask with 'mask')\n"
+		<< "                                  and add the particles that pass the filters as mask shapes\n"
+		<< "  measure [csv|json] [out <path>] - Area, intensity, centroid, perimeter and Feret diameters of every shape\n"
+		<< "  stack open <path.tiff> [cache <n>] - Open a multi-page TIFF; pages are read on demand\n"
+		<< "  stack info|close              - Show / close the open stack\n"
+		<< "  stack frame <index>           - Load one page as the current image\n"
+		<< "  stack apply <command> [args...] - Run crop|scale|flip|rotate|translate|type|binary|filter on every page\n"
+		<< "                                  in parallel; pages are written to <name>_frames/\n"
+		<< "  bench <name> [args...]        - Run a performance benchmark on synthetic images\n"
+		<< "  tiles [<size>|off] [threads <n>] - Tile size and thread count for neighbourhood filters\n"
 		<< "  quit                          - Exit the program\n";
 }
 
 void CommandHandler::commandEcho(const std::vector<std::string>& args) {
 	if (args.empty()) {
-		std::cout << "Error: 'echo' requires an argument.\n";
+		out << "Error: 'echo' requires an argument.\n";
 	}
 	else {
-		std::cout << args[0] << std::endl;
+		out << args[0] << std::endl;
 	}
 }
 
 void CommandHandler::commandLoad(const std::vector<std::string>& args) {
 	if (args.empty() || args[0].empty()) {
-		std::cout << "Error: 'load' requires a valid image path.\n";
+		out << "Error: 'load' requires a valid image path.\n";
 		return;
 	}
 
 	const std::string& path = args[0];
 	if (!std::filesystem::exists(path)) {
-		std::cout << "Error: Path '" << path << "' does not exist.\n";
+		out << "Error: Path '" << path << "' does not exist.\n";
 		return;
 	}
 
 	if (!std::filesystem::is_regular_file(path)) {
-		std::cout << "Error: '" << path << "' is not a valid file.\n";
+		out << "Error: '" << path << "' is not a valid file.\n";
+		return;
+	}
+
+	// load <path.raw> <width> <height> [8u|16u|32f] [channels] [offset]：无文件头的采集数据，按给定布局映射
+	if (std::filesystem::path(path).extension().string() == ".raw") {
+		if (args.size() < 3) {
+			out << "Error: Loading a .raw file requires <width> <height> [8u|16u|32f] [channels] [offset].\n";
+			return;
+		}
+		RawImageInfo raw_info;
+		int depth = CV_8U;
+		int channels = 1;
+		try {
+			raw_info.width = std::stoi(args[1]);
+			raw_info.height = std::stoi(args[2]);
+			size_t next = 3;
+			if (args.size() > next && (args[next] == "8u" || args[next] == "16u" || args[next] == "32f")) {
+				depth = (args[next] == "8u") ? CV_8U : (args[next] == "16u") ? CV_16U : CV_32F;
+				++next;
+			}
+			if (args.size() > next) channels = std::stoi(args[next++]);
+			if (args.size() > next) raw_info.offset = std::stoull(args[next++]);
+		}
+		catch (const std::exception&) {
+			out << "Error: Invalid raw layout arguments.\n";
+			return;
+		}
+		if (raw_info.width <= 0 || raw_info.height <= 0 || channels < 1 || channels > 4) {
+			out << "Error: Raw width and height must be positive and channels must be 1-4.\n";
+			return;
+		}
+		raw_info.type = CV_MAKETYPE(depth, channels);
+
+		std::unique_ptr<Workspace> loaded = std::make_unique<Workspace>(std::filesystem::u8path(path), raw_info);
+		if (loaded->getMyImage().getImageMat().empty()) {
+			out << "Error: File is smaller than the given raw layout.\n";
+			return;
+		}
+		workspace = std::move(loaded);
+		out << "Image loaded successfully: " << path << std::endl;
 		return;
 	}
 
-	static const std::set<std::string> valid_extensions = { ".jpg", ".jpeg", ".png", ".bmp", ".tiff" };
+	static const std::set<std::string> valid_extensions = { ".jpg", ".jpeg", ".png", ".bmp", ".tif", ".tiff" };
 	if (valid_extensions.count(std::filesystem::path(path).extension().string()) == 0) {
-		std::cout << "Error: Unsupported file format. Supported formats are: .jpg, .jpeg, .png, .bmp, .tiff\n";
+		out << "Error: Unsupported file format. Supported formats are: .jpg, .jpeg, .png, .bmp, .tif, .tiff, .raw\n";
 		return;
 	}
 
+	// load <path> unchanged：保留原始位深与通道数，未压缩的 TIFF / BMP 直接映射
+	bool unchanged = false;
+	if (args.size() > 1) {
+		if (args[1] != "unchanged") {
+			out << "Error: Invalid argument: " << args[1] << "\n";
+			return;
+		}
+		unchanged = true;
+	}
+
 	try {
-		workspace = std::make_unique<Workspace>(std::filesystem::u8path(path));
-		std::cout << "Image loaded successfully: " << path << std::endl;
+		workspace = std::make_unique<Workspace>(std::filesystem::u8path(path), unchanged);
+		out << "Image loaded successfully: " << path << std::endl;
 	}
 	catch (const std::exception& e) {
-		std::cout << "Error: Failed to load image. " << e.what() << "\n";
+		out << "Error: Failed to load image. " << e.what() << "\n";
 	}
 }
 
 
 void CommandHandler::commandUnload() {
 	if (!workspace) {
-		std::cout << "No image loaded.\n";
+		out << "No image loaded.\n";
 	}
 	else {
 		workspace.reset();
-		std::cout << "Image unloaded successfully.\n";
+		out << "Image unloaded successfully.\n";
 	}
 }
 
@@ -164,15 +298,63 @@ void CommandHandler::commandShow() {
 	workspace->getMyImage().show();
 }
 
-void CommandHandler::commandExport() {
-	workspace->getMyImage().exportImage();
+void CommandHandler::commandExport(const std::vector<std::string>& args) {
+	if (args.empty()) {
+		workspace->getMyImage().exportImage();
+		return;
+	}
+
+	// export pyramid <dir> [tile=256]：显示图像与标注掩码分别导出为瓦片金字塔
+	if (args[0] != "pyramid" || args.size() < 2) {
+		out << "Error: Usage: export pyramid <dir> [tile=256]\n";
+		return;
+	}
+	PyramidOptions options;
+	if (args.size() > 2) {
+		std::string value = args[2];
+		if (value.rfind("tile=", 0) == 0) {
+			value = value.substr(5);
+		}
+		try {
+			options.tile_size = std::stoi(value);
+		}
+		catch (const std::exception&) {
+			out << "Error: Invalid tile size: " << args[2] << std::endl;
+			return;
+		}
+		if (options.tile_size < 16) {
+			out << "Error: Tile size must be at least 16 pixels.\n";
+			return;
+		}
+	}
+
+	const std::string& dir = args[1];
+	const std::string name = std::filesystem::u8path(workspace->getImagePath()).stem().string();
+	PyramidResult image_result = exportPyramid(workspace->getMyImage().renderDisplay(), dir, name, options);
+	if (!image_result.ok) {
+		out << "Error: Failed to export the image pyramid.\n";
+		return;
+	}
+	out << "Pyramid exported to " << dir << ": " << image_result.levels << " levels, "
+		<< image_result.tiles_written << " / " << image_result.tiles << " tiles written\n";
+
+	// 掩码与图像使用相同的层与瓦片划分，前端可直接叠加
+	const cv::Mat mask = workspace->getBinaryMask();
+	if (!mask.empty()) {
+		PyramidResult mask_result = exportPyramid(mask, dir, name + "_mask", options);
+		if (!mask_result.ok) {
+			out << "Error: Failed to export the mask pyramid.\n";
+			return;
+		}
+		out << "Mask pyramid: " << mask_result.tiles_written << " / " << mask_result.tiles << " tiles written\n";
+	}
 }
 
 
 // 标注处理
 void CommandHandler::commandLabel(const std::vector<std::string>& args) {
 	if (args.empty()) {
-		std::cout << "Error: 'label' requires at least 1 argument.\n";
+		out << "Error: 'label' requires at least 1 argument.\n";
 		return;
 	}
 	if (args[0] == "list") {
@@ -180,21 +362,21 @@ void CommandHandler::commandLabel(const std::vector<std::string>& args) {
 		int index = 0;
 		for (auto& shape : shapes) {
 			
-			std::cout << index << ". " << "Label: " + shape.getLabel() + ", Points: [";
+			out << index << ". " << "Label: " + shape.getLabel() + ", Points: [";
 
 			auto& points = shape.getPoints();
 			for (auto& point : points) {
-				std::cout << "(" << point.x << ", " << point.y << "), ";
+				out << "(" << point.x << ", " << point.y << "), ";
 			}
 
-			std::cout << "]\n";
+			out << "]\n";
 
 			index++;
 		}
 	}
 	if (args[0] == "add") {
 		if (args.size() < 3) {
-			std::cout << "Error: 'label add' requires at least 3 arguments (label, shape_type, and points).\n";
+			out << "Error: 'label add' requires at least 3 arguments (label, shape_type, and points).\n";
 			return;
 		}
 
@@ -204,7 +386,7 @@ void CommandHandler::commandLabel(const std::vector<std::string>& args) {
 			shape_type = std::stoi(args[2]);
 		}
 		catch (const std::exception&) {
-			std::cout << "Error: Invalid shape_type, must be an integer.\n";
+			out << "Error: Invalid shape_type, must be an integer.\n";
 			return;
 		}
 
@@ -216,23 +398,23 @@ void CommandHandler::commandLabel(const std::vector<std::string>& args) {
 				points.emplace_back(x, y);
 			}
 			catch (const std::exception&) {
-				std::cout << "Error: Invalid point coordinates, must be integers.\n";
+				out << "Error: Invalid point coordinates, must be integers.\n";
 				return;
 			}
 		}
 
 		if (points.empty()) {
-			std::cout << "Error: At least one point is required.\n";
+			out << "Error: At least one point is required.\n";
 			return;
 		}
 
 		workspace->addShape(label, points, shape_type);
 		workspace->saveToAnnotationFile();
-		std::cout << "Shape added successfully.\n";
+		out << "Shape added successfully.\n";
 	}
 	if (args[0] == "remove") {
 		if (args.size() < 2) {
-			std::cout << "Error: 'label remove' requires 1 argument: index.\n";
+			out << "Error: 'label remove' requires 1 argument: index.\n";
 			return;
 		}
 		int index;
@@ -240,30 +422,98 @@ void CommandHandler::commandLabel(const std::vector<std::string>& args) {
 			index = std::stoi(args[1]);
 		}
 		catch (const std::exception&) {
-			std::cout << "Error: Invalid index, must be an integer.\n";
+			out << "Error: Invalid index, must be an integer.\n";
 			return;
 		}
 		workspace->removeShape(index);
-		std::cout << "Successfully removed index " << index << ".\n";
+		out << "Successfully removed index " << index << ".\n";
 	}
 }
 
 // 模型预测
+bool CommandHandler::parsePolygonOption(const std::vector<std::string>& args, size_t index, bool& polygons, double& tolerance) {
+	polygons = false;
+	tolerance = 1.0;
+	if (args.size() <= index) {
+		return true;
+	}
+	if (args[index] != "polygons" || args.size() > index + 2) {
+		out << "Error: Expected 'polygons [tolerance]' after the model path.\n";
+		return false;
+	}
+	polygons = true;
+	if (args.size() == index + 2) {
+		try {
+			tolerance = std::stod(args[index + 1]);
+		}
+		catch (const std::exception&) {
+			out << "Error: Invalid tolerance: " << args[index + 1] << std::endl;
+			return false;
+		}
+		if (tolerance < 0) {
+			out << "Error: Tolerance must not be negative.\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+// model <path> [polygons [tolerance]]：polygons 时实例掩码转为简化的多边形后再保存标注
 void CommandHandler::commandModelProcessing(const std::vector<std::string>& args) {
 	if (args.empty()) {
-		std::cout << "Error: 'model' requires 1 argument: model_path\n";
+		out << "Error: 'model' requires 1 argument: model_path\n";
 		return;
 	}
-	if (args.size() == 1) {
-		yolo_processor = std::make_shared<YoloModelProcessor>(args[0]);
-		workspace->runYoloModelProcessor(yolo_processor);
-		workspace->saveToAnnotationFile();
-		workspace->saveBinaryMaskAsPng();
+	bool polygons;
+	double tolerance;
+	if (!parsePolygonOption(args, 1, polygons, tolerance)) {
+		return;
 	}
+	yolo_processor = std::make_shared<YoloModelProcessor>(args[0]);
+	workspace->runYoloModelProcessor(yolo_processor);
+	if (polygons) {
+		workspace->polygonizeShapes(tolerance);
+	}
+	workspace->saveToAnnotationFile();
+	workspace->saveBinaryMaskAsPng();
 }
 
 void CommandHandler::commandBatchModelProcessing(const std::vector<std::string>& args) {
+	if (args.empty()) {
+		out << "Error: 'batch' requires 1 argument: model_path\n";
+		return;
+	}
+	bool polygons;
+	double tolerance;
+	if (!parsePolygonOption(args, 1, polygons, tolerance)) {
+		return;
+	}
 	yolo_processor = std::make_shared<YoloModelProcessor>(args[0]);
+
+	// 打开了图像栈时逐页推理，每页的标注与掩码写入栈的输出目录；同一时刻只有一页在处理中
+	if (stack) {
+		std::filesystem::create_directories(std::filesystem::u8path(stack->outputDirectory()));
+		int processed = 0;
+		for (int i = 0; i < stack->size(); ++i) {
+			cv::Mat frame = stack->frame(i);
+			if (frame.empty()) {
+				out << "Error: Failed to read frame " << i << ".\n";
+				continue;
+			}
+			// 批量推理重新生成标注与掩码：不读取上次运行写出的文件，重复运行不会累积重复的形状
+			Workspace frame_workspace(std::filesystem::u8path(stack->framePath(i)), frame.clone(), false);
+			frame_workspace.runYoloModelProcessor(yolo_processor);
+			if (polygons) {
+				frame_workspace.polygonizeShapes(tolerance);
+			}
+			frame_workspace.saveToAnnotationFile();
+			frame_workspace.saveBinaryMaskAsPng();
+			++processed;
+		}
+		out << "Processed " << processed << " / " << stack->size() << " frames into " << stack->outputDirectory() << std::endl;
+		return;
+	}
+
 	std::vector<std::string> imagePaths = { 
 	    "D:/wh/new-coding/testdata/error/7.jpg"
 		// ......
@@ -271,7 +521,11 @@ void CommandHandler::commandBatchModelProcessing(const std::vector<std::string>&
 
 	for (const auto& path : imagePaths) {
 		workspace = std::make_unique<Workspace>(std::filesystem::u8path(path));
+		workspace->clearShapes();
 		workspace->runYoloModelProcessor(yolo_processor);
+		if (polygons) {
+			workspace->polygonizeShapes(tolerance);
+		}
 		workspace->saveToAnnotationFile();
 		workspace->saveBinaryMaskAsPng();
 	}
@@ -280,7 +534,7 @@ void CommandHandler::commandBatchModelProcessing(const std::vector<std::string>&
 
 void CommandHandler::commandCrop(const std::vector<std::string>& args) {
 	if (args.size() != 4) {
-		std::cout << "Error: 'crop' requires 4 arguments (x, y, width, height).\n";
+		out << "Error: 'crop' requires 4 arguments (x, y, width, height).\n";
 		return;
 	}
 	workspace->getMyImage().crop(std::stoi(args[0]), std::stoi(args[1]), std::stoi(args[2]), std::stoi(args[3]));
@@ -288,7 +542,7 @@ void CommandHandler::commandCrop(const std::vector<std::string>& args) {
 
 void CommandHandler::commandScale(const std::vector<std::string>& args) {
 	if (args.empty()) {
-		std::cout << "Error: 'scale' requires at least 1 argument.\n";
+		out << "Error: 'scale' requires at least 1 argument.\n";
 		return;
 	}
 	if (args.size() == 1) {
@@ -302,14 +556,14 @@ void CommandHandler::commandScale(const std::vector<std::string>& args) {
 			workspace->getMyImage().scaleByHeight(std::stod(args[1]));
 		}
 		else {
-			std::cout << "Error: Invalid argument for 'scale'. Use 'scale width <int>' or 'scale height <int>'.\n";
+			out << "Error: Invalid argument for 'scale'. Use 'scale width <int>' or 'scale height <int>'.\n";
 		}
 	}
 }
 
 void CommandHandler::commandFlip(const std::vector<std::string>& args) {
 	if (args.empty()) {
-		std::cout << "Error: 'flip' requires 'h' or 'v' as an argument.\n";
+		out << "Error: 'flip' requires 'h' or 'v' as an argument.\n";
 		return;
 	}
 	if (args[0] == "h") {
@@ -319,13 +573,13 @@ void CommandHandler::commandFlip(const std::vector<std::string>& args) {
 		workspace->getMyImage().flipVertically();
 	}
 	else {
-		std::cout << "Error: Invalid argument for 'flip'. Use 'flip h' or 'flip v'.\n";
+		out << "Error: Invalid argument for 'flip'. Use 'flip h' or 'flip v'.\n";
 	}
 }
 
 void CommandHandler::commandRotate(const std::vector<std::string>& args) {
 	if (args.empty()) {
-		std::cout << "Error: 'rotate' requires an angle.\n";
+		out << "Error: 'rotate' requires an angle.\n";
 		return;
 	}
 	if (args[0] == "90") {
@@ -339,14 +593,14 @@ void CommandHandler::commandRotate(const std::vector<std::string>& args) {
 			workspace->getMyImage().rotate(std::stod(args[0]));
 		}
 		catch (const std::invalid_argument&) {
-			std::cout << "Error: Invalid angle format. Use numbers like 'rotate 45'.\n";
+			out << "Error: Invalid angle format. Use numbers like 'rotate 45'.\n";
 		}
 	}
 }
 
 void CommandHandler::commandTranslate(const std::vector<std::string>& args) {
 	if (args.size() != 2) {
-		std::cout << "Error: 'translate' requires 2 arguments (x_offset, y_offset).\n";
+		out << "Error: 'translate' requires 2 arguments (x_offset, y_offset).\n";
 		return;
 	}
 	workspace->getMyImage().translate(std::stoi(args[0]), std::stoi(args[1]));
@@ -354,7 +608,7 @@ void CommandHandler::commandTranslate(const std::vector<std::string>& args) {
 
 void CommandHandler::commandType(const std::vector<std::string>& args) {
 	if (args.empty()) {
-		std::cout << "Error: 'type' requires an argument (e.g., '8bit_gray', '16bit_gray', '32bit_gray', '8bit_color', 'rgb_color')\n";
+		out << "Error: 'type' requires an argument (e.g., '8bit_gray', '16bit_gray', '32bit_gray', '8bit_color', 'rgb_color')\n";
 		return;
 	}
 
@@ -367,20 +621,43 @@ void CommandHandler::commandType(const std::vector<std::string>& args) {
 	else if (type == "8bit_color") depth = k8BitColor;
 	else if (type == "rgb_color") depth = kRGBColor;
 	else {
-		std::cout << "Error: Invalid type '" << type << "'. Valid types: 8bit_gray, 16bit_gray, 32bit_gray, 8bit_color, rgb_color.\n";
+		out << "Error: Invalid type '" << type << "'. Valid types: 8bit_gray, 16bit_gray, 32bit_gray, 8bit_color, rgb_color.\n";
 		return;
 	}
 
-	workspace->getMyImage().convertColorDepth(depth);
+	// 有选区时只转换选区内的颜色模式，图像本身的位深不变
+	const Selection* selection = workspace->getActiveSelection();
+	if (!selection) {
+		workspace->getMyImage().convertColorDepth(depth);
+		return;
+	}
+	cv::Mat& image = workspace->getMyImage().getImageMat();
+	PointwisePipeline ops;
+	appendColorDepthOps(ops, image.type(), depth);
+	if (CV_MAT_DEPTH(ops.outputType(image.type())) != image.depth()) {
+		out << "Error: Cannot change the bit depth of a selection. Use 'select none' first.\n";
+		return;
+	}
+	applyToSelection(image, *selection, 0, [&](cv::Mat& region) {
+		ops.apply(region, region);
+	});
 }
 
 void CommandHandler::commandSetBrightnessContrast(const std::vector<std::string>& args) {
 	int minimum = 0, maximum = 255;
 	double contrast = 0, brightness = 0;
+	bool has_minimum = false, has_maximum = false;
 
 	// 如果 args 为空，输出错误
 	if (args.empty()) {
-		std::cout << "Error: 'set_brightness_contrast' requires arguments.\n";
+		out << "Error: 'set_brightness_contrast' requires arguments.\n";
+		return;
+	}
+
+	// 清除显示范围，恢复原始数据显示
+	if (args[0] == "reset") {
+		workspace->getMyImage().resetDisplayRange();
+		out << "Display range reset.\n";
 		return;
 	}
 
@@ -394,9 +671,11 @@ void CommandHandler::commandSetBrightnessContrast(const std::vector<std::string>
 				try {
 					if (args[i] == "min") {
 						minimum = std::stoi(args[i + 1]);
+						has_minimum = true;
 					}
 					else if (args[i] == "max") {
 						maximum = std::stoi(args[i + 1]);
+						has_maximum = true;
 					}
 					else if (args[i] == "contrast") {
 						contrast = std::stod(args[i + 1]);
@@ -407,111 +686,1102 @@ void CommandHandler::commandSetBrightnessContrast(const std::vector<std::string>
 					++i; // 跳过属性值
 				}
 				catch (const std::invalid_argument& e) {
-					std::cout << "Error: Invalid value for property: " << args[i] << std::endl;
+					out << "Error: Invalid value for property: " << args[i] << std::endl;
 					return;
 				}
 				catch (const std::out_of_range& e) {
-					std::cout << "Error: Value out of range for property: " << args[i] << std::endl;
+					out << "Error: Value out of range for property: " << args[i] << std::endl;
 					return;
 				}
 			}
 			else {
 				// 如果属性名后没有值，则报错
-				std::cout << "Error: Missing value for property: " << args[i] << std::endl;
+				out << "Error: Missing value for property: " << args[i] << std::endl;
 				return;
 			}
 		}
 		else {
 			// 如果遇到无效的参数名，则报错
-			std::cout << "Error: Invalid argument: " << args[i] << std::endl;
+			out << "Error: Invalid argument: " << args[i] << std::endl;
 			return;
 		}
 	}
 
-	// 调用图像处理函数
+	// 有选区且未指定 min/max 时，使用选区内数据的范围
+	const Selection* selection = workspace->getActiveSelection();
+	if ((!has_minimum || !has_maximum) && selection) {
+		cv::Mat& image = workspace->getMyImage().getImageMat();
+		ChannelStatistics stats = kernelStatistics(image(selection->bounds), selection->mask);
+		if (stats.count > 0) {
+			double data_min = stats.min[0], data_max = stats.max[0];
+			for (int c = 1; c < stats.channels; ++c) {
+				data_min = std::min(data_min, stats.min[c]);
+				data_max = std::max(data_max, stats.max[c]);
+			}
+			if (!has_minimum) minimum = static_cast<int>(std::floor(data_min));
+			if (!has_maximum) maximum = static_cast<int>(std::ceil(data_max));
+		}
+	}
+	// 非 8 位图像未指定 min/max 时，默认使用数据的实际范围
+	else if ((!has_minimum || !has_maximum) && CV_MAT_DEPTH(workspace->getMyImage().getPendingType()) != CV_8U) {
+		double data_min = 0, data_max = 0;
+		cv::minMaxLoc(workspace->getMyImage().getImageMat().reshape(1), &data_min, &data_max);
+		if (!has_minimum) minimum = static_cast<int>(std::floor(data_min));
+		if (!has_maximum) maximum = static_cast<int>(std::ceil(data_max));
+	}
+
+	// 仅更新显示参数，原始数据不变
 	workspace->getMyImage().setBrightnessContrast(minimum, maximum, contrast, brightness);
 }
 
 void CommandHandler::commandBinary(const std::vector<std::string>& args) {
-	if (args.size() != 1) {
-		std::cout << "Error: 'binary' requires 1 argument.\n";
+	if (args.empty() || (args.size() != 1 && args[0] != "make" && args[0] != "local" && args[0] != "h_maxima")) {
+		out << "Error: 'binary' requires 1 argument.\n";
 		return;
 	}
+	// 形态学操作的 halo 随迭代次数增加，其余操作取一个像素的邻域
+	const int iterations = workspace->getMyImage().binary.getOptions().iterations;
+
 	if (args[0] == "make") {
-		workspace->getMyImage().binary.makeBinary();
+		// binary make [method]：全局自动阈值，默认 ImageJ 的 default 方法
+		AutoThresholdMethod method = kThresholdDefault;
+		if (args.size() > 1 && !parseThresholdMethod(args[1], method)) {
+			out << "Error: Unknown threshold method '" << args[1] << "'. Use 'binary thresholds' to list methods.\n";
+			return;
+		}
+		runBinary(0, [=](BinaryProcessor& binary) { binary.makeBinary(method); });
+	}
+	else if (args[0] == "thresholds") {
+		// 各方法在同一份直方图上的阈值，不修改图像
+		MyImage& image = workspace->getMyImage();
+		image.prepareBinaryOps();
+		std::vector<double> thresholds = image.binary.autoThresholds();
+		for (int i = 0; i < kThresholdMethodCount; ++i) {
+			out << "  " << thresholdMethodName(static_cast<AutoThresholdMethod>(i)) << ": ";
+			if (std::isnan(thresholds[i])) out << "none\n";
+			else out << thresholds[i] << "\n";
+		}
 	}
 	else if (args[0] == "mask") {
-		workspace->getMyImage().binary.convertToMask();
+		runBinary(0, [](BinaryProcessor& binary) { binary.convertToMask(); });
+	}
+	else if (args[0] == "local") {
+		// binary local niblack|sauvola [radius=15] [k] [r]；r 省略时按位深取值（8 位为 128）
+		if (args.size() < 2 || (args[1] != "niblack" && args[1] != "sauvola")) {
+			out << "Error: 'binary local' requires a method: niblack|sauvola.\n";
+			return;
+		}
+		LocalThresholdMethod method = (args[1] == "niblack") ? kNiblack : kSauvola;
+		float radius = 15;
+		double k = (method == kNiblack) ? 0.2 : 0.5;
+		double r = 0;
+		try {
+			if (args.size() > 2) radius = std::stof(args[2]);
+			if (args.size() > 3) k = std::stod(args[3]);
+			if (args.size() > 4) r = std::stod(args[4]);
+		}
+		catch (const std::exception&) {
+			out << "Error: Invalid numeric value for 'binary local'.\n";
+			return;
+		}
+		if (radius < 0 || (args.size() > 4 && r <= 0)) {
+			out << "Error: Radius must not be negative and r must be positive.\n";
+			return;
+		}
+		runBinary(static_cast<int>(radius), [=](BinaryProcessor& binary) { binary.localThreshold(method, radius, k, r); });
 	}
 	else if (args[0] == "erode") {
-		workspace->getMyImage().binary.erode();
+		runBinary(iterations, [](BinaryProcessor& binary) { binary.erode(); });
 	}
 	else if (args[0] == "dilate") {
-		workspace->getMyImage().binary.dilate();
+		runBinary(iterations, [](BinaryProcessor& binary) { binary.dilate(); });
 	}
 	else if (args[0] == "open") {
-		workspace->getMyImage().binary.open();
+		runBinary(2 * iterations, [](BinaryProcessor& binary) { binary.open(); });
 	}
 	else if (args[0] == "close") {
-		workspace->getMyImage().binary.close();
+		runBinary(2 * iterations, [](BinaryProcessor& binary) { binary.close(); });
 	}
 	else if (args[0] == "median") {
-		workspace->getMyImage().binary.median();
+		runBinary(2, [](BinaryProcessor& binary) { binary.median(); });
 	}
 	else if (args[0] == "outline") {
-		workspace->getMyImage().binary.outline();
+		runBinary(1, [](BinaryProcessor& binary) { binary.outline(); });
 	}
 	else if (args[0] == "fill_holes") {
-		workspace->getMyImage().binary.fillHoles();
+		runBinary(kWholeImageHalo, [](BinaryProcessor& binary) { binary.fillHoles(); });
+	}
+	else if (args[0] == "clear_border") {
+		runBinary(kWholeImageHalo, [](BinaryProcessor& binary) { binary.clearBorder(); });
+	}
+	else if (args[0] == "h_maxima") {
+		// binary h_maxima <h>：深度不小于 h 的灰度极大值
+		if (args.size() < 2) {
+			out << "Error: 'binary h_maxima' requires a height <h>.\n";
+			return;
+		}
+		double h;
+		try {
+			h = std::stod(args[1]);
+		}
+		catch (const std::exception&) {
+			out << "Error: Invalid numeric value for 'binary h_maxima'.\n";
+			return;
+		}
+		if (h < 0) {
+			out << "Error: Height must not be negative.\n";
+			return;
+		}
+		runBinary(kWholeImageHalo, [=](BinaryProcessor& binary) { binary.hMaxima(h); });
 	}
 	else if (args[0] == "skeletonize") {
-		workspace->getMyImage().binary.skeletonize();
+		runBinary(kWholeImageHalo, [](BinaryProcessor& binary) { binary.skeletonize(); });
 	}
 	else if (args[0] == "distance_map") {
-		workspace->getMyImage().binary.distanceMap();
+		runBinary(kWholeImageHalo, [](BinaryProcessor& binary) { binary.distanceMap(); });
 	}
 	else if (args[0] == "ultimate_points") {
-		workspace->getMyImage().binary.ultimatePoints();
+		runBinary(kWholeImageHalo, [](BinaryProcessor& binary) { binary.ultimatePoints(); });
 	}
 	else if (args[0] == "watershed") {
-		workspace->getMyImage().binary.watershed();
+		runBinary(kWholeImageHalo, [](BinaryProcessor& binary) { binary.watershed(); });
 	}
 	else if (args[0] == "voronoi") {
-		workspace->getMyImage().binary.voronoi();
+		runBinary(kWholeImageHalo, [](BinaryProcessor& binary) { binary.voronoi(); });
 	}
 }
 
+// set_binary_options [iterations <1-100>] [count <1-8>] [black_background on|off] [pad_edges on|off]
+//                    [edm overwrite|8bit|16bit|32bit] [element square|disc|diamond]；不带参数时只显示当前设置
+void CommandHandler::commandSetBinaryOptions(const std::vector<std::string>& args) {
+	BinaryOptions options = workspace->getMyImage().binary.getOptions();
+	static const std::map<std::string, EdmOutput> edm_outputs = {
+		{ "overwrite", kOverwrite }, { "8bit", k8Bit }, { "16bit", k16Bit }, { "32bit", k32Bit } };
+	static const std::map<std::string, StructuringElement> elements = {
+		{ "square", kElementSquare }, { "disc", kElementDisc }, { "diamond", kElementDiamond } };
+
+	if (args.size() % 2 != 0) {
+		out << "Error: 'set_binary_options' expects <option> <value> pairs.\n";
+		return;
+	}
+	for (size_t i = 0; i + 1 < args.size(); i += 2) {
+		const std::string& key = args[i];
+		const std::string& value = args[i + 1];
+		if (key == "iterations" || key == "count") {
+			int n;
+			try {
+				n = std::stoi(value);
+			}
+			catch (const std::exception&) {
+				out << "Error: Invalid numeric value for '" << key << "'.\n";
+				return;
+			}
+			if (key == "iterations" && (n < 1 || n > 100)) {
+				out << "Error: Iterations must be between 1 and 100.\n";
+				return;
+			}
+			if (key == "count" && (n < 1 || n > 8)) {
+				out << "Error: Count must be between 1 and 8.\n";
+				return;
+			}
+			(key == "iterations" ? options.iterations : options.count) = n;
+		}
+		else if (key == "black_background" || key == "pad_edges") {
+			if (value != "on" && value != "off") {
+				out << "Error: '" << key << "' must be on or off.\n";
+				return;
+			}
+			(key == "black_background" ? options.black_background : options.pad_edges_when_eroding) = (value == "on");
+		}
+		else if (key == "edm") {
+			auto it = edm_outputs.find(value);
+			if (it == edm_outputs.end()) {
+				out << "Error: Invalid EDM output '" << value << "'. Valid outputs: overwrite, 8bit, 16bit, 32bit.\n";
+				return;
+			}
+			options.edm_output = it->second;
+		}
+		else if (key == "element") {
+			auto it = elements.find(value);
+			if (it == elements.end()) {
+				out << "Error: Invalid element '" << value << "'. Valid elements: square, disc, diamond.\n";
+				return;
+			}
+			options.element = it->second;
+		}
+		else {
+			out << "Error: Unknown binary option '" << key << "'.\n";
+			return;
+		}
+	}
+	workspace->getMyImage().binary.setOptions(options);
+
+	auto nameOf = [](const auto& table, auto value) {
+		for (const auto& entry : table) {
+			if (entry.second == value) return entry.first;
+		}
+		return std::string();
+	};
+	out << "Binary options: iterations " << options.iterations << ", count " << options.count
+		<< ", black_background " << (options.black_background ? "on" : "off")
+		<< ", pad_edges " << (options.pad_edges_when_eroding ? "on" : "off")
+		<< ", edm " << nameOf(edm_outputs, options.edm_output)
+		<< ", element " << nameOf(elements, options.element) << std::endl;
+}
+
 
 void CommandHandler::commandFilter(const std::vector<std::string>& args) {
 	if (args.empty()) {
-		std::cout << "Error: 'filter' requires at least 1 argument.\n";
+		out << "Error: 'filter' requires at least 1 argument.\n";
+		return;
+	}
+	// filter convolve <row> ; <row> ; ... [normalize]：各行以 ';' 分隔
+	if (args[0] == "convolve") {
+		std::string kernel_str;
+		bool normalize = false;
+		for (size_t i = 1; i < args.size(); ++i) {
+			if (args[i] == "normalize") {
+				normalize = true;
+				continue;
+			}
+			for (char c : args[i]) {
+				kernel_str += (c == ';') ? '\n' : c;
+			}
+			kernel_str += ' ';
+		}
+		if (kernel_str.empty()) {
+			out << "Error: 'filter convolve' requires a kernel.\n";
+			return;
+		}
+		// 选区的 halo 取核半径；核不合法时由 convolve 报错
+		std::shared_ptr<const AnalyzedKernel> kernel = analyzeKernel(kernel_str, normalize);
+		int halo = kernel ? std::max(kernel->kernel.rows, kernel->kernel.cols) / 2 : 0;
+		runFilter(halo, [&](FilterProcessor& filter) { filter.convolve(kernel_str, normalize); });
+		return;
+	}
+
+	// filter unsharp [sigma=1] [weight=0.6]
+	if (args[0] == "unsharp") {
+		float sigma = 1;
+		float weight = 0.6f;
+		try {
+			if (args.size() > 1) sigma = std::stof(args[1]);
+			if (args.size() > 2) weight = std::stof(args[2]);
+		}
+		catch (const std::exception&) {
+			out << "Error: Invalid numeric value for 'filter unsharp'.\n";
+			return;
+		}
+		if (sigma <= 0 || weight < 0 || weight >= 1) {
+			out << "Error: 'filter unsharp' requires sigma > 0 and 0 <= weight < 1.\n";
+			return;
+		}
+		runFilter(static_cast<int>(std::ceil(4 * sigma)), [=](FilterProcessor& filter) { filter.unsharpMask(sigma, weight); });
+		return;
+	}
+
+	// filter tophat <radius> [light|dark] [fast|exact]
+	if (args[0] == "tophat") {
+		if (args.size() < 2) {
+			out << "Error: 'filter tophat' requires a radius.\n";
+			return;
+		}
+		float radius = 0;
+		try {
+			radius = std::stof(args[1]);
+		}
+		catch (const std::exception&) {
+			out << "Error: Invalid radius: " << args[1] << std::endl;
+			return;
+		}
+		if (radius <= 0) {
+			out << "Error: Radius must be positive.\n";
+			return;
+		}
+		bool light_background = true;
+		bool fast = false;
+		for (size_t i = 2; i < args.size(); ++i) {
+			if (args[i] == "light") light_background = true;
+			else if (args[i] == "dark") light_background = false;
+			else if (args[i] == "fast") fast = true;
+			else if (args[i] == "exact") fast = false;
+			else {
+				out << "Error: Invalid argument: " << args[i] << std::endl;
+				return;
+			}
+		}
+		// 开 / 闭运算是两次半径为 radius 的秩滤波
+		int halo = 2 * static_cast<int>(std::ceil(radius));
+		runFilter(halo, [=](FilterProcessor& filter) { filter.topHat(radius, light_background, false, fast); });
 		return;
 	}
-	/*if (args[0] == "convolve") {
-		workspace->getMyImage().filter.convolve();
-	}*/
+
+	// 可选参数：半径（默认 2）与核形状
+	float radius = 2;
+	bool circular = false;
+	for (size_t i = 1; i < args.size(); ++i) {
+		if (args[i] == "circular") {
+			circular = true;
+		}
+		else if (args[i] == "square") {
+			circular = false;
+		}
+		else {
+			try {
+				radius = std::stof(args[i]);
+			}
+			catch (const std::exception&) {
+				out << "Error: Invalid radius: " << args[i] << std::endl;
+				return;
+			}
+			if (radius < 0) {
+				out << "Error: Radius must not be negative.\n";
+				return;
+			}
+		}
+	}
+
+	// 选区的 halo 取算子的邻域半径
+	const int rank_halo = static_cast<int>(rankKernelLines(radius, circular).size()) / 2;
+
 	if (args[0] == "gaussian") {
-		workspace->getMyImage().filter.gaussianBlur(2);
+		runFilter(static_cast<int>(std::ceil(4 * radius)), [=](FilterProcessor& filter) { filter.gaussianBlur(radius); });
 	}
 	if (args[0] == "median") {
-		workspace->getMyImage().filter.median(2);
+		runFilter(rank_halo, [=](FilterProcessor& filter) { filter.median(radius, circular); });
 	}
 	if (args[0] == "mean") {
-		workspace->getMyImage().filter.mean(2);
+		runFilter(static_cast<int>(radius), [=](FilterProcessor& filter) { filter.mean(radius); });
 	}
 	if (args[0] == "minimum") {
-		workspace->getMyImage().filter.minimum(2);
+		runFilter(rank_halo, [=](FilterProcessor& filter) { filter.minimum(radius, circular); });
 	}
 	if (args[0] == "maximum") {
-		workspace->getMyImage().filter.maximum(2);
-	}
-	if (args[0] == "unsharp") {
-		workspace->getMyImage().filter.unsharpMask(1, 0.6);
+		runFilter(rank_halo, [=](FilterProcessor& filter) { filter.maximum(radius, circular); });
 	}
 	if (args[0] == "variance") {
-		workspace->getMyImage().filter.variance(2);
+		runFilter(static_cast<int>(radius), [=](FilterProcessor& filter) { filter.variance(radius); });
 	}
-	if (args[0] == "tophat") {
-		workspace->getMyImage().filter.topHat(2, true, true);
+}
+
+
+// 处理器直接引用 image_mat，先执行待定的逐像素操作；
+// 有选区时在外接矩形加 halo 的副本上执行，再按选区掩码写回（结果转换回原图类型）
+void CommandHandler::runFilter(int halo, const std::function<void(FilterProcessor&)>& op) {
+	MyImage& image = workspace->getMyImage();
+	image.flushPendingOps();
+	const Selection* selection = workspace->getActiveSelection();
+	if (!selection) {
+		op(image.filter);
+		return;
+	}
+	applyToSelection(image.getImageMat(), *selection, halo, [&](cv::Mat& region) {
+		FilterProcessor filter(region);
+		op(filter);
+	});
+}
+
+void CommandHandler::runBinary(int halo, const std::function<void(BinaryProcessor&)>& op) {
+	MyImage& image = workspace->getMyImage();
+	const Selection* selection = workspace->getActiveSelection();
+	if (!selection) {
+		// 打包的二值图像直接交给 BinaryProcessor，不解包
+		image.prepareBinaryOps();
+		op(image.binary);
+		return;
+	}
+	applyToSelection(image.getImageMat(), *selection, halo, [&](cv::Mat& region) {
+		BinaryProcessor binary(region);
+		binary.setOptions(image.binary.getOptions());
+		op(binary);
+	});
+}
+
+
+void CommandHandler::commandHistogram(const std::vector<std::string>& args) {
+	HistogramOptions options;
+	bool csv = false;
+
+	try {
+		for (size_t i = 0; i < args.size(); ++i) {
+			if (args[i] == "bins" && i + 1 < args.size()) {
+				options.bins = std::stoi(args[++i]);
+			}
+			else if (args[i] == "min" && i + 1 < args.size()) {
+				options.minimum = std::stod(args[++i]);
+			}
+			else if (args[i] == "max" && i + 1 < args.size()) {
+				options.maximum = std::stod(args[++i]);
+			}
+			else if (args[i] == "roi" && i + 4 < args.size()) {
+				options.roi = cv::Rect(std::stoi(args[i + 1]), std::stoi(args[i + 2]), std::stoi(args[i + 3]), std::stoi(args[i + 4]));
+				i += 4;
+			}
+			else if (args[i] == "mask") {
+				options.mask = workspace->getBinaryMask();
+				if (options.mask.empty()) {
+					out << "Error: No binary mask available for 'histogram mask'.\n";
+					return;
+				}
+			}
+			else if (args[i] == "json") {
+				csv = false;
+			}
+			else if (args[i] == "csv") {
+				csv = true;
+			}
+			else {
+				out << "Error: Invalid argument: " << args[i] << std::endl;
+				return;
+			}
+		}
+	}
+	catch (const std::exception&) {
+		out << "Error: Invalid numeric value for 'histogram'.\n";
+		return;
+	}
+
+	if (options.bins <= 0) {
+		out << "Error: 'bins' must be positive.\n";
+		return;
+	}
+
+	HistogramResult result = workspace->getMyImage().histogram(options);
+	if (result.counts.empty()) {
+		out << "Error: Failed to compute histogram.\n";
+		return;
 	}
-}
\ No newline at end of file
+
+	if (csv) {
+		out << "bin_start";
+		for (int c = 0; c < result.channels(); ++c) {
+			out << ",ch" << c;
+		}
+		out << "\n";
+		for (int b = 0; b < result.bins; ++b) {
+			out << result.minimum + b * result.bin_width;
+			for (int c = 0; c < result.channels(); ++c) {
+				out << "," << result.counts[c][b];
+			}
+			out << "\n";
+		}
+		return;
+	}
+
+	nlohmann::json j;
+	j["bins"] = result.bins;
+	j["min"] = result.minimum;
+	j["max"] = result.maximum;
+	j["bin_width"] = result.bin_width;
+	j["channels"] = nlohmann::json::array();
+	for (int c = 0; c < result.channels(); ++c) {
+		j["channels"].push_back(result.counts[c]);
+	}
+	out << j.dump() << std::endl;
+}
+
+void CommandHandler::commandProfile(const std::vector<std::string>& args) {
+	if (args.empty()) {
+		out << "Error: 'profile' requires at least 1 argument (line, shape or mask).\n";
+		return;
+	}
+
+	MyImage& image = workspace->getMyImage();
+	std::vector<float> profile;
+
+	try {
+		if (args[0] == "line") {
+			std::vector<Point> points;
+			float line_width = 1;
+			for (size_t i = 1; i < args.size(); ++i) {
+				if (args[i] == "width" && i + 1 < args.size()) {
+					line_width = std::stof(args[++i]);
+				}
+				else if (i + 1 < args.size()) {
+					points.emplace_back(std::stod(args[i]), std::stod(args[i + 1]));
+					++i;
+				}
+				else {
+					out << "Error: Point coordinates must come in pairs.\n";
+					return;
+				}
+			}
+			if (points.size() < 2) {
+				out << "Error: 'profile line' requires at least 2 points.\n";
+				return;
+			}
+			profile = image.lineProfile(points, line_width);
+		}
+		else if (args[0] == "shape") {
+			if (args.size() < 2) {
+				out << "Error: 'profile shape' requires a shape index.\n";
+				return;
+			}
+			size_t index = std::stoul(args[1]);
+			const std::vector<MyShape>& shapes = workspace->getShapes();
+			if (index >= shapes.size()) {
+				out << "Error: Shape index out of range.\n";
+				return;
+			}
+
+			if (args.size() > 2 && args[2] == "mask") {
+				// 实例掩码只覆盖检测框，构建索引的开销与框面积成正比
+				const SegmentOutput& segment = shapes[index].getSegmentOutput();
+				if (segment._boxMask.empty()) {
+					out << "Error: Shape " << index << " has no instance mask.\n";
+					return;
+				}
+				cv::Mat box_mask = segment._boxMask;
+				if (box_mask.type() != CV_8UC1) {
+					box_mask.convertTo(box_mask, CV_8U);
+				}
+				const cv::Mat& image_mat = image.getImageMat();
+				cv::Point offset(cvRound(segment._box.x), cvRound(segment._box.y));
+				profile = image.plotProfile(RunLengthMask::fromMat(box_mask, offset, image_mat.size()));
+			}
+			else {
+				const MyShape& shape = shapes[index];
+				std::vector<Point> points = shape.getPoints();
+				// 矩形及模型 / 颗粒的两点外接框是区域而不是线段：按列平均，不沿对角线采样
+				if (shape.getShapeType() == 0 || (shape.getShapeType() == 2 && points.size() == 2)) {
+					if (points.size() < 2) {
+						out << "Error: Shape " << index << " has too few points.\n";
+						return;
+					}
+					double min_x = std::min(points[0].x, points[1].x);
+					double min_y = std::min(points[0].y, points[1].y);
+					double max_x = std::max(points[0].x, points[1].x);
+					double max_y = std::max(points[0].y, points[1].y);
+					cv::Rect rect(cv::Point(cvFloor(min_x), cvFloor(min_y)), cv::Point(cvCeil(max_x), cvCeil(max_y)));
+					profile = image.rectProfile(rect);
+				}
+				else {
+					float line_width = 1;
+					if (args.size() > 3 && args[2] == "width") {
+						line_width = std::stof(args[3]);
+					}
+					// 多边形是闭合的：回到起点
+					if (shape.getShapeType() == 1 && points.size() > 2) {
+						points.push_back(points.front());
+					}
+					profile = image.lineProfile(points, line_width);
+				}
+			}
+		}
+		else if (args[0] == "mask") {
+			const RunLengthMask& runs = workspace->getBinaryMaskRuns();
+			if (!workspace->hasBinaryMask()) {
+				out << "Error: No binary mask available.\n";
+				return;
+			}
+			profile = image.plotProfile(runs);
+		}
+		else {
+			out << "Error: Invalid argument for 'profile'. Use 'line', 'shape' or 'mask'.\n";
+			return;
+		}
+	}
+	catch (const std::exception&) {
+		out << "Error: Invalid numeric value for 'profile'.\n";
+		return;
+	}
+
+	nlohmann::json j = profile;
+	out << j.dump() << std::endl;
+}
+
+void CommandHandler::commandBenchmark(const std::vector<std::string>& args) {
+	runBenchmark(args);
+}
+
+// tiles [<tile_size>|off] [threads <n>]：不带参数时显示当前设置
+void CommandHandler::commandTiles(const std::vector<std::string>& args) {
+	TileOptions options = TileExecutor::getOptions();
+	try {
+		for (size_t i = 0; i < args.size(); ++i) {
+			if (args[i] == "off") {
+				options.tile_size = 0;
+			}
+			else if (args[i] == "threads" && i + 1 < args.size()) {
+				options.threads = std::stoi(args[++i]);
+			}
+			else {
+				options.tile_size = std::stoi(args[i]);
+			}
+		}
+	}
+	catch (const std::exception&) {
+		out << "Error: Invalid numeric value for 'tiles'.\n";
+		return;
+	}
+	if (options.tile_size < 0 || options.threads < 0) {
+		out << "Error: Tile size and thread count must not be negative.\n";
+		return;
+	}
+	if (options.tile_size > 0 && options.tile_size < 16) {
+		out << "Error: Tile size must be at least 16 pixels.\n";
+		return;
+	}
+
+	TileExecutor::setOptions(options);
+	out << "Tiles: " << (options.tile_size > 0 ? std::to_string(options.tile_size) + " px" : std::string("off"))
+		<< ", threads: " << TileExecutor::threadCount(options) << std::endl;
+}
+
+// select rect <x> <y> <w> <h> | polygon <x0> <y0> ... | shape <index> | none；不带参数时显示当前选区
+void CommandHandler::commandSelect(const std::vector<std::string>& args) {
+	const cv::Size image_size = workspace->getMyImage().getImageMat().size();
+
+	if (args.empty()) {
+		const Selection* selection = workspace->getActiveSelection();
+		if (!selection) {
+			out << "Selection: none\n";
+			return;
+		}
+		const cv::Rect& b = selection->bounds;
+		out << "Selection: " << b.x << " " << b.y << " " << b.width << " " << b.height
+			<< (selection->mask.empty() ? " (rect)" : " (mask)") << std::endl;
+		return;
+	}
+
+	if (args[0] == "none") {
+		workspace->clearSelection();
+		out << "Selection cleared.\n";
+		return;
+	}
+
+	Selection selection;
+	try {
+		if (args[0] == "rect") {
+			if (args.size() != 5) {
+				out << "Error: 'select rect' requires <x> <y> <w> <h>.\n";
+				return;
+			}
+			cv::Rect rect(std::stoi(args[1]), std::stoi(args[2]), std::stoi(args[3]), std::stoi(args[4]));
+			selection = Selection::fromRect(rect, image_size);
+		}
+		else if (args[0] == "polygon") {
+			if (args.size() < 7 || (args.size() - 1) % 2 != 0) {
+				out << "Error: 'select polygon' requires at least 3 points (x y pairs).\n";
+				return;
+			}
+			std::vector<Point> points;
+			for (size_t i = 1; i + 1 < args.size(); i += 2) {
+				points.emplace_back(std::stod(args[i]), std::stod(args[i + 1]));
+			}
+			selection = Selection::fromPolygon(points, image_size);
+		}
+		else if (args[0] == "shape") {
+			if (args.size() != 2) {
+				out << "Error: 'select shape' requires a shape index.\n";
+				return;
+			}
+			size_t index = std::stoul(args[1]);
+			const std::vector<MyShape>& shapes = workspace->getShapes();
+			if (index >= shapes.size()) {
+				out << "Error: Shape index out of range (" << shapes.size() << " shapes).\n";
+				return;
+			}
+			selection = Selection::fromShape(shapes[index], image_size);
+		}
+		else {
+			out << "Error: Invalid selection type '" << args[0] << "'. Valid types: rect, polygon, shape, none.\n";
+			return;
+		}
+	}
+	catch (const std::exception&) {
+		out << "Error: Invalid numeric value for 'select'.\n";
+		return;
+	}
+
+	if (selection.empty()) {
+		out << "Error: Selection does not overlap the image.\n";
+		return;
+	}
+	workspace->setSelection(selection);
+	const cv::Rect& b = selection.bounds;
+	out << "Selection: " << b.x << " " << b.y << " " << b.width << " " << b.height
+		<< (selection.mask.empty() ? " (rect)" : " (mask)") << std::endl;
+}
+
+// analyze_particles [size <min> <max>] [circularity <min> <max>] [exclude_edges] [4] [mask] [list]
+// 默认以当前图像的非零像素为前景；带 mask 时以二值掩码为前景、当前图像为强度
+void CommandHandler::commandAnalyzeParticles(const std::vector<std::string>& args) {
+	ParticleOptions options;
+	bool use_mask = false;
+	bool list = false;
+	try {
+		for (size_t i = 0; i < args.size(); ++i) {
+			if (args[i] == "size" && i + 2 < args.size()) {
+				options.min_area = std::stod(args[i + 1]);
+				options.max_area = std::stod(args[i + 2]);
+				i += 2;
+			}
+			else if (args[i] == "circularity" && i + 2 < args.size()) {
+				options.min_circularity = std::stod(args[i + 1]);
+				options.max_circularity = std::stod(args[i + 2]);
+				i += 2;
+			}
+			else if (args[i] == "exclude_edges") {
+				options.exclude_edges = true;
+			}
+			else if (args[i] == "4") {
+				options.eight_connected = false;
+			}
+			else if (args[i] == "mask") {
+				use_mask = true;
+			}
+			else if (args[i] == "list") {
+				list = true;
+			}
+			else {
+				out << "Error: Unknown option '" << args[i] << "' for 'analyze_particles'.\n";
+				return;
+			}
+		}
+	}
+	catch (const std::exception&) {
+		out << "Error: Invalid numeric value for 'analyze_particles'.\n";
+		return;
+	}
+	if (options.min_area > options.max_area || options.min_circularity > options.max_circularity) {
+		out << "Error: Minimum must not exceed maximum.\n";
+		return;
+	}
+
+	const cv::Mat& image = workspace->getMyImage().getImageMat();
+	cv::Mat mask;
+	cv::Mat intensity;
+	if (use_mask) {
+		mask = workspace->getBinaryMask();
+		if (mask.empty()) {
+			out << "Error: No binary mask. Run 'model' first or load a mask.\n";
+			return;
+		}
+		if (mask.size() != image.size()) {
+			out << "Error: Binary mask and image differ in size.\n";
+			return;
+		}
+		intensity = image;
+	}
+	else if (image.type() == CV_8UC1) {
+		mask = image;
+	}
+	else {
+		cv::Mat gray = image;
+		if (image.channels() > 1) {
+			cv::cvtColor(image, gray, (image.channels() == 4) ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+		}
+		cv::compare(gray, 0, mask, cv::CMP_NE);
+		intensity = image;
+	}
+
+	ParticleResult result = analyzeParticles(mask, intensity, options);
+
+	// 框内掩码在一遍标签图扫描中同时写出：标签映射到颗粒序号，被筛掉的标签为 -1
+	std::vector<int> particle_of_label(result.components + 1, -1);
+	std::vector<cv::Mat> box_masks(result.particles.size());
+	for (size_t i = 0; i < result.particles.size(); ++i) {
+		particle_of_label[result.particles[i].label] = static_cast<int>(i);
+		box_masks[i] = cv::Mat::zeros(result.particles[i].bounds.size(), CV_8UC1);
+	}
+	if (!result.particles.empty()) {
+		cv::parallel_for_(cv::Range(0, result.labels.rows), [&](const cv::Range& rows) {
+			for (int y = rows.start; y < rows.end; ++y) {
+				const int* l = result.labels.ptr<int>(y);
+				for (int x = 0; x < result.labels.cols; ++x) {
+					const int index = particle_of_label[l[x]];
+					if (index >= 0) {
+						const cv::Rect& b = result.particles[index].bounds;
+						box_masks[index].ptr<uchar>(y - b.y)[x - b.x] = 255;
+					}
+				}
+			}
+		});
+	}
+
+	// 通过筛选的颗粒作为掩码形状加入工作区，与模型输出的实例相同：两点外接矩形 + 框内掩码
+	std::vector<MyShape> shapes;
+	shapes.reserve(result.particles.size());
+	int64_t total_area = 0;
+	for (size_t i = 0; i < result.particles.size(); ++i) {
+		const Particle& particle = result.particles[i];
+		const cv::Rect& b = particle.bounds;
+		SegmentOutput segment;
+		segment._id = particle.label;
+		segment._confidence = 1.f;
+		segment._box = cv::Rect2f(b);
+		segment._boxMask = box_masks[i];
+
+		MyShape shape("particle", 2);
+		shape.addPoint(b.x, b.y);
+		shape.addPoint(b.x + b.width, b.y + b.height);
+		shape.setSegmentOutput(segment);
+		shapes.push_back(shape);
+		total_area += particle.area;
+	}
+	const size_t first_index = workspace->getShapes().size();
+	workspace->importShapes(shapes);
+	workspace->saveToAnnotationFile();
+
+	if (list) {
+		out << "index,label,area,x,y,width,height,centroid_x,centroid_y,perimeter,circularity,mean\n";
+		for (size_t i = 0; i < result.particles.size(); ++i) {
+			const Particle& p = result.particles[i];
+			out << first_index + i << "," << p.label << "," << p.area << ","
+				<< p.bounds.x << "," << p.bounds.y << "," << p.bounds.width << "," << p.bounds.height << ","
+				<< p.centroid.x << "," << p.centroid.y << "," << p.perimeter << "," << p.circularity << "," << p.mean << "\n";
+		}
+	}
+	out << "Particles: " << result.particles.size() << " of " << result.components << " components, total area "
+		<< total_area << " px";
+	if (!result.particles.empty()) {
+		out << ", mean size " << static_cast<double>(total_area) / result.particles.size() << " px";
+	}
+	out << std::endl;
+}
+
+// measure [csv|json] [out <path>]
+void CommandHandler::commandMeasure(const std::vector<std::string>& args) {
+	bool csv = true;
+	std::string out_path;
+	for (size_t i = 0; i < args.size(); ++i) {
+		if (args[i] == "csv") {
+			csv = true;
+		}
+		else if (args[i] == "json") {
+			csv = false;
+		}
+		else if (args[i] == "out" && i + 1 < args.size()) {
+			out_path = args[++i];
+		}
+		else {
+			out << "Error: Invalid argument: " << args[i] << std::endl;
+			return;
+		}
+	}
+
+	const std::vector<MyShape>& shapes = workspace->getShapes();
+	if (shapes.empty()) {
+		out << "Error: No shapes to measure.\n";
+		return;
+	}
+	std::vector<ShapeMeasurement> results = measureShapes(workspace->getMyImage().getImageMat(), shapes);
+
+	std::ostringstream text;
+	if (csv) {
+		// 标签可能含逗号、引号或换行：整体加引号，内部引号写两次（RFC 4180）
+		auto quoted = [](const std::string& field) {
+			std::string result = "\"";
+			for (char c : field) {
+				if (c == '"') result += '"';
+				result += c;
+			}
+			return result + "\"";
+		};
+		text << "index,label,area,mean,stddev,min,max,integrated_density,centroid_x,centroid_y,perimeter,feret,feret_angle,min_feret\n";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const ShapeMeasurement& m = results[i];
+			text << i << "," << quoted(shapes[i].getLabel()) << "," << m.area << "," << m.mean << "," << m.stddev << ","
+				<< m.min << "," << m.max << "," << m.integrated_density << "," << m.centroid.x << "," << m.centroid.y << ","
+				<< m.perimeter << "," << m.feret << "," << m.feret_angle << "," << m.min_feret << "\n";
+		}
+	}
+	else {
+		nlohmann::json j = nlohmann::json::array();
+		for (size_t i = 0; i < results.size(); ++i) {
+			const ShapeMeasurement& m = results[i];
+			j.push_back({
+				{"index", i},
+				{"label", shapes[i].getLabel()},
+				{"area", m.area},
+				{"mean", m.mean},
+				{"stddev", m.stddev},
+				{"min", m.min},
+				{"max", m.max},
+				{"integrated_density", m.integrated_density},
+				{"centroid_x", m.centroid.x},
+				{"centroid_y", m.centroid.y},
+				{"perimeter", m.perimeter},
+				{"feret", m.feret},
+				{"feret_angle", m.feret_angle},
+				{"min_feret", m.min_feret}
+			});
+		}
+		text << j.dump() << "\n";
+	}
+
+	if (out_path.empty()) {
+		out << text.str();
+		return;
+	}
+	std::ofstream file(std::filesystem::u8path(out_path), std::ios::binary);
+	if (!file) {
+		out << "Error: Cannot write '" << out_path << "'.\n";
+		return;
+	}
+	file << text.str();
+	out << "Measured " << results.size() << " shapes, results written to " << out_path << std::endl;
+}
+
+// polygonize [tolerance=1]
+void CommandHandler::commandPolygonize(const std::vector<std::string>& args) {
+	if (args.size() > 1) {
+		out << "Error: 'polygonize' takes at most 1 argument (tolerance).\n";
+		return;
+	}
+	double tolerance = 1.0;
+	if (!args.empty()) {
+		try {
+			tolerance = std::stod(args[0]);
+		}
+		catch (const std::exception&) {
+			out << "Error: Invalid tolerance: " << args[0] << std::endl;
+			return;
+		}
+	}
+	if (tolerance < 0) {
+		out << "Error: Tolerance must not be negative.\n";
+		return;
+	}
+
+	int converted = workspace->polygonizeShapes(tolerance);
+	workspace->saveToAnnotationFile();
+	out << "Converted " << converted << " of " << workspace->getShapes().size() << " shapes to polygons." << std::endl;
+}
+
+// stack open <path> [cache <n>] | info | frame <index> | apply <command> [args...] | close
+void CommandHandler::commandStack(const std::vector<std::string>& args) {
+	if (args.empty()) {
+		out << "Error: 'stack' requires an argument (open, info, frame, apply, close).\n";
+		return;
+	}
+
+	if (args[0] == "open") {
+		if (args.size() < 2) {
+			out << "Error: 'stack open' requires a file path.\n";
+			return;
+		}
+		const std::string& path = args[1];
+		if (!std::filesystem::is_regular_file(std::filesystem::u8path(path))) {
+			out << "Error: '" << path << "' is not a valid file.\n";
+			return;
+		}
+		size_t cache_frames = 4;
+		if (args.size() == 4 && args[2] == "cache") {
+			try {
+				cache_frames = std::stoul(args[3]);
+			}
+			catch (const std::exception&) {
+				out << "Error: Invalid cache size: " << args[3] << std::endl;
+				return;
+			}
+		}
+		else if (args.size() != 2) {
+			out << "Error: Usage: stack open <path> [cache <n>]\n";
+			return;
+		}
+
+		std::unique_ptr<ImageStack> opened = std::make_unique<ImageStack>(path, cache_frames);
+		if (opened->empty()) {
+			out << "Error: Failed to read pages from '" << path << "'.\n";
+			return;
+		}
+		stack = std::move(opened);
+		out << "Stack opened: " << path << ", " << stack->size() << " frames, cache "
+			<< stack->getCacheCapacity() << " frames" << std::endl;
+		return;
+	}
+
+	if (!stack) {
+		out << "Error: No stack open. Use 'stack open <path>' first.\n";
+		return;
+	}
+
+	if (args[0] == "info") {
+		out << "Stack: " << stack->getPath() << ", " << stack->size() << " frames, cache "
+			<< stack->getCacheCapacity() << " frames, output " << stack->outputDirectory() << std::endl;
+	}
+	else if (args[0] == "close") {
+		stack.reset();
+		out << "Stack closed.\n";
+	}
+	else if (args[0] == "frame") {
+		if (args.size() != 2) {
+			out << "Error: 'stack frame' requires an index.\n";
+			return;
+		}
+		int index = 0;
+		try {
+			index = std::stoi(args[1]);
+		}
+		catch (const std::exception&) {
+			out << "Error: Invalid frame index: " << args[1] << std::endl;
+			return;
+		}
+		if (index < 0 || index >= stack->size()) {
+			out << "Error: Frame index out of range (" << stack->size() << " frames).\n";
+			return;
+		}
+		cv::Mat frame = stack->frame(index);
+		if (frame.empty()) {
+			out << "Error: Failed to read frame " << index << ".\n";
+			return;
+		}
+		// 当前图像是该页的副本，缓存中的页保持不变
+		workspace = std::make_unique<Workspace>(std::filesystem::u8path(stack->framePath(index)), frame.clone());
+		out << "Frame " << index << " loaded." << std::endl;
+	}
+	else if (args[0] == "apply") {
+		static const std::set<std::string> frame_commands = { "crop", "scale", "flip", "rotate", "translate", "type", "binary", "filter" };
+		if (args.size() < 2 || frame_commands.count(args[1]) == 0) {
+			out << "Error: 'stack apply' requires one of: crop, scale, flip, rotate, translate, type, binary, filter.\n";
+			return;
+		}
+		const std::string command = args[1];
+		const std::vector<std::string> command_args(args.begin() + 2, args.end());
+		std::filesystem::create_directories(std::filesystem::u8path(stack->outputDirectory()));
+
+		// 同时处理的页数不超过缓存页数；页内的分块滤波分摊剩余线程，避免线程数相乘
+		const TileOptions saved_options = TileExecutor::getOptions();
+		const int threads = TileExecutor::threadCount(saved_options);
+		const int frames_in_flight = std::max(1, std::min(threads, static_cast<int>(stack->getCacheCapacity())));
+		TileOptions frame_options = saved_options;
+		frame_options.threads = std::max(1, threads / frames_in_flight);
+		TileExecutor::setOptions(frame_options);
+
+		// 每页的命令输出写入各自的缓冲，全部完成后按页序输出，避免多页的输出交错；
+		// 每页只处理像素，不读取输出目录中已有的标注与掩码文件
+		std::vector<std::string> messages(stack->size());
+		std::atomic<int> written(0);
+		try {
+			stack->forEachFrame([&](int index, cv::Mat& frame) {
+				std::ostringstream frame_out;
+				CommandHandler handler(frame_out);
+				handler.workspace = std::make_unique<Workspace>(std::filesystem::u8path(stack->framePath(index)), frame, false);
+				handler.handleCommand(command, command_args);
+				if (cv::imwrite(stack->framePath(index), handler.workspace->getMyImage().getImageMat())) {
+					++written;
+				}
+				messages[index] = frame_out.str();
+			}, frames_in_flight);
+		}
+		catch (const std::exception& e) {
+			out << "Error: " << e.what() << std::endl;
+		}
+		TileExecutor::setOptions(saved_options);
+
+		for (size_t i = 0; i < messages.size(); ++i) {
+			std::istringstream lines(messages[i]);
+			std::string line;
+			while (std::getline(lines, line)) {
+				out << "Frame " << i << ": " << line << "\n";
+			}
+		}
+
+		out << "Processed " << written.load() << " / " << stack->size() << " frames into " << stack->outputDirectory() << std::endl;
+	}
+	else {
+		out << "Error: Invalid stack command '" << args[0] << "'.\n";
+	}
+}
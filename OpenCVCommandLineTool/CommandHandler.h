@@ -5,17 +5,29 @@
 #define COMMAND_HANDLER_H
 
 
+#include <functional>
+#include <iostream>
 #include "MyImage.h"
 #include "Workspace.h"
+#include "ImageStack.h"
 
 
 class CommandHandler {
 private:
 	std::unique_ptr<Workspace> workspace;
 	std::shared_ptr<YoloModelProcessor> yolo_processor;
+	std::unique_ptr<ImageStack> stack;        // 打开的多页图像栈，与 workspace 相互独立
+	std::ostream& out;                        // 命令的输出；stack apply 的逐页处理写入各页自己的缓冲
+
+	// 在整幅图像或当前选区（外接矩形加 halo）上执行滤波 / 二值操作
+	void runFilter(int halo, const std::function<void(FilterProcessor&)>& op);
+	void runBinary(int halo, const std::function<void(BinaryProcessor&)>& op);
+
+	// 解析 model / batch 的可选参数 “polygons [tolerance]”（从 args[index] 开始）；参数无效时输出错误并返回 false
+	bool parsePolygonOption(const std::vector<std::string>& args, size_t index, bool& polygons, double& tolerance);
 
 public:
-	CommandHandler() = default;
+	explicit CommandHandler(std::ostream& out = std::cout) : out(out) {}
 	void handleCommand(const std::string& command, const std::vector<std::string>& args);
 	void commandHelp() const;
 	void commandEcho(const std::vector<std::string>& args);
@@ -23,7 +35,7 @@ public:
 	void commandLoad(const std::vector<std::string>& args);
 	void commandUnload();
 
-	void commandExport();
+	void commandExport(const std::vector<std::string>& args);
 
 	void commandCrop(const std::vector<std::string>& args);
 	void commandScale(const std::vector<std::string>& args);
@@ -38,6 +50,16 @@ public:
 
 	void commandFilter(const std::vector<std::string>& args);
 
+	void commandHistogram(const std::vector<std::string>& args);
+	void commandProfile(const std::vector<std::string>& args);
+	void commandBenchmark(const std::vector<std::string>& args);
+	void commandTiles(const std::vector<std::string>& args);
+	void commandSelect(const std::vector<std::string>& args);
+	void commandAnalyzeParticles(const std::vector<std::string>& args);
+	void commandMeasure(const std::vector<std::string>& args);
+	void commandPolygonize(const std::vector<std::string>& args);
+	void commandStack(const std::vector<std::string>& args);
+
 	void commandLabel(const std::vector<std::string>& args);
 	void commandModelProcessing(const std::vector<std::string>& args);
 	void commandBatchModelProcessing(const std::vector<std::string>& args);
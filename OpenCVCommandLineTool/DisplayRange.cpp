@@ -0,0 +1,118 @@
+﻿/// ----------------------- DisplayRange -----------------------
+///
+/// 说明：ImageJ 风格的显示范围（min/max/contrast/brightness）；
+///      参数只保存在 MyImage 中，不修改原始像素数据，
+///      仅在显示或导出时通过查找表（LUT）映射为 8 位图像。
+///
+/// ----------------------- DisplayRange -----------------------
+
+#include "DisplayRange.h"
+#include "PixelKernels.h"
+
+#include <algorithm>
+
+namespace {
+
+	// 无法建表的类型（浮点等）直接按公式计算
+	template <typename T>
+	void applyDirect(const cv::Mat& src, cv::Mat& dst, const DisplayMapper& mapper) {
+		const int row_length = src.cols * src.channels();
+		cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& rows) {
+			for (int y = rows.start; y < rows.end; ++y) {
+				const T* in = src.ptr<T>(y);
+				uchar* out = dst.ptr<uchar>(y);
+				for (int i = 0; i < row_length; ++i) {
+					out[i] = cv::saturate_cast<uchar>(mapper.map(static_cast<double>(in[i])));
+				}
+			}
+		});
+	}
+
+}
+
+
+DisplayMapper::DisplayMapper() {
+	setRange(DisplayRange());
+}
+
+/*
+* recommended range:
+minimum / maximum: 数据取值范围内（8 位 [0, 255]，16 位 [0, 65535]）
+contrast: [-127, 127]
+brightness: [-127, 127]
+*/
+void DisplayMapper::setRange(const DisplayRange& display_range) {
+	range = display_range;
+
+	// 计算中间值和范围，用于调整对比度
+	double mid = (range.minimum + range.maximum) / 2.0;
+	double half = (range.maximum - range.minimum) / 2.0 / (range.contrast > 0 ? range.contrast : 1);
+
+	low = std::floor(mid - half);
+	high = std::floor(mid + half);
+	if (low > high) {
+		std::swap(low, high); // 如果最小值大于最大值，交换两者
+	}
+	if (low == high) {
+		high = low + 1;
+	}
+
+	gain = range.contrast / 127 + 1;
+	offset = range.contrast;
+	scale = 255.0 / (high - low);
+
+	// 参数变化后只需重建一次 LUT
+	lut_depth = -1;
+}
+
+const DisplayRange& DisplayMapper::getRange() const {
+	return range;
+}
+
+double DisplayMapper::map(double value) const {
+	double v = value * gain - offset;
+	v = std::min(std::max(v, low), high);
+	return (v - low) * scale + range.brightness;
+}
+
+void DisplayMapper::buildLut(int depth) {
+	int entries = (depth == CV_16U) ? 65536 : 256;
+	lut.create(1, entries, CV_8U);
+	uchar* table = lut.ptr<uchar>();
+	for (int i = 0; i < entries; ++i) {
+		table[i] = cv::saturate_cast<uchar>(map(i));
+	}
+	lut_depth = depth;
+}
+
+void DisplayMapper::render(const cv::Mat& src, cv::Mat& dst) {
+	cv::Mat output(src.size(), CV_8UC(src.channels()));
+
+	switch (src.depth()) {
+	case CV_8U:
+		if (lut_depth != CV_8U) buildLut(CV_8U);
+		kernelApplyLut(src, output, lut);
+		break;
+	case CV_16U:
+		if (lut_depth != CV_16U) buildLut(CV_16U);
+		kernelApplyLut(src, output, lut);
+		break;
+	case CV_16S:
+		applyDirect<short>(src, output, *this);
+		break;
+	case CV_32S:
+		applyDirect<int>(src, output, *this);
+		break;
+	case CV_32F:
+		applyDirect<float>(src, output, *this);
+		break;
+	case CV_64F:
+		applyDirect<double>(src, output, *this);
+		break;
+	default:
+		applyDirect<schar>(src, output, *this);
+		break;
+	}
+
+	dst = output;
+}
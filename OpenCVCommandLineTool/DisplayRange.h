@@ -0,0 +1,55 @@
+﻿/// ----------------------- DisplayRange -----------------------
+///
+/// 说明：ImageJ 风格的显示范围（min/max/contrast/brightness）；
+///      参数只保存在 MyImage 中，不修改原始像素数据，
+///      仅在显示或导出时通过查找表（LUT）映射为 8 位图像。
+///
+///      8 位与 16 位图像使用预先计算的 256 / 65536 项 LUT，单次并行遍历完成映射；
+///      32 位浮点图像按同一线性公式逐像素计算。
+///
+/// ----------------------- DisplayRange -----------------------
+
+#pragma once
+#ifndef DISPLAY_RANGE_H
+#define DISPLAY_RANGE_H
+
+#include <opencv2/opencv.hpp>
+
+/* 显示范围参数 */
+struct DisplayRange {
+	double minimum = 0;      // 显示下限（原始数据单位）
+	double maximum = 255;    // 显示上限（原始数据单位）
+	double contrast = 0;     // 对比度 [-127, 127]
+	double brightness = 0;   // 亮度 [-127, 127]，作用于输出灰度
+};
+
+class DisplayMapper {
+private:
+	DisplayRange range;
+
+	// 由 range 推导出的线性映射参数：out = (clamp(v * gain - offset, low, high) - low) * scale + brightness
+	double gain = 1;
+	double offset = 0;
+	double low = 0;
+	double high = 255;
+	double scale = 1;
+
+	cv::Mat lut;          // 1 x 256 或 1 x 65536 的 CV_8U 查找表
+	int lut_depth = -1;   // lut 对应的图像位深，-1 表示需要重建
+
+	void buildLut(int depth);
+
+public:
+	DisplayMapper();
+
+	void setRange(const DisplayRange& display_range);
+	const DisplayRange& getRange() const;
+
+	// 单个像素值的映射结果（未饱和）
+	double map(double value) const;
+
+	// 将 src 映射为同通道数的 8 位显示图像，src 不会被修改
+	void render(const cv::Mat& src, cv::Mat& dst);
+};
+
+#endif // DISPLAY_RANGE_H
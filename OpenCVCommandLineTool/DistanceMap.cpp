@@ -0,0 +1,128 @@
+﻿/// ----------------------- DistanceMap -----------------------
+///
+/// 说明：可分离的精确 EDM，见 DistanceMap.h。
+///
+/// ----------------------- DistanceMap -----------------------
+
+#include "DistanceMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+
+	const double kInfinity = std::numeric_limits<double>::infinity();
+
+	// 列方向：sites(y, x) 为同列最近背景像素的行号，没有背景时为 -1
+	void nearestRowInColumn(const cv::Mat& mask, cv::Mat& sites) {
+		const int rows = mask.rows;
+		const int cols = mask.cols;
+		const int strips = std::max(1, std::min(cols / 64, 4 * cv::getNumThreads()));
+		cv::parallel_for_(cv::Range(0, strips), [&](const cv::Range& range) {
+			for (int s = range.start; s < range.end; ++s) {
+				const int x0 = cols * s / strips;
+				const int x1 = cols * (s + 1) / strips;
+				std::vector<int> last(x1 - x0, -1);
+				// 自上而下
+				for (int y = 0; y < rows; ++y) {
+					const uchar* m = mask.ptr<uchar>(y);
+					int* site = sites.ptr<int>(y);
+					for (int x = x0; x < x1; ++x) {
+						if (!m[x]) last[x - x0] = y;
+						site[x] = last[x - x0];
+					}
+				}
+				// 自下而上，保留较近的一个
+				std::fill(last.begin(), last.end(), -1);
+				for (int y = rows - 1; y >= 0; --y) {
+					const uchar* m = mask.ptr<uchar>(y);
+					int* site = sites.ptr<int>(y);
+					for (int x = x0; x < x1; ++x) {
+						if (!m[x]) last[x - x0] = y;
+						const int below = last[x - x0];
+						if (below >= 0 && (site[x] < 0 || below - y < y - site[x])) {
+							site[x] = below;
+						}
+					}
+				}
+			}
+		}, strips);
+	}
+
+}
+
+
+void euclideanDistanceMap(const cv::Mat& mask, cv::Mat& dst, cv::Mat* nearest) {
+	CV_Assert(mask.type() == CV_8UC1);
+	if (mask.empty()) {
+		dst = cv::Mat();
+		if (nearest) *nearest = cv::Mat();
+		return;
+	}
+	const int rows = mask.rows;
+	const int cols = mask.cols;
+
+	cv::Mat sites(mask.size(), CV_32SC1);
+	nearestRowInColumn(mask, sites);
+
+	cv::Mat distance(mask.size(), CV_32FC1);
+	cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+		std::vector<double> f(cols), z(cols + 1);
+		std::vector<int> v(cols), site_row(cols);
+		for (int y = range.start; y < range.end; ++y) {
+			int* site = sites.ptr<int>(y);
+			float* d = distance.ptr<float>(y);
+			for (int x = 0; x < cols; ++x) {
+				site_row[x] = site[x];
+				f[x] = (site[x] < 0) ? kInfinity : static_cast<double>(y - site[x]) * (y - site[x]);
+			}
+
+			// 抛物线 (x - q)^2 + f(q) 的下包络；没有背景的列不参与
+			int k = -1;
+			for (int q = 0; q < cols; ++q) {
+				if (f[q] == kInfinity) continue;
+				if (k < 0) {
+					k = 0;
+					v[0] = q;
+					z[0] = -kInfinity;
+					z[1] = kInfinity;
+					continue;
+				}
+				// z[0] = -∞，循环最多退到第一条抛物线
+				double s;
+				while (true) {
+					const int p = v[k];
+					s = ((f[q] + static_cast<double>(q) * q) - (f[p] + static_cast<double>(p) * p)) / (2.0 * (q - p));
+					if (s > z[k]) break;
+					--k;
+				}
+				++k;
+				v[k] = q;
+				z[k] = s;
+				z[k + 1] = kInfinity;
+			}
+
+			if (k < 0) {
+				for (int x = 0; x < cols; ++x) {
+					d[x] = std::numeric_limits<float>::max();
+					site[x] = -1;
+				}
+				continue;
+			}
+			k = 0;
+			for (int x = 0; x < cols; ++x) {
+				while (z[k + 1] < x) ++k;
+				const int p = v[k];
+				d[x] = static_cast<float>(std::sqrt(static_cast<double>(x - p) * (x - p) + f[p]));
+				site[x] = site_row[p] * cols + p;   // 行方向完成后 sites 改存最近背景像素的下标
+			}
+		}
+	});
+
+	dst = distance;
+	if (nearest) {
+		*nearest = sites;
+	}
+}
@@ -0,0 +1,25 @@
+﻿/// ----------------------- DistanceMap -----------------------
+///
+/// 说明：精确欧氏距离映射（EDM），Felzenszwalb-Huttenlocher 可分离算法；
+///
+///      1. 列方向：各列上下各扫描一次，得到同列最近背景像素所在的行，
+///         按列分条并行，每条内逐行访问，内存连续；
+///      2. 行方向：以列方向距离的平方为抛物线高度，求各行抛物线族的下包络，
+///         按行并行；同时记下包络上的抛物线即得最近背景像素（特征变换）。
+///      两步都与像素数成线性关系，结果是精确的欧氏距离，而不是 3x3 / 5x5 掩模的近似值。
+///
+///      图像外不视为背景；整幅图像没有背景像素时距离取 float 的最大值。
+///
+/// ----------------------- DistanceMap -----------------------
+
+#pragma once
+#ifndef DISTANCE_MAP_H
+#define DISTANCE_MAP_H
+
+#include <opencv2/opencv.hpp>
+
+// mask 为 CV_8UC1，非零为前景；dst 为 CV_32FC1，前景像素到最近背景（零）像素的距离
+// nearest 非空时输出 CV_32SC1 的最近背景像素下标 y * cols + x，没有背景时为 -1
+void euclideanDistanceMap(const cv::Mat& mask, cv::Mat& dst, cv::Mat* nearest = nullptr);
+
+#endif // DISTANCE_MAP_H
@@ -1,102 +1,91 @@
 ﻿#include "FilterProcessor.h"
+#include "RankFilters.h"
+#include "LocalStatistics.h"
+#include "KernelConvolution.h"
+#include "RecursiveGaussian.h"
+#include "BackgroundSubtraction.h"
+#include "TileExecutor.h"
 
 FilterProcessor::FilterProcessor(cv::Mat& img) : image_mat(img) {}
 
 
-void FilterProcessor::convolve(const std::string& kernel_str) {
-	// Parse the kernel string into a cv::Mat
-	std::vector<float> kernel_values;
-	std::stringstream ss(kernel_str);
-	std::string line;
-	int rows = 0;
-	while (std::getline(ss, line)) {
-		std::stringstream line_ss(line);
-		float value;
-		while (line_ss >> value) {
-			kernel_values.push_back(value);
-		}
-		rows++;
-	}
-
-	// Assuming square kernel, calculate the size
-	int cols = kernel_values.size() / rows;
-	if (cols * rows != kernel_values.size()) {
+// 核的分析结果（可分离 / FFT / 直接卷积）按文本缓存
+void FilterProcessor::convolve(const std::string& kernel_str, bool normalize) {
+	std::shared_ptr<const AnalyzedKernel> kernel = analyzeKernel(kernel_str, normalize);
+	if (!kernel) {
 		std::cerr << "Invalid kernel format!" << std::endl;
 		return;
 	}
-
-	// Create cv::Mat from the parsed values
-	cv::Mat kernel(rows, cols, CV_32F, kernel_values.data());
-
-	// Apply the kernel to the image
-	cv::filter2D(image_mat, image_mat, -1, kernel);
+	// FFT 路径本身已分块并行，其余按核尺寸的 halo 分块执行
+	if (kernel->strategy == kConvolveFft) {
+		convolveAnalyzed(image_mat, image_mat, *kernel);
+		return;
+	}
+	int halo = std::max(kernel->kernel.rows, kernel->kernel.cols) / 2;
+	TileExecutor::run(image_mat, halo, [kernel](const cv::Mat& in, cv::Mat& out) {
+		convolveAnalyzed(in, out, *kernel);
+	});
 }
 
+// 递归高斯，开销与 sigma 无关
 void FilterProcessor::gaussianBlur(float sigma) {
-	cv::GaussianBlur(image_mat, image_mat, cv::Size(0, 0), sigma);
+	recursiveGaussian(image_mat, image_mat, sigma);
 }
 
-void FilterProcessor::median(float radius) {
-	int kernel_size = static_cast<int>(2 * radius + 1);
-	cv::medianBlur(image_mat, image_mat, kernel_size);
+// 以下邻域滤波均经 TileExecutor 分块执行，halo 等于核半径
+void FilterProcessor::median(float radius, bool circular) {
+	int halo = static_cast<int>(rankKernelLines(radius, circular).size()) / 2;
+	TileExecutor::run(image_mat, halo, [=](const cv::Mat& in, cv::Mat& out) {
+		rankMedian(in, out, radius, circular);
+	});
 }
 
+// 积分图实现，任意半径开销相同；结果为 32 位浮点
 void FilterProcessor::mean(float radius) {
-	int kernel_size = static_cast<int>(2 * radius + 1);
-	cv::blur(image_mat, image_mat, cv::Size(kernel_size, kernel_size));
+	int r = static_cast<int>(radius);
+	TileExecutor::run(image_mat, r, [=](const cv::Mat& in, cv::Mat& out) {
+		LocalStatistics(in).mean(out, r);
+	}, CV_32FC(image_mat.channels()));
 }
 
-void FilterProcessor::minimum(float radius) {
-	int kernel_size = static_cast<int>(2 * radius + 1);
-	cv::Mat element = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(kernel_size, kernel_size));
-	cv::morphologyEx(image_mat, image_mat, cv::MORPH_ERODE, element);
+void FilterProcessor::minimum(float radius, bool circular) {
+	int halo = static_cast<int>(rankKernelLines(radius, circular).size()) / 2;
+	TileExecutor::run(image_mat, halo, [=](const cv::Mat& in, cv::Mat& out) {
+		rankMinimum(in, out, radius, circular);
+	});
 }
 
-void FilterProcessor::maximum(float radius) {
-	int kernel_size = static_cast<int>(2 * radius + 1);
-	cv::Mat element = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(kernel_size, kernel_size));
-	cv::morphologyEx(image_mat, image_mat, cv::MORPH_DILATE, element);
+void FilterProcessor::maximum(float radius, bool circular) {
+	int halo = static_cast<int>(rankKernelLines(radius, circular).size()) / 2;
+	TileExecutor::run(image_mat, halo, [=](const cv::Mat& in, cv::Mat& out) {
+		rankMaximum(in, out, radius, circular);
+	});
 }
 
+// 模糊与加权相减在同一遍中完成，不生成完整的模糊图像
 void FilterProcessor::unsharpMask(float radius, float mask_weight) {
-	cv::Mat blurred;
-	cv::GaussianBlur(image_mat, blurred, cv::Size(0, 0), radius);
-
-	cv::addWeighted(image_mat, 1.0 + mask_weight, blurred, -mask_weight, 0, image_mat);
+	recursiveUnsharpMask(image_mat, image_mat, radius, mask_weight);
 }
 
+// 积分图实现，累加不会溢出；结果为 32 位浮点
 void FilterProcessor::variance(float radius) {
-	int kernel_size = static_cast<int>(2 * radius + 1);
-	cv::Mat mean, squared_mean, variance;
-
-	cv::Mat kernel = cv::Mat::ones(kernel_size, kernel_size, CV_32F) / (kernel_size * kernel_size);
-	cv::filter2D(image_mat, mean, -1, kernel);
-	cv::filter2D(image_mat.mul(image_mat), squared_mean, -1, kernel);
-
-	variance = squared_mean - mean.mul(mean);
-
-	image_mat = variance;
+	int r = static_cast<int>(radius);
+	TileExecutor::run(image_mat, r, [=](const cv::Mat& in, cv::Mat& out) {
+		LocalStatistics(in).variance(out, r);
+	}, CV_32FC(image_mat.channels()));
 }
 
-void FilterProcessor::topHat(float radius, bool light_background, bool dont_subtract) {
-	int kernel_size = static_cast<int>(2 * radius + 1);
-	cv::Mat element = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(kernel_size, kernel_size));
-
-	cv::Mat result;
-
-	if (light_background) {
-		cv::morphologyEx(image_mat, result, cv::MORPH_CLOSE, element);
-		if (!dont_subtract) {
-			result = result - image_mat;
-		}
-	}
-	else {
-		cv::morphologyEx(image_mat, result, cv::MORPH_OPEN, element);
-		if (!dont_subtract) {
-			result = result - image_mat;
-		}
+// 暗背景：原图 - 开运算；亮背景：闭运算 - 原图。fast 时在缩小的图像上做抛物面开运算
+void FilterProcessor::topHat(float radius, bool light_background, bool dont_subtract, bool fast) {
+	if (fast) {
+		subtractBackground(image_mat, image_mat, radius, light_background, kBackgroundFast, dont_subtract);
+		return;
 	}
-	image_mat = result;
+	// 开 / 闭运算为两次半径 r 的滤波
+	int halo = 2 * (static_cast<int>(rankKernelLines(radius, true).size()) / 2);
+	TileExecutor::run(image_mat, halo, [=](const cv::Mat& in, cv::Mat& out) {
+		subtractBackground(in, out, radius, light_background, kBackgroundExact, dont_subtract);
+	});
 }
 
 void FilterProcessor::showCircularMasks() {
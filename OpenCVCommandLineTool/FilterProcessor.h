@@ -12,15 +12,15 @@ private:
 public:
 	FilterProcessor(cv::Mat& img);
 
-	void convolve(const std::string& kernel_str);
+	void convolve(const std::string& kernel_str, bool normalize = false);
 	void gaussianBlur(float sigma);
-	void median(float radius);
+	void median(float radius, bool circular = false);
 	void mean(float radius);
-	void minimum(float radius);
-	void maximum(float radius);
+	void minimum(float radius, bool circular = false);
+	void maximum(float radius, bool circular = false);
 	void unsharpMask(float radius, float mask_weight);
 	void variance(float radius);
-	void topHat(float radius, bool light_background, bool dont_subtract);
+	void topHat(float radius, bool light_background, bool dont_subtract, bool fast = false);
 	void showCircularMasks();
 };
 
@@ -0,0 +1,224 @@
+﻿/// ----------------------- Histogram -----------------------
+///
+/// 说明：并行直方图引擎，见 Histogram.h。
+///
+/// ----------------------- Histogram -----------------------
+
+#include "Histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+namespace {
+
+	/* 整数像素：查表得到区间索引，-1 表示超出范围 */
+	template <typename T>
+	struct LutBinner {
+		const int* lut;
+		int operator()(T v) const { return lut[v]; }
+	};
+
+	/* 浮点像素：线性计算区间索引 */
+	struct LinearBinner {
+		double minimum;
+		double maximum;
+		double scale;
+		int bins;
+		bool inclusive;   // 上限是否包含在最后一个区间内
+
+		int operator()(float v) const {
+			if (!(v >= minimum) || v > maximum || (!inclusive && v == maximum)) {
+				return -1; // 超出范围或 NaN
+			}
+			int bin = static_cast<int>((v - minimum) * scale);
+			return bin < bins ? bin : bins - 1;
+		}
+	};
+
+	std::vector<int> buildBinLut(int entries, double minimum, double maximum, int bins, bool inclusive) {
+		std::vector<int> lut(entries, -1);
+		const double scale = bins / (maximum - minimum);
+		for (int v = 0; v < entries; ++v) {
+			if (v < minimum || v > maximum || (!inclusive && v == maximum)) {
+				continue;
+			}
+			int bin = static_cast<int>((v - minimum) * scale);
+			lut[v] = bin < bins ? bin : bins - 1;
+		}
+		return lut;
+	}
+
+	// 在 [y0, y1) 行上累加到线程私有直方图 local（按 channel * bins + bin 排列）
+	template <typename T, typename Binner, bool UseMask>
+	void accumulateRows(const cv::Mat& image, const cv::Mat& mask, int y0, int y1,
+		const Binner& binner, int bins, uint32_t* local) {
+		const int cn = image.channels();
+		for (int y = y0; y < y1; ++y) {
+			const T* p = image.ptr<T>(y);
+			const uchar* m = UseMask ? mask.ptr<uchar>(y) : nullptr;
+			for (int x = 0; x < image.cols; ++x, p += cn) {
+				if (UseMask && !m[x]) {
+					continue;
+				}
+				for (int c = 0; c < cn; ++c) {
+					int bin = binner(p[c]);
+					if (bin >= 0) {
+						++local[c * bins + bin];
+					}
+				}
+			}
+		}
+	}
+
+	template <typename T, typename Binner>
+	void parallelHistogram(const cv::Mat& image, const cv::Mat& mask, const Binner& binner,
+		int bins, std::vector<std::vector<uint64_t>>& counts) {
+		const int cn = image.channels();
+		std::mutex merge_mutex;
+
+		// 每个线程处理一个连续的行带，私有直方图在结束时合并一次
+		cv::parallel_for_(cv::Range(0, image.rows), [&](const cv::Range& rows) {
+			std::vector<uint32_t> local(static_cast<size_t>(cn) * bins, 0);
+			if (mask.empty()) {
+				accumulateRows<T, Binner, false>(image, mask, rows.start, rows.end, binner, bins, local.data());
+			}
+			else {
+				accumulateRows<T, Binner, true>(image, mask, rows.start, rows.end, binner, bins, local.data());
+			}
+
+			std::lock_guard<std::mutex> lock(merge_mutex);
+			for (int c = 0; c < cn; ++c) {
+				for (int b = 0; b < bins; ++b) {
+					counts[c][b] += local[c * bins + b];
+				}
+			}
+		}, cv::getNumThreads());
+	}
+
+	// 掩码内的数据范围（用于浮点图像的自动范围）
+	void dataRange(const cv::Mat& image, const cv::Mat& mask, double& minimum, double& maximum) {
+		const int cn = image.channels();
+		float lo = std::numeric_limits<float>::max();
+		float hi = std::numeric_limits<float>::lowest();
+		std::mutex merge_mutex;
+
+		cv::parallel_for_(cv::Range(0, image.rows), [&](const cv::Range& rows) {
+			float local_lo = std::numeric_limits<float>::max();
+			float local_hi = std::numeric_limits<float>::lowest();
+			for (int y = rows.start; y < rows.end; ++y) {
+				const float* p = image.ptr<float>(y);
+				const uchar* m = mask.empty() ? nullptr : mask.ptr<uchar>(y);
+				for (int x = 0; x < image.cols; ++x, p += cn) {
+					if (m && !m[x]) {
+						continue;
+					}
+					for (int c = 0; c < cn; ++c) {
+						if (std::isnan(p[c])) continue;
+						local_lo = std::min(local_lo, p[c]);
+						local_hi = std::max(local_hi, p[c]);
+					}
+				}
+			}
+			std::lock_guard<std::mutex> lock(merge_mutex);
+			lo = std::min(lo, local_lo);
+			hi = std::max(hi, local_hi);
+		}, cv::getNumThreads());
+
+		if (lo > hi) {
+			lo = hi = 0; // 没有有效像素
+		}
+		minimum = lo;
+		maximum = hi;
+	}
+
+}
+
+
+int HistogramResult::channels() const {
+	return static_cast<int>(counts.size());
+}
+
+uint64_t HistogramResult::total(int channel) const {
+	uint64_t sum = 0;
+	for (uint64_t count : counts[channel]) {
+		sum += count;
+	}
+	return sum;
+}
+
+
+HistogramResult computeHistogram(const cv::Mat& image, const HistogramOptions& options) {
+	HistogramResult result;
+	if (image.empty() || options.bins <= 0) {
+		return result;
+	}
+
+	// 统计区域与掩码
+	cv::Rect full(0, 0, image.cols, image.rows);
+	cv::Rect roi = options.roi.empty() ? full : (options.roi & full);
+	cv::Mat region = image(roi);
+	cv::Mat mask;
+	if (!options.mask.empty()) {
+		mask = (options.mask.size() == image.size()) ? options.mask(roi) : options.mask;
+		if (mask.size() != region.size() || mask.type() != CV_8UC1) {
+			std::cerr << "Error: Histogram mask must be CV_8UC1 and match the image or ROI size." << std::endl;
+			return result;
+		}
+	}
+
+	// 8U / 16U / 32F 直接统计，其余位深先转换为 32F
+	if (region.depth() != CV_8U && region.depth() != CV_16U && region.depth() != CV_32F) {
+		region.convertTo(region, CV_32F);
+	}
+
+	// 确定取值范围：自动范围时上限包含在最后一个区间
+	double minimum = options.minimum;
+	double maximum = options.maximum;
+	bool inclusive = false;
+	if (maximum <= minimum) {
+		if (region.depth() == CV_8U) {
+			minimum = 0;
+			maximum = 256;
+		}
+		else if (region.depth() == CV_16U) {
+			minimum = 0;
+			maximum = 65536;
+		}
+		else {
+			dataRange(region, mask, minimum, maximum);
+			inclusive = true;
+			if (maximum <= minimum) {
+				maximum = minimum + 1;
+			}
+		}
+	}
+
+	const int bins = options.bins;
+	result.bins = bins;
+	result.minimum = minimum;
+	result.maximum = maximum;
+	result.bin_width = (maximum - minimum) / bins;
+	result.counts.assign(region.channels(), std::vector<uint64_t>(bins, 0));
+
+	switch (region.depth()) {
+	case CV_8U: {
+		std::vector<int> lut = buildBinLut(256, minimum, maximum, bins, inclusive);
+		parallelHistogram<uchar>(region, mask, LutBinner<uchar>{ lut.data() }, bins, result.counts);
+		break;
+	}
+	case CV_16U: {
+		std::vector<int> lut = buildBinLut(65536, minimum, maximum, bins, inclusive);
+		parallelHistogram<ushort>(region, mask, LutBinner<ushort>{ lut.data() }, bins, result.counts);
+		break;
+	}
+	default: {
+		LinearBinner binner{ minimum, maximum, bins / (maximum - minimum), bins, inclusive };
+		parallelHistogram<float>(region, mask, binner, bins, result.counts);
+		break;
+	}
+	}
+
+	return result;
+}
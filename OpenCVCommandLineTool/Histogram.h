@@ -0,0 +1,42 @@
+﻿/// ----------------------- Histogram -----------------------
+///
+/// 说明：并行直方图引擎；
+///      支持 8U / 16U / 32F 以及多通道图像，按通道分别统计，
+///      直方图的区间数与取值范围可配置，可限定在 ROI 或掩码内统计。
+///
+///      并行方式：按行分块，每个线程维护私有直方图，最后合并，避免原子操作与伪共享。
+///      整数图像预先建立 “像素值 -> 区间” 查找表，内层循环只剩一次查表与一次累加。
+///
+/// ----------------------- Histogram -----------------------
+
+#pragma once
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+struct HistogramOptions {
+	int bins = 256;           // 区间数
+	double minimum = 0;       // 取值下限（含）
+	double maximum = 0;       // 取值上限（不含）；maximum <= minimum 时按位深自动确定
+	cv::Rect roi;             // 统计区域，空矩形表示整幅图像
+	cv::Mat mask;             // 可选 CV_8UC1 掩码，尺寸与整幅图像或 roi 相同，非零处参与统计
+};
+
+struct HistogramResult {
+	int bins = 0;
+	double minimum = 0;
+	double maximum = 0;
+	double bin_width = 0;
+	std::vector<std::vector<uint64_t>> counts;   // counts[channel][bin]
+
+	int channels() const;
+	uint64_t total(int channel) const;           // 某通道参与统计的像素数
+};
+
+// 计算直方图；未指定范围时：8U 为 [0, 256)，16U 为 [0, 65536)，32F 为数据的 [min, max]
+HistogramResult computeHistogram(const cv::Mat& image, const HistogramOptions& options = HistogramOptions());
+
+#endif // HISTOGRAM_H
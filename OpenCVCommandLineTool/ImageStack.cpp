@@ -0,0 +1,133 @@
+﻿/// ----------------------- ImageStack -----------------------
+///
+/// 说明：多页 TIFF 的按页读取与 LRU 缓存，见 ImageStack.h。
+///
+/// ----------------------- ImageStack -----------------------
+
+#include "ImageStack.h"
+#include "TileExecutor.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+ImageStack::ImageStack(const std::string& path, size_t cache_capacity)
+	: path(path),
+	cache_capacity(std::max<size_t>(1, cache_capacity)) {
+	frame_count = static_cast<int>(cv::imcount(path, cv::IMREAD_UNCHANGED));
+}
+
+const std::string& ImageStack::getPath() const {
+	return path;
+}
+
+int ImageStack::size() const {
+	return frame_count;
+}
+
+bool ImageStack::empty() const {
+	return frame_count == 0;
+}
+
+size_t ImageStack::getCacheCapacity() const {
+	return cache_capacity;
+}
+
+void ImageStack::setCacheCapacity(size_t capacity) {
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	cache_capacity = std::max<size_t>(1, capacity);
+	while (cache.size() > cache_capacity) {
+		cache_index.erase(cache.back().first);
+		cache.pop_back();
+	}
+}
+
+// 只解码第 index 页，保留原始位深与通道数
+cv::Mat ImageStack::readFrame(int index) const {
+	std::vector<cv::Mat> pages;
+	if (!cv::imreadmulti(path, pages, index, 1, cv::IMREAD_UNCHANGED) || pages.empty()) {
+		return cv::Mat();
+	}
+	return pages[0];
+}
+
+cv::Mat ImageStack::frame(int index) {
+	if (index < 0 || index >= frame_count) {
+		return cv::Mat();
+	}
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		auto it = cache_index.find(index);
+		if (it != cache_index.end()) {
+			cache.splice(cache.begin(), cache, it->second);
+			return it->second->second;
+		}
+	}
+
+	// 解码不持有锁，多个线程可同时读取不同的页
+	cv::Mat page = readFrame(index);
+	if (page.empty()) {
+		return page;
+	}
+
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	if (cache_index.count(index) == 0) {
+		cache.emplace_front(index, page);
+		cache_index[index] = cache.begin();
+		if (cache.size() > cache_capacity) {
+			cache_index.erase(cache.back().first);
+			cache.pop_back();
+		}
+	}
+	return page;
+}
+
+std::string ImageStack::outputDirectory() const {
+	std::filesystem::path p = std::filesystem::u8path(path);
+	return (p.parent_path() / (p.stem().string() + "_frames")).string();
+}
+
+std::string ImageStack::framePath(int index) const {
+	std::ostringstream name;
+	name << std::filesystem::u8path(path).stem().string() << "_" << std::setw(4) << std::setfill('0') << index << ".tiff";
+	return (std::filesystem::path(outputDirectory()) / name.str()).string();
+}
+
+void ImageStack::forEachFrame(const std::function<void(int, cv::Mat&)>& op, int frames_in_flight) const {
+	if (frame_count == 0) {
+		return;
+	}
+	// 每个线程一次只持有一页；区段数取线程数的数倍，处理较慢的区段可由其他线程分担剩余区段
+	const int workers = std::max(1, frames_in_flight);
+	const int chunk_count = std::min(frame_count, workers * 4);
+	runWorkStealing(chunk_count, workers, [&](int chunk) {
+		const int begin = static_cast<int>(static_cast<int64_t>(frame_count) * chunk / chunk_count);
+		const int end = static_cast<int>(static_cast<int64_t>(frame_count) * (chunk + 1) / chunk_count);
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 7)
+		// ImageCollection 记住解码器的当前页，递增访问只需前进一页；releaseCache 后页数据只由 page 持有
+		cv::ImageCollection pages(path, cv::IMREAD_UNCHANGED);
+		auto read = [&](int index) {
+			cv::Mat page = pages.at(index);
+			pages.releaseCache(index);
+			return page;
+		};
+#else
+		auto read = [&](int index) { return readFrame(index); };
+#endif
+		for (int index = begin; index < end; ++index) {
+			cv::Mat page;
+			try {
+				page = read(index);
+			}
+			catch (const cv::Exception&) {
+			}
+			if (page.empty()) {
+				std::cerr << "Error: Failed to read frame " << index << " of " << path << std::endl;
+				continue;
+			}
+			op(index, page);
+		}
+	});
+}
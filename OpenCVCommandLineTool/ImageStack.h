@@ -0,0 +1,60 @@
+﻿/// ----------------------- ImageStack -----------------------
+///
+/// 说明：多页 TIFF 图像栈（共聚焦 Z 栈、延时序列）；
+///      打开时只读取页数，不读取像素；每次按需用 cv::imreadmulti 读取单页，
+///      最近使用的若干页保存在 LRU 缓存中，因此内存占用只与缓存页数有关，与栈的页数无关。
+///
+///      forEachFrame 逐页并行执行操作：同时在处理中的页数有上限，每页读取、处理、写出后即释放。
+///      页按连续的区段分给各线程，区段内顺序解码（cv::ImageCollection），
+///      不必像单页读取那样每页都从第 0 页走起，整遍处理的解码开销与页数成线性。
+///      逐页结果写入 `<目录>/<文件名>_frames/<文件名>_0000.tiff`，标注与掩码文件随之按页保存。
+///
+/// ----------------------- ImageStack -----------------------
+
+#pragma once
+#ifndef IMAGE_STACK_H
+#define IMAGE_STACK_H
+
+#include <opencv2/opencv.hpp>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+class ImageStack {
+private:
+	std::string path;
+	int frame_count = 0;
+	size_t cache_capacity;
+
+	std::mutex cache_mutex;
+	std::list<std::pair<int, cv::Mat>> cache;                                   // 最近使用的页在前
+	std::map<int, std::list<std::pair<int, cv::Mat>>::iterator> cache_index;
+
+	cv::Mat readFrame(int index) const;
+
+public:
+	// 只读取页数；页数为 0 表示文件无法读取
+	ImageStack(const std::string& path, size_t cache_capacity = 4);
+
+	const std::string& getPath() const;
+	int size() const;
+	bool empty() const;
+	size_t getCacheCapacity() const;
+	void setCacheCapacity(size_t capacity);
+
+	// 第 index 页（经缓存）；返回的 Mat 与缓存共享数据，修改前需 clone
+	cv::Mat frame(int index);
+
+	// 逐页结果的输出目录与第 index 页的输出路径
+	std::string outputDirectory() const;
+	std::string framePath(int index) const;
+
+	// 逐页并行执行 op(index, frame)，最多 frames_in_flight 页同时在内存中；frame 为独立的副本，不经缓存；
+	// 同一区段内的页按序号递增的顺序交给 op
+	void forEachFrame(const std::function<void(int, cv::Mat&)>& op, int frames_in_flight) const;
+};
+
+#endif // IMAGE_STACK_H
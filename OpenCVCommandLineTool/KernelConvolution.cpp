@@ -0,0 +1,225 @@
+﻿/// ----------------------- KernelConvolution -----------------------
+///
+/// 说明：自动选择实现方式的任意核卷积，见 KernelConvolution.h。
+///
+/// ----------------------- KernelConvolution -----------------------
+
+#include "KernelConvolution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+namespace {
+
+	// 奇异值小于最大奇异值的该比例时视为 0
+	const double kRankTolerance = 1e-5;
+
+	// FFT 分块的最小边长
+	const int kMinDftSize = 256;
+
+	// 每像素的估计开销（乘加次数）
+	double directCost(const cv::Mat& kernel) {
+		return static_cast<double>(kernel.rows) * kernel.cols;
+	}
+
+	double separableCost(const cv::Mat& kernel, int rank) {
+		return static_cast<double>(rank) * (kernel.rows + kernel.cols + 1);
+	}
+
+	// 正反两次 N x N 变换与一次频谱乘法，摊到每个分块的有效输出像素上
+	double fftCost(const cv::Mat& kernel, int dft_size) {
+		double n2 = static_cast<double>(dft_size) * dft_size;
+		double valid = static_cast<double>(dft_size - kernel.rows + 1) * (dft_size - kernel.cols + 1);
+		return 3.0 * n2 * std::log2(n2) / valid;
+	}
+
+	void convolveSeparable(const cv::Mat& src, cv::Mat& dst, const AnalyzedKernel& kernel) {
+		cv::Mat sum, pass;
+		for (size_t i = 0; i < kernel.row_kernels.size(); ++i) {
+			cv::sepFilter2D(src, i == 0 ? sum : pass, CV_32F, kernel.row_kernels[i], kernel.column_kernels[i]);
+			if (i > 0) {
+				sum += pass;
+			}
+		}
+		sum.convertTo(dst, src.depth());
+	}
+
+	// overlap-save：每个分块读取输出区域加上核尺寸的边缘，变换后只保留无回绕的部分；分块之间互不重叠，可并行写出
+	void convolveFftPlane(const cv::Mat& plane, cv::Mat& output, const AnalyzedKernel& kernel) {
+		const int kr = kernel.kernel.rows;
+		const int kc = kernel.kernel.cols;
+		const int ay = kr / 2;
+		const int ax = kc / 2;
+		const int n = kernel.dft_size;
+		const int tile_h = n - kr + 1;
+		const int tile_w = n - kc + 1;
+
+		// 与 filter2D 的默认边界一致
+		cv::Mat padded;
+		cv::copyMakeBorder(plane, padded, ay, kr - 1 - ay, ax, kc - 1 - ax, cv::BORDER_REFLECT_101);
+
+		const int tiles_y = (plane.rows + tile_h - 1) / tile_h;
+		const int tiles_x = (plane.cols + tile_w - 1) / tile_w;
+		output.create(plane.size(), CV_32FC1);
+
+		cv::parallel_for_(cv::Range(0, tiles_y * tiles_x), [&](const cv::Range& range) {
+			cv::Mat buffer(n, n, CV_32FC1);
+			cv::Mat frequency, result;
+			for (int t = range.start; t < range.end; ++t) {
+				const int oy = (t / tiles_x) * tile_h;
+				const int ox = (t % tiles_x) * tile_w;
+				const int h = std::min(tile_h, plane.rows - oy);
+				const int w = std::min(tile_w, plane.cols - ox);
+
+				buffer.setTo(0);
+				padded(cv::Rect(ox, oy, w + kc - 1, h + kr - 1)).copyTo(buffer(cv::Rect(0, 0, w + kc - 1, h + kr - 1)));
+				cv::dft(buffer, frequency);
+				// 乘以核频谱的共轭即为相关运算
+				cv::mulSpectrums(frequency, kernel.spectrum, frequency, 0, true);
+				cv::idft(frequency, result, cv::DFT_SCALE | cv::DFT_REAL_OUTPUT);
+				result(cv::Rect(0, 0, w, h)).copyTo(output(cv::Rect(ox, oy, w, h)));
+			}
+		});
+	}
+
+	void convolveFft(const cv::Mat& src, cv::Mat& dst, const AnalyzedKernel& kernel) {
+		std::vector<cv::Mat> planes;
+		cv::split(src, planes);
+		for (cv::Mat& plane : planes) {
+			cv::Mat input, output;
+			plane.convertTo(input, CV_32F);
+			convolveFftPlane(input, output, kernel);
+			plane = output;
+		}
+		cv::Mat merged;
+		cv::merge(planes, merged);
+		merged.convertTo(dst, src.depth());
+	}
+
+	std::shared_ptr<AnalyzedKernel> analyze(const cv::Mat& kernel) {
+		auto analyzed = std::make_shared<AnalyzedKernel>();
+		analyzed->kernel = kernel;
+
+		cv::Mat w, u, vt;
+		cv::Mat kernel64;
+		kernel.convertTo(kernel64, CV_64F);
+		cv::SVD::compute(kernel64, w, u, vt);
+		const double largest = w.at<double>(0);
+		for (int i = 0; i < w.rows; ++i) {
+			if (largest > 0 && w.at<double>(i) > largest * kRankTolerance) {
+				++analyzed->rank;
+			}
+		}
+
+		const int dft_size = cv::getOptimalDFTSize(std::max(kMinDftSize, 4 * std::max(kernel.rows, kernel.cols)));
+		const double direct = directCost(kernel);
+		const double separable = separableCost(kernel, analyzed->rank);
+		const double fft = fftCost(kernel, dft_size);
+
+		if (analyzed->rank > 0 && separable < direct && separable <= fft) {
+			// 秩 r 分解：kernel = Σ s_i * u_i * v_i^T，奇异值平均分配到两个一维核
+			analyzed->strategy = kConvolveSeparable;
+			for (int i = 0; i < analyzed->rank; ++i) {
+				double scale = std::sqrt(w.at<double>(i));
+				cv::Mat column = u.col(i) * scale;
+				cv::Mat row = vt.row(i) * scale;
+				analyzed->column_kernels.push_back(cv::Mat());
+				analyzed->row_kernels.push_back(cv::Mat());
+				column.convertTo(analyzed->column_kernels.back(), CV_32F);
+				row.convertTo(analyzed->row_kernels.back(), CV_32F);
+			}
+		}
+		else if (fft < direct) {
+			analyzed->strategy = kConvolveFft;
+			analyzed->dft_size = dft_size;
+			cv::Mat padded = cv::Mat::zeros(dft_size, dft_size, CV_32FC1);
+			kernel.copyTo(padded(cv::Rect(0, 0, kernel.cols, kernel.rows)));
+			cv::dft(padded, analyzed->spectrum);
+		}
+		else {
+			analyzed->strategy = kConvolveDirect;
+		}
+		return analyzed;
+	}
+
+}
+
+
+bool parseKernel(const std::string& kernel_str, cv::Mat& kernel) {
+	std::vector<float> kernel_values;
+	std::stringstream ss(kernel_str);
+	std::string line;
+	int rows = 0;
+	while (std::getline(ss, line)) {
+		std::stringstream line_ss(line);
+		size_t before = kernel_values.size();
+		float value;
+		while (line_ss >> value) {
+			kernel_values.push_back(value);
+		}
+		if (!line_ss.eof()) {
+			return false; // 非数字
+		}
+		if (kernel_values.size() > before) {
+			rows++; // 忽略空行
+		}
+	}
+
+	if (rows == 0) {
+		return false;
+	}
+	int cols = static_cast<int>(kernel_values.size()) / rows;
+	if (cols * rows != static_cast<int>(kernel_values.size())) {
+		return false;
+	}
+
+	cv::Mat(rows, cols, CV_32F, kernel_values.data()).copyTo(kernel);
+	return true;
+}
+
+std::shared_ptr<const AnalyzedKernel> analyzeKernel(const std::string& kernel_str, bool normalize) {
+	static std::map<std::string, std::shared_ptr<const AnalyzedKernel>> cache;
+	static std::mutex cache_mutex;
+
+	const std::string key = (normalize ? "n:" : "r:") + kernel_str;
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		auto it = cache.find(key);
+		if (it != cache.end()) {
+			return it->second;
+		}
+	}
+
+	cv::Mat kernel;
+	if (!parseKernel(kernel_str, kernel)) {
+		return nullptr;
+	}
+	if (normalize) {
+		double sum = cv::sum(kernel)[0];
+		if (sum != 0) {
+			kernel /= sum;
+		}
+	}
+
+	std::shared_ptr<const AnalyzedKernel> analyzed = analyze(kernel);
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	cache[key] = analyzed;
+	return analyzed;
+}
+
+void convolveAnalyzed(const cv::Mat& src, cv::Mat& dst, const AnalyzedKernel& kernel) {
+	switch (kernel.strategy) {
+	case kConvolveSeparable:
+		convolveSeparable(src, dst, kernel);
+		break;
+	case kConvolveFft:
+		convolveFft(src, dst, kernel);
+		break;
+	default:
+		cv::filter2D(src, dst, -1, kernel.kernel);
+		break;
+	}
+}
@@ -0,0 +1,52 @@
+﻿/// ----------------------- KernelConvolution -----------------------
+///
+/// 说明：自动选择实现方式的任意核卷积（语义与 cv::filter2D 相同：相关运算，锚点在核中心）；
+///      核在解析时做一次 SVD 分析：
+///      1. 秩为 1：分解为列向量 × 行向量，两遍一维滤波；
+///      2. 低秩：分解为若干可分离核之和，逐个一维滤波后累加；
+///      3. 大而稠密的核：分块 FFT（overlap-save），核的频谱只计算一次；
+///      4. 其余：直接调用 filter2D。
+///      按每像素的估计开销选择其中最便宜的一种。
+///      分析结果按核文本缓存，重复执行同一个核时不再解析与分解。
+///
+/// ----------------------- KernelConvolution -----------------------
+
+#pragma once
+#ifndef KERNEL_CONVOLUTION_H
+#define KERNEL_CONVOLUTION_H
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum ConvolutionStrategy {
+	kConvolveDirect,
+	kConvolveSeparable,
+	kConvolveFft
+};
+
+struct AnalyzedKernel {
+	cv::Mat kernel;                     // CV_32F
+	int rank = 0;                       // 数值秩
+	ConvolutionStrategy strategy = kConvolveDirect;
+
+	// kConvolveSeparable：kernel = Σ column_kernels[i] * row_kernels[i]^T
+	std::vector<cv::Mat> column_kernels;
+	std::vector<cv::Mat> row_kernels;
+
+	// kConvolveFft：dft_size x dft_size 的核频谱（CCS 格式）
+	int dft_size = 0;
+	cv::Mat spectrum;
+};
+
+// 解析核文本：每行一行核，数值以空白分隔；失败时返回 false
+bool parseKernel(const std::string& kernel_str, cv::Mat& kernel);
+
+// 解析并分析核，结果按 (文本, normalize) 缓存；解析失败时返回空指针
+std::shared_ptr<const AnalyzedKernel> analyzeKernel(const std::string& kernel_str, bool normalize = false);
+
+// 按分析结果卷积，输出位深与输入相同
+void convolveAnalyzed(const cv::Mat& src, cv::Mat& dst, const AnalyzedKernel& kernel);
+
+#endif // KERNEL_CONVOLUTION_H
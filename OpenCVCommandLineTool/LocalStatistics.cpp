@@ -0,0 +1,170 @@
+﻿/// ----------------------- LocalStatistics -----------------------
+///
+/// 说明：基于积分图的局部均值、方差，见 LocalStatistics.h。
+///
+/// ----------------------- LocalStatistics -----------------------
+
+#include "LocalStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+	// 两遍构建积分图：先按行求前缀和（行间并行），再按列累加（列条带并行）
+	template <typename T, typename Acc>
+	void buildTables(const cv::Mat& image, std::vector<Acc>& sum, std::vector<Acc>& sq_sum) {
+		const int rows = image.rows;
+		const int cn = image.channels();
+		const size_t stride = static_cast<size_t>(image.cols + 1) * cn;
+		sum.assign(stride * (rows + 1), 0);
+		sq_sum.assign(stride * (rows + 1), 0);
+
+		cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+			for (int y = range.start; y < range.end; ++y) {
+				const T* p = image.ptr<T>(y);
+				Acc* s = &sum[(y + 1) * stride];
+				Acc* q = &sq_sum[(y + 1) * stride];
+				for (int i = 0; i < image.cols * cn; ++i) {
+					Acc v = static_cast<Acc>(p[i]);
+					s[i + cn] = s[i] + v;
+					q[i + cn] = q[i] + v * v;
+				}
+			}
+		});
+
+		cv::parallel_for_(cv::Range(0, static_cast<int>(stride)), [&](const cv::Range& range) {
+			for (int y = 2; y <= rows; ++y) {
+				Acc* s = &sum[y * stride];
+				Acc* q = &sq_sum[y * stride];
+				const Acc* s_prev = s - stride;
+				const Acc* q_prev = q - stride;
+				for (int i = range.start; i < range.end; ++i) {
+					s[i] += s_prev[i];
+					q[i] += q_prev[i];
+				}
+			}
+		}, cv::getNumThreads());
+	}
+
+	// 逐像素查询窗口内的和与平方和，out(y, x, c, mean, variance) 写出结果
+	template <typename Acc, typename Out>
+	void queryTables(const std::vector<Acc>& sum, const std::vector<Acc>& sq_sum, cv::Size size, int cn, int radius, const Out& out) {
+		const size_t stride = static_cast<size_t>(size.width + 1) * cn;
+		cv::parallel_for_(cv::Range(0, size.height), [&](const cv::Range& range) {
+			for (int y = range.start; y < range.end; ++y) {
+				const int y0 = std::max(y - radius, 0);
+				const int y1 = std::min(y + radius + 1, size.height);
+				const Acc* s0 = &sum[y0 * stride];
+				const Acc* s1 = &sum[y1 * stride];
+				const Acc* q0 = &sq_sum[y0 * stride];
+				const Acc* q1 = &sq_sum[y1 * stride];
+				for (int x = 0; x < size.width; ++x) {
+					const int x0 = std::max(x - radius, 0);
+					const int x1 = std::min(x + radius + 1, size.width);
+					const double area = static_cast<double>(y1 - y0) * (x1 - x0);
+					for (int c = 0; c < cn; ++c) {
+						const size_t a = x0 * cn + c;
+						const size_t b = x1 * cn + c;
+						// 整数积分图相减是精确的，转换为 double 后再求方差
+						const double s = static_cast<double>(s1[b] - s1[a] - s0[b] + s0[a]);
+						const double q = static_cast<double>(q1[b] - q1[a] - q0[b] + q0[a]);
+						const double mean = s / area;
+						const double variance = std::max(0.0, (q - s * mean) / area);
+						out(y, x * cn + c, mean, variance);
+					}
+				}
+			}
+		});
+	}
+
+}
+
+
+LocalStatistics::LocalStatistics(const cv::Mat& image) {
+	build(image);
+}
+
+void LocalStatistics::build(const cv::Mat& image) {
+	size = image.size();
+	channels = image.channels();
+	int_sum.clear();
+	int_sq_sum.clear();
+	float_sum.clear();
+	float_sq_sum.clear();
+
+	switch (image.depth()) {
+	case CV_8U:
+		integer_tables = true;
+		buildTables<uchar, int64_t>(image, int_sum, int_sq_sum);
+		break;
+	case CV_16U:
+		integer_tables = true;
+		buildTables<ushort, int64_t>(image, int_sum, int_sq_sum);
+		break;
+	case CV_16S:
+		integer_tables = true;
+		buildTables<short, int64_t>(image, int_sum, int_sq_sum);
+		break;
+	case CV_32F:
+		integer_tables = false;
+		buildTables<float, double>(image, float_sum, float_sq_sum);
+		break;
+	default: {
+		integer_tables = false;
+		cv::Mat converted;
+		image.convertTo(converted, CV_64F);
+		buildTables<double, double>(converted, float_sum, float_sq_sum);
+		break;
+	}
+	}
+}
+
+bool LocalStatistics::empty() const {
+	return channels == 0 || size.area() == 0;
+}
+
+void LocalStatistics::mean(cv::Mat& dst, int radius) const {
+	cv::Mat output(size, CV_32FC(channels));
+	auto write = [&](int y, int i, double mean, double) {
+		output.ptr<float>(y)[i] = static_cast<float>(mean);
+	};
+	if (integer_tables) {
+		queryTables(int_sum, int_sq_sum, size, channels, radius, write);
+	}
+	else {
+		queryTables(float_sum, float_sq_sum, size, channels, radius, write);
+	}
+	dst = output;
+}
+
+void LocalStatistics::variance(cv::Mat& dst, int radius) const {
+	cv::Mat output(size, CV_32FC(channels));
+	auto write = [&](int y, int i, double, double variance) {
+		output.ptr<float>(y)[i] = static_cast<float>(variance);
+	};
+	if (integer_tables) {
+		queryTables(int_sum, int_sq_sum, size, channels, radius, write);
+	}
+	else {
+		queryTables(float_sum, float_sq_sum, size, channels, radius, write);
+	}
+	dst = output;
+}
+
+void LocalStatistics::meanStdDev(cv::Mat& mean_dst, cv::Mat& stddev_dst, int radius) const {
+	cv::Mat mean_output(size, CV_32FC(channels));
+	cv::Mat stddev_output(size, CV_32FC(channels));
+	auto write = [&](int y, int i, double mean, double variance) {
+		mean_output.ptr<float>(y)[i] = static_cast<float>(mean);
+		stddev_output.ptr<float>(y)[i] = static_cast<float>(std::sqrt(variance));
+	};
+	if (integer_tables) {
+		queryTables(int_sum, int_sq_sum, size, channels, radius, write);
+	}
+	else {
+		queryTables(float_sum, float_sq_sum, size, channels, radius, write);
+	}
+	mean_dst = mean_output;
+	stddev_dst = stddev_output;
+}
@@ -0,0 +1,47 @@
+﻿/// ----------------------- LocalStatistics -----------------------
+///
+/// 说明：基于积分图（summed-area table）的局部统计量；
+///      对图像及其平方各建一张积分图，任意半径的方形窗口内的和只需 4 次查表，
+///      每像素开销与半径无关。
+///      整数图像（8U / 16U / 16S）以 int64 精确累加，避免大图上相减时的精度损失；
+///      其余位深以 double 累加。窗口在图像边缘处裁剪，按实际像素数求平均。
+///      结果为 CV_32F，通道数与输入相同。
+///
+///      用于均值 / 方差滤波以及 Niblack、Sauvola 等局部阈值。
+///
+/// ----------------------- LocalStatistics -----------------------
+
+#pragma once
+#ifndef LOCAL_STATISTICS_H
+#define LOCAL_STATISTICS_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+class LocalStatistics {
+private:
+	cv::Size size;
+	int channels = 0;
+	bool integer_tables = true;           // true 时使用 int64 积分图
+
+	// (rows + 1) x (cols + 1) x channels，第 0 行 / 列为 0
+	std::vector<int64_t> int_sum;
+	std::vector<int64_t> int_sq_sum;
+	std::vector<double> float_sum;
+	std::vector<double> float_sq_sum;
+
+public:
+	LocalStatistics() = default;
+	explicit LocalStatistics(const cv::Mat& image);
+
+	void build(const cv::Mat& image);
+	bool empty() const;
+
+	// 边长为 2 * radius + 1 的方形窗口
+	void mean(cv::Mat& dst, int radius) const;
+	void variance(cv::Mat& dst, int radius) const;                            // 总体方差
+	void meanStdDev(cv::Mat& mean_dst, cv::Mat& stddev_dst, int radius) const;
+};
+
+#endif // LOCAL_STATISTICS_H
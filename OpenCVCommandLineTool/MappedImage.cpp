@@ -0,0 +1,336 @@
+﻿/// ----------------------- MappedImage -----------------------
+///
+/// 说明：未压缩图像文件的内存映射加载，见 MappedImage.h。
+///
+/// ----------------------- MappedImage -----------------------
+
+#include "MappedImage.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// ----------------------- 文件映射 -----------------------
+
+#ifdef _WIN32
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path) {
+	std::wstring wide_path = std::filesystem::u8path(path).wstring();
+	HANDLE file = CreateFileW(wide_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return nullptr;
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(file);
+		return nullptr;
+	}
+	// PAGE_WRITECOPY + FILE_MAP_COPY：写入时复制页面，不写回文件
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if (!mapping) {
+		CloseHandle(file);
+		return nullptr;
+	}
+	void* view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	if (!view) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return nullptr;
+	}
+
+	std::shared_ptr<MappedFile> mapped(new MappedFile());
+	mapped->data = static_cast<unsigned char*>(view);
+	mapped->length = static_cast<size_t>(file_size.QuadPart);
+	mapped->file_handle = file;
+	mapped->mapping_handle = mapping;
+	return mapped;
+}
+
+MappedFile::~MappedFile() {
+	if (data) UnmapViewOfFile(data);
+	if (mapping_handle) CloseHandle(static_cast<HANDLE>(mapping_handle));
+	if (file_handle) CloseHandle(static_cast<HANDLE>(file_handle));
+}
+
+#else
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path) {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return nullptr;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		return nullptr;
+	}
+	// MAP_PRIVATE + PROT_WRITE：写入时复制页面，不写回文件；映射建立后即可关闭文件
+	void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED) {
+		return nullptr;
+	}
+
+	std::shared_ptr<MappedFile> mapped(new MappedFile());
+	mapped->data = static_cast<unsigned char*>(view);
+	mapped->length = static_cast<size_t>(st.st_size);
+	return mapped;
+}
+
+MappedFile::~MappedFile() {
+	if (data) munmap(data, length);
+}
+
+#endif
+
+unsigned char* MappedFile::getData() const {
+	return data;
+}
+
+size_t MappedFile::size() const {
+	return length;
+}
+
+bool MappedImage::empty() const {
+	return mat.empty();
+}
+
+
+namespace {
+
+	// 小端读取（BMP 固定为小端）
+	uint16_t readLE16(const unsigned char* p) {
+		return static_cast<uint16_t>(p[0] | (p[1] << 8));
+	}
+
+	uint32_t readLE32(const unsigned char* p) {
+		return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8)
+			| (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+	}
+
+	bool hostIsLittleEndian() {
+		const uint16_t probe = 1;
+		return *reinterpret_cast<const unsigned char*>(&probe) == 1;
+	}
+
+	/// ----------------------- BMP -----------------------
+
+	MappedImage mapBmp(const std::shared_ptr<MappedFile>& file) {
+		const unsigned char* p = file->getData();
+		const size_t size = file->size();
+		if (size < 54) {
+			return MappedImage();
+		}
+
+		const uint32_t pixel_offset = readLE32(p + 10);
+		const uint32_t header_size = readLE32(p + 14);
+		const int32_t width = static_cast<int32_t>(readLE32(p + 18));
+		const int32_t height = static_cast<int32_t>(readLE32(p + 22));
+		const uint16_t bit_count = readLE16(p + 28);
+		const uint32_t compression = readLE32(p + 30);
+		if (header_size < 40 || width <= 0 || height == 0 || compression != 0) {
+			return MappedImage();
+		}
+
+		int type = -1;
+		if (bit_count == 24) {
+			type = CV_8UC3;
+		}
+		else if (bit_count == 8) {
+			// 只接受恒等灰度调色板，彩色调色板需要查表解码
+			uint32_t colors = readLE32(p + 46);
+			if (colors == 0) colors = 256;
+			const size_t palette = 14 + static_cast<size_t>(header_size);
+			if (colors > 256 || palette + 4 * static_cast<size_t>(colors) > size) {
+				return MappedImage();
+			}
+			for (uint32_t i = 0; i < colors; ++i) {
+				const unsigned char* entry = p + palette + 4 * i;
+				if (entry[0] != i || entry[1] != i || entry[2] != i) {
+					return MappedImage();
+				}
+			}
+			type = CV_8UC1;
+		}
+		else {
+			return MappedImage();
+		}
+
+		const int rows = std::abs(height);
+		const size_t step = ((static_cast<size_t>(width) * bit_count + 31) / 32) * 4;   // 行按 4 字节对齐
+		if (pixel_offset + step * rows > size) {
+			return MappedImage();
+		}
+
+		cv::Mat mapped(rows, width, type, file->getData() + pixel_offset, step);
+		MappedImage result;
+		if (height < 0) {
+			// 自上而下存储：零复制
+			result.file = file;
+			result.mat = mapped;
+		}
+		else {
+			// 自下而上存储：Mat 不支持负步长，直接从映射按行倒序复制
+			cv::flip(mapped, result.mat, 0);
+		}
+		return result;
+	}
+
+	/// ----------------------- TIFF -----------------------
+
+	struct TiffReader {
+		const unsigned char* data;
+		size_t size;
+		bool little_endian;
+
+		uint16_t u16(size_t offset) const {
+			const unsigned char* p = data + offset;
+			return little_endian ? static_cast<uint16_t>(p[0] | (p[1] << 8)) : static_cast<uint16_t>((p[0] << 8) | p[1]);
+		}
+
+		uint32_t u32(size_t offset) const {
+			const unsigned char* p = data + offset;
+			return little_endian
+				? (static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24))
+				: ((static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]));
+		}
+
+		// 读取 SHORT / LONG 类型字段的全部值；值不超过 4 字节时存放在目录项内
+		bool values(size_t entry, std::vector<uint32_t>& out) const {
+			const uint16_t field_type = u16(entry + 2);
+			const uint32_t count = u32(entry + 4);
+			const size_t unit = (field_type == 3) ? 2 : (field_type == 4) ? 4 : 0;
+			if (unit == 0 || count == 0) {
+				return false;
+			}
+			const size_t bytes = unit * count;
+			const size_t start = (bytes <= 4) ? entry + 8 : u32(entry + 8);
+			if (start + bytes > size) {
+				return false;
+			}
+			out.resize(count);
+			for (uint32_t i = 0; i < count; ++i) {
+				out[i] = (unit == 2) ? u16(start + 2 * i) : u32(start + 4 * i);
+			}
+			return true;
+		}
+	};
+
+	MappedImage mapTiff(const std::shared_ptr<MappedFile>& file) {
+		TiffReader tiff{ file->getData(), file->size(), file->getData()[0] == 'I' };
+		if (tiff.size < 8 || tiff.u16(2) != 42) {   // 43 为 BigTIFF，不支持
+			return MappedImage();
+		}
+
+		const size_t ifd = tiff.u32(4);
+		if (ifd + 2 > tiff.size) {
+			return MappedImage();
+		}
+		const uint16_t entries = tiff.u16(ifd);
+		if (ifd + 2 + 12 * static_cast<size_t>(entries) > tiff.size) {
+			return MappedImage();
+		}
+
+		uint32_t width = 0, height = 0, bits = 1, compression = 1, photometric = 1;
+		uint32_t samples = 1, rows_per_strip = 0xFFFFFFFF, planar = 1, sample_format = 1;
+		std::vector<uint32_t> strip_offsets, v;
+		for (uint16_t i = 0; i < entries; ++i) {
+			const size_t entry = ifd + 2 + 12 * static_cast<size_t>(i);
+			const uint16_t tag = tiff.u16(entry);
+			switch (tag) {
+			case 256: if (tiff.values(entry, v)) width = v[0]; break;
+			case 257: if (tiff.values(entry, v)) height = v[0]; break;
+			case 258: if (tiff.values(entry, v)) bits = v[0]; break;
+			case 259: if (tiff.values(entry, v)) compression = v[0]; break;
+			case 262: if (tiff.values(entry, v)) photometric = v[0]; break;
+			case 273: tiff.values(entry, strip_offsets); break;
+			case 277: if (tiff.values(entry, v)) samples = v[0]; break;
+			case 278: if (tiff.values(entry, v)) rows_per_strip = v[0]; break;
+			case 284: if (tiff.values(entry, v)) planar = v[0]; break;
+			case 322: return MappedImage();   // 分块（tiled）存储
+			case 339: if (tiff.values(entry, v)) sample_format = v[0]; break;
+			default: break;
+			}
+		}
+
+		// 未压缩、单通道、BlackIsZero
+		if (width == 0 || height == 0 || compression != 1 || samples != 1 || planar != 1 || photometric != 1) {
+			return MappedImage();
+		}
+		int type = -1;
+		if (bits == 8 && sample_format == 1) type = CV_8UC1;
+		else if (bits == 16 && sample_format == 1) type = CV_16UC1;
+		else if (bits == 32 && sample_format == 3) type = CV_32FC1;
+		if (type < 0 || (bits > 8 && tiff.little_endian != hostIsLittleEndian())) {
+			return MappedImage();
+		}
+
+		// 各条带必须首尾相接，整幅图像才是一块连续内存
+		const size_t step = static_cast<size_t>(width) * (bits / 8);
+		const size_t strip_rows = std::min<size_t>(rows_per_strip, height);
+		const size_t strips = (height + strip_rows - 1) / strip_rows;
+		if (strip_offsets.size() != strips) {
+			return MappedImage();
+		}
+		for (size_t s = 0; s < strips; ++s) {
+			if (strip_offsets[s] != strip_offsets[0] + s * strip_rows * step) {
+				return MappedImage();
+			}
+		}
+		if (static_cast<size_t>(strip_offsets[0]) + step * height > tiff.size) {
+			return MappedImage();
+		}
+
+		MappedImage result;
+		result.file = file;
+		result.mat = cv::Mat(static_cast<int>(height), static_cast<int>(width), type, file->getData() + strip_offsets[0], step);
+		return result;
+	}
+
+}
+
+
+MappedImage mapImageFile(const std::string& path) {
+	std::shared_ptr<MappedFile> file = MappedFile::open(path);
+	if (!file || file->size() < 8) {
+		return MappedImage();
+	}
+	const unsigned char* p = file->getData();
+	if (p[0] == 'B' && p[1] == 'M') {
+		return mapBmp(file);
+	}
+	if ((p[0] == 'I' && p[1] == 'I') || (p[0] == 'M' && p[1] == 'M')) {
+		return mapTiff(file);
+	}
+	return MappedImage();
+}
+
+MappedImage mapRawFile(const std::string& path, const RawImageInfo& info) {
+	if (info.width <= 0 || info.height <= 0) {
+		return MappedImage();
+	}
+	std::shared_ptr<MappedFile> file = MappedFile::open(path);
+	const size_t step = static_cast<size_t>(info.width) * CV_ELEM_SIZE(info.type);
+	if (!file || info.offset + step * info.height > file->size()) {
+		return MappedImage();
+	}
+
+	MappedImage result;
+	result.file = file;
+	result.mat = cv::Mat(info.height, info.width, info.type, file->getData() + info.offset, step);
+	return result;
+}
@@ -0,0 +1,77 @@
+﻿/// ----------------------- MappedImage -----------------------
+///
+/// 说明：未压缩图像文件的内存映射加载；
+///      文件以写时复制（copy-on-write）方式映射，cv::Mat 头直接指向映射中的像素数据，
+///      打开时不读取、不复制像素，数据由操作系统页缓存按需调入；
+///      首次修改某一页时由操作系统复制该页，原文件不会被修改。
+///
+///      支持的布局（其他情况返回空，由调用方回退到 cv::imread）：
+///        - BMP：24 位 BI_RGB（BGR），8 位灰度调色板；自上而下存储时零复制，
+///               自下而上存储（常见情况）时按行倒序从映射复制一次，不经过解码器
+///        - TIFF：单页第一幅图像，未压缩、按条带连续存储、单通道 8/16 位无符号或 32 位浮点，
+///               16/32 位数据要求小端字节序
+///        - RAW：无文件头的采集数据，由调用方给出宽、高、类型与数据偏移
+///
+///      映射加载保留文件的原始位深与通道数（不像 cv::imread 默认转换为 8 位 BGR）；
+///      MyImage 从路径载入（load <path>）时只对映射结果已是 8 位 BGR 的文件（24 位 BMP）直接使用映射，
+///      灰度或高位深文件仍由 cv::imread 转换为 8 位 BGR；
+///      load <path> unchanged 保留原始位深，此时所有可映射的布局（含 TIFF 与 8 位灰度 BMP）都使用映射，
+///      其他文件按 cv::IMREAD_UNCHANGED 读取；RAW 载入始终保留原始位深。
+///      MappedImage 持有映射，cv::Mat 不持有；使用者必须在 Mat 使用期间保留 MappedImage::file。
+///
+/// ----------------------- MappedImage -----------------------
+
+#pragma once
+#ifndef MAPPED_IMAGE_H
+#define MAPPED_IMAGE_H
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <string>
+
+/* RAW 文件的布局 */
+struct RawImageInfo {
+	int width = 0;
+	int height = 0;
+	int type = CV_8UC1;    // 像素类型（CV_8UC1、CV_16UC1、CV_32FC1 等）
+	size_t offset = 0;     // 像素数据在文件中的起始位置（字节）
+};
+
+/* 写时复制的只读文件映射，析构时解除映射 */
+class MappedFile {
+private:
+	unsigned char* data = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void* file_handle = nullptr;
+	void* mapping_handle = nullptr;
+#endif
+
+	MappedFile() = default;
+
+public:
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// 映射失败（文件不存在、为空等）时返回 nullptr
+	static std::shared_ptr<MappedFile> open(const std::string& path);
+
+	unsigned char* getData() const;
+	size_t size() const;
+};
+
+struct MappedImage {
+	std::shared_ptr<MappedFile> file;   // 零复制时 mat 指向其中的数据；复制加载时为空
+	cv::Mat mat;
+
+	bool empty() const;
+};
+
+// 按文件头识别未压缩的 BMP / TIFF 并映射；格式不支持时返回空
+MappedImage mapImageFile(const std::string& path);
+
+// 按给定布局映射 RAW 文件；文件长度不足时返回空
+MappedImage mapRawFile(const std::string& path, const RawImageInfo& info);
+
+#endif // MAPPED_IMAGE_H
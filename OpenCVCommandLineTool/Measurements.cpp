@@ -0,0 +1,196 @@
+﻿/// ----------------------- Measurements -----------------------
+///
+/// 说明：按形状外接矩形并行的一次遍历测量，见 Measurements.h。
+///
+/// ----------------------- Measurements -----------------------
+
+#include "Measurements.h"
+#include "Selection.h"
+#include "TileExecutor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+	const double kHalfDiagonal = std::sqrt(2.0) / 2;
+
+	// 框内一次遍历：强度统计、质心与每行两端像素的角点
+	template <typename T>
+	void accumulate(const cv::Mat& image, const Selection& region, ShapeMeasurement& m, std::vector<cv::Point2f>& corners) {
+		const cv::Rect& b = region.bounds;
+		double sum = 0, sum_sq = 0, sum_x = 0, sum_y = 0;
+		double lo = std::numeric_limits<double>::max();
+		double hi = std::numeric_limits<double>::lowest();
+		int64_t area = 0;
+		for (int y = 0; y < b.height; ++y) {
+			const T* row = image.ptr<T>(b.y + y) + b.x;
+			const uchar* mask = region.mask.empty() ? nullptr : region.mask.ptr<uchar>(y);
+			int first = -1, last = -1, count = 0;
+			for (int x = 0; x < b.width; ++x) {
+				if (mask && !mask[x]) continue;
+				const double v = row[x];
+				sum += v;
+				sum_sq += v * v;
+				lo = std::min(lo, v);
+				hi = std::max(hi, v);
+				sum_x += x;
+				++count;
+				if (first < 0) first = x;
+				last = x;
+			}
+			if (count == 0) continue;
+			area += count;
+			sum_y += static_cast<double>(y) * count;
+			const float y0 = static_cast<float>(b.y + y);
+			corners.emplace_back(static_cast<float>(b.x + first), y0);
+			corners.emplace_back(static_cast<float>(b.x + first), y0 + 1);
+			corners.emplace_back(static_cast<float>(b.x + last + 1), y0);
+			corners.emplace_back(static_cast<float>(b.x + last + 1), y0 + 1);
+		}
+		if (area == 0) {
+			return;
+		}
+		m.area = area;
+		m.mean = sum / area;
+		m.stddev = (area > 1) ? std::sqrt(std::max(0.0, (sum_sq - sum * sum / area) / (area - 1))) : 0;
+		m.min = lo;
+		m.max = hi;
+		m.integrated_density = sum;
+		m.centroid = cv::Point2d(b.x + sum_x / area, b.y + sum_y / area);
+	}
+
+	// 掩码轮廓长度：每个 2 x 2 窗口按前景像素的排列计入一段经过像素中心的折线
+	double maskPerimeter(const cv::Mat& mask) {
+		double perimeter = 0;
+		for (int y = 0; y <= mask.rows; ++y) {
+			const uchar* top = (y > 0) ? mask.ptr<uchar>(y - 1) : nullptr;
+			const uchar* bottom = (y < mask.rows) ? mask.ptr<uchar>(y) : nullptr;
+			for (int x = 0; x <= mask.cols; ++x) {
+				const bool tl = top && x > 0 && top[x - 1];
+				const bool tr = top && x < mask.cols && top[x];
+				const bool bl = bottom && x > 0 && bottom[x - 1];
+				const bool br = bottom && x < mask.cols && bottom[x];
+				const int count = tl + tr + bl + br;
+				if (count == 1 || count == 3) perimeter += kHalfDiagonal;
+				else if (count == 2) perimeter += (tl == br) ? 2 * kHalfDiagonal : 1.0;
+			}
+		}
+		return perimeter;
+	}
+
+	double polygonPerimeter(const std::vector<Point>& points) {
+		double perimeter = 0;
+		for (size_t i = 0; i < points.size(); ++i) {
+			const Point& a = points[i];
+			const Point& b = points[(i + 1) % points.size()];
+			perimeter += std::hypot(b.x - a.x, b.y - a.y);
+		}
+		return perimeter;
+	}
+
+	// 矩形取标注点的外接范围（不受图像边界裁剪与取整影响）
+	double rectanglePerimeter(const std::vector<Point>& points) {
+		if (points.empty()) {
+			return 0;
+		}
+		double x0 = points[0].x, x1 = points[0].x, y0 = points[0].y, y1 = points[0].y;
+		for (const Point& p : points) {
+			x0 = std::min(x0, p.x);
+			x1 = std::max(x1, p.x);
+			y0 = std::min(y0, p.y);
+			y1 = std::max(y1, p.y);
+		}
+		return 2.0 * ((x1 - x0) + (y1 - y0));
+	}
+
+	// 凸包上的最大直径与最小宽度（每条边对应一个卡尺方向），凸包点数很少，直接枚举
+	void feretDiameters(const std::vector<cv::Point2f>& corners, ShapeMeasurement& m) {
+		std::vector<cv::Point2f> hull;
+		cv::convexHull(corners, hull);
+		const int n = static_cast<int>(hull.size());
+		if (n < 2) {
+			return;
+		}
+		double best = -1;
+		for (int i = 0; i < n; ++i) {
+			for (int j = i + 1; j < n; ++j) {
+				const double d = std::hypot(hull[i].x - hull[j].x, hull[i].y - hull[j].y);
+				if (d > best) {
+					best = d;
+					// 图像 y 轴向下，角度按 y 轴向上计算
+					cv::Point2f a = hull[i], b = hull[j];
+					if (a.x > b.x) std::swap(a, b);
+					double angle = std::atan2(a.y - b.y, b.x - a.x) * 180.0 / CV_PI;
+					if (angle < 0) angle += 180;
+					m.feret_angle = angle;
+				}
+			}
+		}
+		m.feret = best;
+
+		double width = std::numeric_limits<double>::max();
+		for (int i = 0; i < n; ++i) {
+			const cv::Point2f& a = hull[i];
+			const cv::Point2f& b = hull[(i + 1) % n];
+			const double dx = b.x - a.x, dy = b.y - a.y;
+			const double length = std::hypot(dx, dy);
+			if (length <= 0) continue;
+			double farthest = 0;
+			for (const cv::Point2f& p : hull) {
+				farthest = std::max(farthest, std::abs(dx * (p.y - a.y) - dy * (p.x - a.x)) / length);
+			}
+			width = std::min(width, farthest);
+		}
+		m.min_feret = (width == std::numeric_limits<double>::max()) ? 0 : width;
+	}
+
+}
+
+
+std::vector<ShapeMeasurement> measureShapes(const cv::Mat& image, const std::vector<MyShape>& shapes) {
+	std::vector<ShapeMeasurement> results(shapes.size());
+	if (image.empty() || shapes.empty()) {
+		return results;
+	}
+
+	cv::Mat gray = image;
+	if (gray.channels() > 1) {
+		cv::cvtColor(image, gray, (image.channels() == 4) ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+	}
+	if (gray.depth() != CV_8U && gray.depth() != CV_16U && gray.depth() != CV_32F) {
+		gray.convertTo(gray, CV_32F);
+	}
+
+	const int threads = TileExecutor::threadCount(TileExecutor::getOptions());
+	runWorkStealing(static_cast<int>(shapes.size()), threads, [&](int i) {
+		const MyShape& shape = shapes[i];
+		const Selection region = Selection::fromShape(shape, gray.size());
+		if (region.empty()) {
+			return;
+		}
+		ShapeMeasurement& m = results[i];
+		std::vector<cv::Point2f> corners;
+		switch (gray.depth()) {
+		case CV_8U: accumulate<uchar>(gray, region, m, corners); break;
+		case CV_16U: accumulate<ushort>(gray, region, m, corners); break;
+		default: accumulate<float>(gray, region, m, corners); break;
+		}
+		if (m.area == 0) {
+			return;
+		}
+
+		if (!shape.getSegmentOutput()._boxMask.empty()) {
+			m.perimeter = maskPerimeter(region.mask);
+		}
+		else if (shape.getShapeType() == 1 && shape.getPoints().size() >= 3) {
+			m.perimeter = polygonPerimeter(shape.getPoints());
+		}
+		else {
+			m.perimeter = rectanglePerimeter(shape.getPoints());
+		}
+		feretDiameters(corners, m);
+	});
+	return results;
+}
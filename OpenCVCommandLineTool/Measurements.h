@@ -0,0 +1,43 @@
+﻿/// ----------------------- Measurements -----------------------
+///
+/// 说明：标注形状的强度与形态测量（对应 ImageJ 的 Measure）；
+///      每个形状按 Selection::fromShape 栅格化为外接矩形与框内掩码（矩形、多边形、模型实例掩码），
+///      测量时只访问自身外接矩形内的像素，各形状由工作窃取线程池并行处理，
+///      总开销与形状面积之和成正比，不会因形状数量而对整幅图像反复扫描。
+///      形状之间可以重叠（如模型的检测框），重叠处的像素分别计入各自的形状。
+///
+///      一次遍历框内像素同时得到面积、均值、标准差、最值、积分密度与质心，
+///      以及每行最左、最右像素的角点，其凸包用于计算 Feret 直径。
+///
+///      周长：有实例掩码的形状按 2 x 2 窗口（marching squares）累加轮廓长度，与 analyze_particles 一致；
+///      矩形与多边形按标注点取其几何周长（不受图像边界裁剪影响）。
+///
+/// ----------------------- Measurements -----------------------
+
+#pragma once
+#ifndef MEASUREMENTS_H
+#define MEASUREMENTS_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+#include "MyShape.h"
+
+struct ShapeMeasurement {
+	int64_t area = 0;
+	double mean = 0;
+	double stddev = 0;               // 样本标准差（n - 1）
+	double min = 0;
+	double max = 0;
+	double integrated_density = 0;   // 像素值之和（面积 × 均值）
+	cv::Point2d centroid;
+	double perimeter = 0;
+	double feret = 0;                // 最大卡尺直径
+	double feret_angle = 0;          // 最大直径与 x 轴的夹角（度，[0, 180)，y 轴向上）
+	double min_feret = 0;            // 最小卡尺宽度
+};
+
+// 多通道图像按灰度测量；位于图像外的形状面积为 0
+std::vector<ShapeMeasurement> measureShapes(const cv::Mat& image, const std::vector<MyShape>& shapes);
+
+#endif // MEASUREMENTS_H
@@ -0,0 +1,205 @@
+﻿/// ----------------------- Morphology -----------------------
+///
+/// 说明：结构元分解与 count 查找表的二值形态学，见 Morphology.h。
+///
+/// ----------------------- Morphology -----------------------
+
+#include "Morphology.h"
+#include "RankFilters.h"
+#include "BitMask.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace {
+
+	// 极值运算的单位元：最大值取 0，最小值取 255
+	template <bool IsMax>
+	inline uchar neutral() {
+		return IsMax ? 0 : 255;
+	}
+
+	// 沿对角线（dx = 1）或反对角线（dx = -1）方向、半长 w 的线段做一维极值，各条对角线并行
+	template <bool IsMax>
+	void diagonalPass(cv::Mat& image, int w, int dx) {
+		const int rows = image.rows;
+		const int cols = image.cols;
+		const int diagonals = rows + cols - 1;
+		cv::Mat output(image.size(), CV_8UC1);
+		cv::parallel_for_(cv::Range(0, diagonals), [&](const cv::Range& range) {
+			const int capacity = std::min(rows, cols) + 2 * w;
+			std::vector<uchar> line(capacity), out(capacity), g(capacity), h(capacity);
+			for (int d = range.start; d < range.end; ++d) {
+				// 起点：dx = 1 时沿左列向上再沿首行向右；dx = -1 时沿首行向右再沿右列向下
+				int y0, x0, length;
+				if (dx > 0) {
+					y0 = std::max(0, rows - 1 - d);
+					x0 = std::max(0, d - (rows - 1));
+					length = std::min(rows - y0, cols - x0);
+				}
+				else {
+					y0 = std::max(0, d - (cols - 1));
+					x0 = d - y0;
+					length = std::min(rows - y0, x0 + 1);
+				}
+				std::fill(line.begin(), line.begin() + w, neutral<IsMax>());
+				std::fill(line.begin() + w + length, line.begin() + 2 * w + length, neutral<IsMax>());
+				for (int i = 0; i < length; ++i) {
+					line[w + i] = image.at<uchar>(y0 + i, x0 + dx * i);
+				}
+				vhgwLine<uchar, IsMax>(line.data(), out.data(), length, w, g.data(), h.data());
+				for (int i = 0; i < length; ++i) {
+					output.at<uchar>(y0 + i, x0 + dx * i) = out[i];
+				}
+			}
+		});
+		image = output;
+	}
+
+	// 3x3 十字
+	template <bool IsMax>
+	void crossPass(cv::Mat& image) {
+		cv::Mat output(image.size(), CV_8UC1);
+		const int cols = image.cols;
+		cv::parallel_for_(cv::Range(0, image.rows), [&](const cv::Range& range) {
+			for (int y = range.start; y < range.end; ++y) {
+				const uchar* p = image.ptr<uchar>(y);
+				const uchar* up = (y > 0) ? image.ptr<uchar>(y - 1) : nullptr;
+				const uchar* down = (y + 1 < image.rows) ? image.ptr<uchar>(y + 1) : nullptr;
+				uchar* out = output.ptr<uchar>(y);
+				for (int x = 0; x < cols; ++x) {
+					uchar v = p[x];
+					if (x > 0) v = rankPick<uchar, IsMax>(v, p[x - 1]);
+					if (x + 1 < cols) v = rankPick<uchar, IsMax>(v, p[x + 1]);
+					if (up) v = rankPick<uchar, IsMax>(v, up[x]);
+					if (down) v = rankPick<uchar, IsMax>(v, down[x]);
+					out[x] = v;
+				}
+			}
+		});
+		image = output;
+	}
+
+	// count = 1：半径为 iterations 的结构元，图像外取 border_value
+	template <bool IsMax>
+	void decomposed(const cv::Mat& src, cv::Mat& dst, int radius, StructuringElement element, uchar border_value) {
+		int pad = radius;
+		if (element == kElementDisc) {
+			pad = static_cast<int>(rankKernelLines(static_cast<float>(radius), true).size()) / 2;
+		}
+		cv::Mat image;
+		cv::copyMakeBorder(src, image, pad, pad, pad, pad, cv::BORDER_CONSTANT, cv::Scalar(border_value));
+
+		if (element == kElementDiamond) {
+			// 菱形半径 2k + 1 = 对角线段 ⊕ 反对角线段（半长 k）⊕ 十字；半径 2k + 2 再加一次十字
+			const int k = (radius - 1) / 2;
+			const int crosses = radius - 2 * k;
+			if (k > 0) {
+				diagonalPass<IsMax>(image, k, 1);
+				diagonalPass<IsMax>(image, k, -1);
+			}
+			for (int i = 0; i < crosses; ++i) {
+				crossPass<IsMax>(image);
+			}
+		}
+		else if (IsMax) {
+			rankMaximum(image, image, static_cast<float>(radius), element == kElementDisc);
+		}
+		else {
+			rankMinimum(image, image, static_cast<float>(radius), element == kElementDisc);
+		}
+
+		image(cv::Rect(pad, pad, src.cols, src.rows)).copyTo(dst);
+	}
+
+	// 8 邻域编码中前景邻点的个数
+	const std::array<uchar, 256>& neighbourCountTable() {
+		static const std::array<uchar, 256> table = []() {
+			std::array<uchar, 256> t{};
+			for (int code = 0; code < 256; ++code) {
+				int n = 0;
+				for (int b = 0; b < 8; ++b) n += (code >> b) & 1;
+				t[code] = static_cast<uchar>(n);
+			}
+			return t;
+		}();
+		return table;
+	}
+
+	// count > 1：ImageJ 语义的逐次迭代，两个带 1 像素边框（取 border_value）的缓冲区交替使用
+	template <bool Erode>
+	void counted(const cv::Mat& src, cv::Mat& dst, int iterations, int count, uchar border_value) {
+		const std::array<uchar, 256>& table = neighbourCountTable();
+		cv::Mat a, b;
+		cv::copyMakeBorder(src, a, 1, 1, 1, 1, cv::BORDER_CONSTANT, cv::Scalar(border_value));
+		b = a.clone();
+		const int step = static_cast<int>(a.step);
+
+		for (int iter = 0; iter < iterations; ++iter) {
+			cv::parallel_for_(cv::Range(1, a.rows - 1), [&](const cv::Range& range) {
+				for (int y = range.start; y < range.end; ++y) {
+					const uchar* p = a.ptr<uchar>(y);
+					uchar* out = b.ptr<uchar>(y);
+					for (int x = 1; x < a.cols - 1; ++x) {
+						const uchar* c = p + x;
+						const int code = (c[1] ? 1 : 0) | (c[-step + 1] ? 2 : 0) | (c[-step] ? 4 : 0) | (c[-step - 1] ? 8 : 0)
+							| (c[-1] ? 16 : 0) | (c[step - 1] ? 32 : 0) | (c[step] ? 64 : 0) | (c[step + 1] ? 128 : 0);
+						const int foreground = table[code];
+						if (Erode) {
+							out[x] = (c[0] && 8 - foreground >= count) ? 0 : c[0];
+						}
+						else {
+							out[x] = (!c[0] && foreground >= count) ? 255 : c[0];
+						}
+					}
+				}
+			});
+			std::swap(a, b);
+		}
+		a(cv::Rect(1, 1, src.cols, src.rows)).copyTo(dst);
+	}
+
+}
+
+
+void binaryErode(const cv::Mat& src, cv::Mat& dst, int iterations, int count, StructuringElement element, bool pad_edges) {
+	CV_Assert(src.type() == CV_8UC1);
+	cv::Mat mask;
+	cv::compare(src, 0, mask, cv::CMP_NE);
+	const uchar border = pad_edges ? 255 : 0;
+	if (iterations <= 0 || mask.empty()) {
+		dst = mask;
+	}
+	else if (count <= 1 && element == kElementSquare) {
+		BitMask bits = BitMask::fromMat(mask);
+		bits.erode(iterations, pad_edges);
+		dst = bits.toMat();
+	}
+	else if (count <= 1) {
+		decomposed<false>(mask, dst, iterations, element, border);
+	}
+	else {
+		counted<true>(mask, dst, iterations, count, border);
+	}
+}
+
+void binaryDilate(const cv::Mat& src, cv::Mat& dst, int iterations, int count, StructuringElement element) {
+	CV_Assert(src.type() == CV_8UC1);
+	cv::Mat mask;
+	cv::compare(src, 0, mask, cv::CMP_NE);
+	if (iterations <= 0 || mask.empty()) {
+		dst = mask;
+	}
+	else if (count <= 1 && element == kElementSquare) {
+		BitMask bits = BitMask::fromMat(mask);
+		bits.dilate(iterations);
+		dst = bits.toMat();
+	}
+	else if (count <= 1) {
+		decomposed<true>(mask, dst, iterations, element, 0);
+	}
+	else {
+		counted<false>(mask, dst, iterations, count, 0);
+	}
+}
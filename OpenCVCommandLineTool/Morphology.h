@@ -0,0 +1,35 @@
+﻿/// ----------------------- Morphology -----------------------
+///
+/// 说明：二值形态学（腐蚀 / 膨胀）引擎；
+///
+///      count = 1 时，n 次迭代等价于一次半径为 n 的结构元，结构元分解为一维操作：
+///        - 方形：转为每像素 1 位的 BitMask，水平与垂直两遍按 64 位字倍增扩展窗口（BitMask.h）；
+///        - 圆形：按行拆分为水平线段，逐行合并（RankFilters.h 的圆形核）；
+///        - 菱形：两条对角线方向的 van Herk/Gil-Werman 线段，再加一到两次 3x3 十字，
+///          (对角线段 ⊕ 反对角线段) 只覆盖奇偶性相同的点，十字补齐其余的点。
+///      因此 iterations = 50 与一次较大的核开销相当，而不是 50 遍 3x3。
+///
+///      count > 1 时按 ImageJ 语义逐次迭代：3x3 邻域中至少 count 个邻点与当前像素不同时像素才改变，
+///      邻域编码（8 位）经查找表得到邻点数，每次迭代按行并行。
+///
+///      图像外：膨胀时视为背景；腐蚀时 pad_edges 为 true 视为前景（边缘不被腐蚀），否则视为背景。
+///      输入为 CV_8UC1，非零为前景，输出为 0 / 255。
+///
+/// ----------------------- Morphology -----------------------
+
+#pragma once
+#ifndef MORPHOLOGY_H
+#define MORPHOLOGY_H
+
+#include <opencv2/opencv.hpp>
+
+enum StructuringElement {
+	kElementSquare,      // 与 3x3 方形核迭代相同
+	kElementDisc,
+	kElementDiamond      // 与 3x3 十字核迭代相同
+};
+
+void binaryErode(const cv::Mat& src, cv::Mat& dst, int iterations, int count, StructuringElement element, bool pad_edges);
+void binaryDilate(const cv::Mat& src, cv::Mat& dst, int iterations, int count, StructuringElement element);
+
+#endif // MORPHOLOGY_H
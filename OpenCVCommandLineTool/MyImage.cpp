@@ -20,19 +20,51 @@
 #include <vector> 
 
 /* 构造函数 */
-MyImage::MyImage(const std::string& image_path)
+MyImage::MyImage(const std::string& image_path, bool unchanged)
 	: image_path(image_path),
-	image_mat(cv::imread(image_path)),
-	binary(image_mat),
-	filter(image_mat),
-	image_width(image_mat.rows),
-	image_height(image_mat.cols)
+	binary(image_mat, &packed_mask),
+	filter(image_mat)
+{
+	// 可映射时不读取、不复制像素；映射为写时复制，修改图像不会改动原文件
+	// 默认只有与 cv::imread 结果同类型（8 位 BGR）的文件直接使用映射，其他位深交给 cv::imread 转换；
+	// unchanged 时保留原始位深，映射结果直接使用
+	MappedImage mapped = mapImageFile(image_path);
+	if (!mapped.empty() && (unchanged || mapped.mat.type() == CV_8UC3)) {
+		mapping = mapped.file;
+		image_mat = mapped.mat;
+	}
+	else {
+		image_mat = cv::imread(image_path, unchanged ? cv::IMREAD_UNCHANGED : cv::IMREAD_COLOR);
+	}
+	image_width = image_mat.rows;
+	image_height = image_mat.cols;
+}
+
+MyImage::MyImage(const std::string& image_path, const RawImageInfo& raw_info)
+	: image_path(image_path),
+	binary(image_mat, &packed_mask),
+	filter(image_mat)
+{
+	MappedImage mapped = mapRawFile(image_path, raw_info);
+	mapping = mapped.file;
+	image_mat = mapped.mat;
+	image_width = image_mat.rows;
+	image_height = image_mat.cols;
+}
+
+MyImage::MyImage(const std::string& image_path, const cv::Mat& image_mat)
+	: image_path(image_path),
+	image_mat(image_mat),
+	binary(this->image_mat, &packed_mask),
+	filter(this->image_mat),
+	image_width(this->image_mat.rows),
+	image_height(this->image_mat.cols)
 {}
 
 
 /* 仅用于测试 */
-void MyImage::show() const {
-	cv::imshow("Test result", image_mat);
+void MyImage::show() {
+	cv::imshow("Test result", renderDisplay());
 	int k = cv::waitKey(0); // Wait for a keystroke in the window
 }
 
@@ -51,12 +83,13 @@ int MyImage::getHeight() const {
 }
 
 cv::Mat& MyImage::getImageMat() {
+	flushPendingOps();
 	return image_mat;
 }
 
 
 void MyImage::exportImage(std::string outputPath) {
-	if (!cv::imwrite(outputPath, image_mat)) {
+	if (!cv::imwrite(outputPath, renderDisplay())) {
 		std::cout << "Error: Failed to save image.\n";
 	}
 	else {
@@ -66,181 +99,209 @@ void MyImage::exportImage(std::string outputPath) {
 
 
 void MyImage::crop(int x, int y, int width, int height) {
+	flushPendingOps();
 	cv::Rect roi(x, y, width, height);
 	image_mat = image_mat(roi);
 }
 
 void MyImage::scale(float factor) {
+	flushPendingOps();
 	cv::resize(image_mat, image_mat, cv::Size(), factor, factor, cv::INTER_LINEAR);
 }
 
 void MyImage::scaleByWidth(int width) {
+	flushPendingOps();
 	int new_height = static_cast<int>(image_mat.rows * (static_cast<double>(width) / image_mat.cols));
 	cv::resize(image_mat, image_mat, cv::Size(width, new_height), 0, 0, cv::INTER_LINEAR);
 }
 
 void MyImage::scaleByHeight(int height) {
+	flushPendingOps();
 	int new_width = static_cast<int>(image_mat.cols * (static_cast<double>(height) / image_mat.rows));
 	cv::resize(image_mat, image_mat, cv::Size(new_width, height), 0, 0, cv::INTER_LINEAR);
 }
 
 void MyImage::flipHorizontally() {
+	flushPendingOps();
 	cv::flip(image_mat, image_mat, 1);
 }
 
 void MyImage::flipVertically() {
+	flushPendingOps();
 	cv::flip(image_mat, image_mat, 0);
 }
 
 void MyImage::rotateNinetyClockwise() {
+	flushPendingOps();
 	cv::rotate(image_mat, image_mat, cv::ROTATE_90_CLOCKWISE);
 }
 
 void MyImage::rotateNinetyCounterClockwise() {
+	flushPendingOps();
 	cv::rotate(image_mat, image_mat, cv::ROTATE_90_COUNTERCLOCKWISE);
 }
 
 void MyImage::rotate(double angle) {
+	flushPendingOps();
 	cv::Point2f center_coord((image_mat.cols - 1) / 2.0, (image_mat.rows - 1) / 2.0);
 	cv::Mat rotation_matrix = cv::getRotationMatrix2D(center_coord, angle, 1.0);
 	cv::warpAffine(image_mat, image_mat, rotation_matrix, image_mat.size());
 }
 
 void MyImage::translate(float x_offset, float y_offset) {
+	flushPendingOps();
 	// create the translation matrix using x_offset and y_offset
 	float warp_values[] = { 1.0, 0.0, x_offset, 0.0, 1.0, y_offset };
 	cv::warpAffine(image_mat, image_mat, cv::Mat(2, 3, CV_32F, warp_values), image_mat.size());
 }
 
-void MyImage::convertColorDepth(ColorDepth color_depth) {
+// 按输入类型 type 生成转换到 color_depth 的逐像素操作
+void appendColorDepthOps(PointwisePipeline& ops, int type, ColorDepth color_depth) {
+	int channels = CV_MAT_CN(type);
+	int depth = CV_MAT_DEPTH(type);
+
 	switch (color_depth) {
 	case k8BitGrayscale:
-		if (image_mat.channels() == 3 || image_mat.channels() == 4) {
-			cv::cvtColor(image_mat, image_mat, cv::COLOR_BGR2GRAY);
+		if (channels == 3 || channels == 4) {
+			ops.addToGray();
 		}
-		if (image_mat.depth() == CV_16U) {
-			image_mat.convertTo(image_mat, CV_8U, 1.0 / 256.0);
+		if (depth == CV_16U) {
+			ops.addConvert(CV_8U, 1.0 / 256.0);
 		}
-		else if (image_mat.depth() == CV_32F) {
-			image_mat.convertTo(image_mat, CV_8U, 255.0);
+		else if (depth == CV_32F) {
+			ops.addConvert(CV_8U, 255.0);
 		}
 		break;
 
 	case k16BitGrayscale:
-		if (image_mat.channels() == 3 || image_mat.channels() == 4) {
-			cv::cvtColor(image_mat, image_mat, cv::COLOR_BGR2GRAY);
+		if (channels == 3 || channels == 4) {
+			ops.addToGray();
 		}
-		if (image_mat.depth() == CV_8U) {
-			image_mat.convertTo(image_mat, CV_16U, 256.0);
+		if (depth == CV_8U) {
+			ops.addConvert(CV_16U, 256.0);
 		}
 		else {
-			image_mat.convertTo(image_mat, CV_16U);
+			ops.addConvert(CV_16U);
 		}
 		break;
 
 	case k32BitGrayscale:
-		if (image_mat.channels() == 3 || image_mat.channels() == 4) {
-			cv::cvtColor(image_mat, image_mat, cv::COLOR_BGR2GRAY);
+		if (channels == 3 || channels == 4) {
+			ops.addToGray();
 		}
-		image_mat.convertTo(image_mat, CV_32F, 1.0 / ((image_mat.depth() == CV_16U) ? 65535.0 : 255.0));
+		ops.addConvert(CV_32F, 1.0 / ((depth == CV_16U) ? 65535.0 : 255.0));
 		break;
 
 	case k8BitColor:
-		if (image_mat.channels() == 1) {
-			cv::cvtColor(image_mat, image_mat, cv::COLOR_GRAY2BGR);
+		if (channels == 1) {
+			ops.addToColor();
 		}
-		if (image_mat.depth() == CV_32F) {
-			image_mat.convertTo(image_mat, CV_8U, 255.0);
+		if (depth == CV_32F) {
+			ops.addConvert(CV_8U, 255.0);
 		}
-		else if (image_mat.depth() == CV_16U) {
-			image_mat.convertTo(image_mat, CV_8U, 1.0 / 256.0);
+		else if (depth == CV_16U) {
+			ops.addConvert(CV_8U, 1.0 / 256.0);
 		}
 		break;
 
 	case kRGBColor:
-		if (image_mat.channels() == 1) {
-			cv::cvtColor(image_mat, image_mat, cv::COLOR_GRAY2BGR);
+		if (channels == 1) {
+			ops.addToColor();
 		}
-		else if (image_mat.channels() == 4) {
-			cv::cvtColor(image_mat, image_mat, cv::COLOR_BGRA2BGR);
+		else if (channels == 4) {
+			ops.addDropAlpha();
 		}
-		if (image_mat.depth() == CV_32F) {
-			image_mat.convertTo(image_mat, CV_8U, 255.0);
+		if (depth == CV_32F) {
+			ops.addConvert(CV_8U, 255.0);
 		}
-		else if (image_mat.depth() == CV_16U) {
-			image_mat.convertTo(image_mat, CV_8U, 1.0 / 256.0);
+		else if (depth == CV_16U) {
+			ops.addConvert(CV_8U, 1.0 / 256.0);
 		}
 		break;
 	}
 }
 
+void MyImage::convertColorDepth(ColorDepth color_depth) {
+	// 只记录操作，按待定操作执行后的类型决定转换步骤
+	appendColorDepthOps(pending_ops, getPendingType(), color_depth);
+}
+
 /*
 * recommended range:
-minimum: [0, 255]
-maximum: [0, 255]
+minimum: [0, 255]（16 位图像为 [0, 65535]）
+maximum: [0, 255]（16 位图像为 [0, 65535]）
 contrast: [-127, 127]
 brightness: [-127, 127]
 */
 void MyImage::setBrightnessContrast(int minimum, int maximum, double contrast, double brightness) {
-	// 计算中间值和范围，用于调整对比度
-	double mid = (minimum + maximum) / 2.0;
-	double range = (maximum - minimum) / 2.0 / (contrast > 0 ? contrast : 1);
-
-	// 根据中间值和范围重新计算最小值和最大值
-	minimum = static_cast<int>(mid - range);
-	maximum = static_cast<int>(mid + range);
-
-	// 限制最小值和最大值在合理范围内（-5000 到 5000）
-	minimum = std::max(-5000, std::min(minimum, 5000));
-	maximum = std::max(-5000, std::min(maximum, 5000));
-	if (minimum >= maximum) {
-		std::swap(minimum, maximum); // 如果最小值大于最大值，交换两者
-	}
+	// 只记录显示参数并重建 LUT，image_mat 保持原始数据
+	DisplayRange range;
+	range.minimum = minimum;
+	range.maximum = maximum;
+	range.contrast = contrast;
+	range.brightness = brightness;
+
+	display.setRange(range);
+	has_display_range = true;
+}
 
-	cv::Mat adjusted;
-	image_mat.convertTo(adjusted, CV_32F); // 转换为 float 进行计算
-
-	// 应用对比度调整公式
-	adjusted = adjusted * (contrast / 127 + 1) - contrast;
-	// 限制像素值在最小值和最大值之间
-	adjusted = cv::max(adjusted, minimum);
-	adjusted = cv::min(adjusted, maximum);
-	// 将像素值映射到 0-255 范围
-	adjusted = (adjusted - minimum) / (maximum - minimum) * 255.0;
-	adjusted.convertTo(adjusted, CV_8U); // 将图像转换回 8 位无符号整型
-
-	// 针对 brightness 部分，避免颜色偏移：转换到 LAB 颜色空间，仅修改 L 通道
-	if (brightness != 0) {
-		cv::Mat lab;
-		cv::cvtColor(adjusted, lab, cv::COLOR_BGR2Lab); // 将图像从 BGR 颜色空间转换到 LAB 颜色空间
-		std::vector<cv::Mat> lab_channels;
-		cv::split(lab, lab_channels); // 分离 LAB 通道
-
-		// 调整 L 通道（lab_channels[0]），其范围为 0-255
-		lab_channels[0].convertTo(lab_channels[0], CV_32F); // 将 L 通道转换为浮点型
-		lab_channels[0] += brightness;  // 仅在 L 通道上加上 brightness 偏移
-		lab_channels[0] = cv::max(lab_channels[0], 0); // 限制 L 通道最小值
-		lab_channels[0] = cv::min(lab_channels[0], 255); // 限制 L 通道最大值
-		lab_channels[0].convertTo(lab_channels[0], CV_8U); // 将 L 通道转换回 8 位无符号整型
-
-		cv::merge(lab_channels, lab); // 合并 LAB 通道
-		cv::cvtColor(lab, adjusted, cv::COLOR_Lab2BGR); // 将图像从 LAB 颜色空间转换回 BGR 颜色空间
-	}
+void MyImage::resetDisplayRange() {
+	display.setRange(DisplayRange());
+	has_display_range = false;
+}
+
+bool MyImage::hasDisplayRange() const {
+	return has_display_range;
+}
 
-	adjusted.copyTo(image_mat);
+const DisplayRange& MyImage::getDisplayRange() const {
+	return display.getRange();
+}
+
+cv::Mat MyImage::renderDisplay() {
+	flushPendingOps();
+	if (!has_display_range) {
+		return image_mat;
+	}
+	cv::Mat output;
+	display.render(image_mat, output);
+	return output;
 }
 
 void MyImage::threshold(int minimum = 0, int maximum = 255) {
-	if (image_mat.channels() == 1) { // 仅在灰度图像时执行
-		cv::threshold(image_mat, image_mat, minimum, maximum, cv::THRESH_BINARY);
+	// 任意位深与通道数均逐通道执行
+	pending_ops.addThreshold(minimum, maximum);
+}
+
+void MyImage::flushPendingOps() {
+	if (!packed_mask.empty()) {
+		image_mat = packed_mask.toMat();
+		packed_mask = BitMask();
 	}
+	if (pending_ops.empty()) {
+		return;
+	}
+	pending_ops.apply(image_mat, image_mat);
+	pending_ops.clear();
+}
+
+void MyImage::prepareBinaryOps() {
+	if (!pending_ops.empty()) {
+		flushPendingOps();
+	}
+}
+
+int MyImage::getPendingType() const {
+	return pending_ops.outputType(packed_mask.empty() ? image_mat.type() : CV_8UC1);
 }
 
 void MyImage::smooth() {
+	flushPendingOps();
 	cv::GaussianBlur(image_mat, image_mat, cv::Size(5, 5), 0);
 }
 
 void MyImage::sharpen() {
+	flushPendingOps();
 	cv::Mat kernel = (cv::Mat_<float>(3, 3) <<
 		0, -1, 0,
 		-1, 5, -1,
@@ -248,37 +309,33 @@ void MyImage::sharpen() {
 	cv::filter2D(image_mat, image_mat, image_mat.depth(), kernel);
 }
 
-std::vector<float> MyImage::histogram() {
-	std::vector<float> histogramData;
-
-	if (image_mat.channels() == 1) {
-		int histSize = 256;
-		float range[] = { 0, 256 };
-		const float* histRange = { range };
-		cv::Mat hist;
-
-		cv::calcHist(&image_mat, 1, 0, cv::Mat(), hist, 1, &histSize, &histRange);
+HistogramResult MyImage::histogram(const HistogramOptions& options) {
+	flushPendingOps();
+	return computeHistogram(image_mat, options);
+}
 
-		// 转换 cv::Mat 为 std::vector<float>
-		histogramData.assign(hist.begin<float>(), hist.end<float>());
-	}
 
-	return histogramData;
+std::vector<float> MyImage::plotProfile(const cv::Mat& mask) {
+	flushPendingOps();
+	return computeMaskProfile(image_mat, RunLengthMask::fromMat(mask));
 }
 
+std::vector<float> MyImage::plotProfile(const RunLengthMask& mask) {
+	flushPendingOps();
+	return computeMaskProfile(image_mat, mask);
+}
 
-std::vector<float> MyImage::plotProfile(const cv::Mat& mask) {
-	std::vector<float> profile;
-
-	if (image_mat.channels() == 1) {
-		for (int y = 0; y < image_mat.rows; ++y) {
-			for (int x = 0; x < image_mat.cols; ++x) {
-				if (mask.at<uchar>(y, x)) {
-					profile.push_back(static_cast<float>(image_mat.at<uchar>(y, x)));
-				}
-			}
-		}
+std::vector<float> MyImage::lineProfile(const std::vector<Point>& points, float line_width) {
+	flushPendingOps();
+	std::vector<cv::Point2f> path;
+	path.reserve(points.size());
+	for (const Point& point : points) {
+		path.emplace_back(static_cast<float>(point.x), static_cast<float>(point.y));
 	}
+	return computeLineProfile(image_mat, path, line_width);
+}
 
-	return profile;
+std::vector<float> MyImage::rectProfile(const cv::Rect& rect) {
+	flushPendingOps();
+	return computeRectProfile(image_mat, rect);
 }
@@ -19,6 +19,12 @@
 #include <opencv2/opencv.hpp>
 #include "BinaryProcessor.h"
 #include "FilterProcessor.h"
+#include "DisplayRange.h"
+#include "PointwisePipeline.h"
+#include "Histogram.h"
+#include "Profile.h"
+#include "Point.h"
+#include "MappedImage.h"
 
 /// ----------------------- 枚举与元数据结构 -----------------------
 
@@ -31,6 +37,9 @@ enum ColorDepth {
 	kRGBColor
 };
 
+// 按输入类型 type 向 ops 追加转换到 color_depth 的逐像素操作
+void appendColorDepthOps(PointwisePipeline& ops, int type, ColorDepth color_depth);
+
 /* 图像元数据 */
 struct ImageMetadata {
 	int dataset_size;              // 数据集大小
@@ -47,25 +56,39 @@ private:
 	std::string image_path;            // 图像路径
 	ImageMetadata image_metadata;      // 图像元数据
 	cv::Mat image_mat;                 // 图像 Mat 数据
+	std::shared_ptr<MappedFile> mapping; // 内存映射加载时 image_mat 最初指向的文件映射
 
 	int image_width;
 	int image_height;
 
+	DisplayMapper display;             // 显示范围映射（不修改 image_mat）
+	bool has_display_range = false;    // 是否设置过显示范围
+
+	PointwisePipeline pending_ops;     // 尚未执行的逐像素操作，连续命令融合为一次遍历
+	BitMask packed_mask;               // binary 命令得到的 0 / 255 掩码以每像素 1 位保存，此时 image_mat 为空
+
 public:
 	BinaryProcessor binary;            // 二值图处理器
 	FilterProcessor filter;            // 滤波图处理器
 
 	/// ----------------------- 构造与基本展示 -----------------------
 
-	// 从路径构造图像
-	MyImage(const std::string& image_path);
+	// 从路径构造图像；默认结果为 8 位 BGR（与 cv::imread 相同），未压缩的 24 位 BMP 通过内存映射加载；
+	// unchanged 为 true 时保留文件的位深与通道数，可映射的文件（未压缩 TIFF、BMP）都通过内存映射加载
+	MyImage(const std::string& image_path, bool unchanged = false);
+
+	// 按给定布局内存映射 RAW 文件
+	MyImage(const std::string& image_path, const RawImageInfo& raw_info);
+
+	// 使用已解码的图像构造（如图像栈的某一页），image_path 用于导出与标注文件命名
+	MyImage(const std::string& image_path, const cv::Mat& image_mat);
 
 	// 显示图像（仅用于测试）
-	void show() const;
+	void show();
 
 	/// ----------------------- 基本信息获取 -----------------------
 
-	cv::Mat& getImageMat();
+	cv::Mat& getImageMat();                    // 返回前会先执行所有待定的逐像素操作
 	std::string getImagePath() const;
 	int getWidth() const;
 	int getHeight() const;
@@ -101,9 +124,19 @@ public:
 
 	/// ----------------------- 图像调整 -----------------------
 
-	void setBrightnessContrast(int minimum, int maximum, double contrast, double brightness); // 亮度对比度调整
+	void setBrightnessContrast(int minimum, int maximum, double contrast, double brightness); // 亮度对比度调整（仅影响显示与导出）
+	void resetDisplayRange();                                                                 // 清除显示范围
+	bool hasDisplayRange() const;
+	const DisplayRange& getDisplayRange() const;
+	cv::Mat renderDisplay();                                                                  // 按显示范围生成 8 位显示图像
 	void threshold(int minimum, int maximum);                                                 // 阈值分割
 
+	/// ----------------------- 逐像素操作融合 -----------------------
+
+	void flushPendingOps();       // 一次遍历执行所有待定的逐像素操作（打包的二值图像先解包）
+	void prepareBinaryOps();      // binary 命令之前调用：执行待定操作，没有待定操作时打包的图像保持打包
+	int getPendingType() const;   // 执行待定操作后 image_mat 的类型
+
 	/// ----------------------- 图像处理 -----------------------
 
 	void smooth();   // 柔化（平滑）
@@ -111,8 +144,11 @@ public:
 
 	/// ----------------------- 图像分析 -----------------------
 
-	std::vector<float> histogram();                          // 灰度直方图
-	std::vector<float> plotProfile(const cv::Mat& mask);     // 灰度剖面线分析
+	HistogramResult histogram(const HistogramOptions& options = HistogramOptions()); // 各通道直方图（8U/16U/32F）
+	std::vector<float> plotProfile(const cv::Mat& mask);                              // 掩码内像素值（先构建 RLE 索引）
+	std::vector<float> plotProfile(const RunLengthMask& mask);                        // 掩码内像素值（按 run 遍历）
+	std::vector<float> lineProfile(const std::vector<Point>& points, float line_width = 1); // 沿折线的灰度剖面（双线性插值）
+	std::vector<float> rectProfile(const cv::Rect& rect);                             // 矩形内逐列平均的灰度剖面
 };
 
 #endif // MY_IMAGE_H
@@ -0,0 +1,274 @@
+﻿/// ----------------------- ParticleAnalyzer -----------------------
+///
+/// 说明：分条并行的并查集标记与颗粒统计，见 ParticleAnalyzer.h。
+///
+/// ----------------------- ParticleAnalyzer -----------------------
+
+#include "ParticleAnalyzer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+	const double kHalfDiagonal = 0.70710678118654752;   // √2 / 2
+
+	struct Accumulator {
+		int64_t area = 0;
+		int min_x = std::numeric_limits<int>::max();
+		int min_y = std::numeric_limits<int>::max();
+		int max_x = -1;
+		int max_y = -1;
+		int64_t sum_x = 0;
+		int64_t sum_y = 0;
+		double sum_intensity = 0;
+		double perimeter = 0;
+
+		void merge(const Accumulator& other) {
+			area += other.area;
+			min_x = std::min(min_x, other.min_x);
+			min_y = std::min(min_y, other.min_y);
+			max_x = std::max(max_x, other.max_x);
+			max_y = std::max(max_y, other.max_y);
+			sum_x += other.sum_x;
+			sum_y += other.sum_y;
+			sum_intensity += other.sum_intensity;
+			perimeter += other.perimeter;
+		}
+	};
+
+	// 并查集：合并时较大的根指向较小的根，因此根的编号不大于其成员
+	int findRoot(std::vector<int>& parent, int i) {
+		while (parent[i] != i) {
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	}
+
+	int unite(std::vector<int>& parent, int a, int b) {
+		a = findRoot(parent, a);
+		b = findRoot(parent, b);
+		if (a < b) {
+			parent[b] = a;
+			return a;
+		}
+		parent[a] = b;
+		return b;
+	}
+
+	struct Stripe {
+		int y0 = 0;
+		int y1 = 0;
+		std::vector<int> parent;            // 临时标签的并查集，下标 0 不用
+		std::vector<Accumulator> stats;     // 按临时标签累加的统计量
+	};
+
+	// 条带内的光栅扫描：标记、累加统计量与周长
+	void labelStripe(const cv::Mat& mask, const cv::Mat& intensity, cv::Mat& labels, Stripe& stripe, bool eight_connected) {
+		const int cols = mask.cols;
+		const int rows = mask.rows;
+		stripe.parent.assign(1, 0);
+		stripe.stats.assign(1, Accumulator());
+		std::vector<float> values(cols, 0.f);
+
+		for (int y = stripe.y0; y <= stripe.y1; ++y) {
+			// 标记第 y 行
+			if (y < stripe.y1) {
+				const uchar* m = mask.ptr<uchar>(y);
+				int* l = labels.ptr<int>(y);
+				const int* up = (y > stripe.y0) ? labels.ptr<int>(y - 1) : nullptr;
+				if (!intensity.empty()) {
+					cv::Mat row(1, cols, CV_32FC1, values.data());
+					intensity.row(y).convertTo(row, CV_32F);
+				}
+
+				for (int x = 0; x < cols; ++x) {
+					if (!m[x]) {
+						l[x] = 0;
+						continue;
+					}
+					int label = 0;
+					auto consider = [&](int n) {
+						if (n == 0) return;
+						label = (label == 0) ? findRoot(stripe.parent, n) : unite(stripe.parent, label, n);
+					};
+					if (x > 0) consider(l[x - 1]);
+					if (up) {
+						consider(up[x]);
+						if (eight_connected) {
+							if (x > 0) consider(up[x - 1]);
+							if (x + 1 < cols) consider(up[x + 1]);
+						}
+					}
+					if (label == 0) {
+						label = static_cast<int>(stripe.parent.size());
+						stripe.parent.push_back(label);
+						stripe.stats.emplace_back();
+					}
+					l[x] = label;
+
+					Accumulator& a = stripe.stats[label];
+					++a.area;
+					a.min_x = std::min(a.min_x, x);
+					a.max_x = std::max(a.max_x, x);
+					a.min_y = std::min(a.min_y, y);
+					a.max_y = std::max(a.max_y, y);
+					a.sum_x += x;
+					a.sum_y += y;
+					a.sum_intensity += values[x];
+				}
+			}
+
+			// 上下两行为 y - 1 与 y 的 2 x 2 窗口；只给本条带内的像素记入周长
+			const uchar* top = (y > 0) ? mask.ptr<uchar>(y - 1) : nullptr;
+			const uchar* bottom = (y < rows) ? mask.ptr<uchar>(y) : nullptr;
+			const int* top_labels = (y > stripe.y0) ? labels.ptr<int>(y - 1) : nullptr;
+			const int* bottom_labels = (y < stripe.y1) ? labels.ptr<int>(y) : nullptr;
+			for (int x = 0; x <= cols; ++x) {
+				const bool tl = top && x > 0 && top[x - 1];
+				const bool tr = top && x < cols && top[x];
+				const bool bl = bottom && x > 0 && bottom[x - 1];
+				const bool br = bottom && x < cols && bottom[x];
+				const int count = tl + tr + bl + br;
+				if (count == 0 || count == 4) {
+					continue;
+				}
+				// 每个前景像素分得的轮廓长度
+				double share;
+				if (count == 1) share = kHalfDiagonal;
+				else if (count == 3) share = kHalfDiagonal / 3;
+				else if (tl == br) share = kHalfDiagonal;    // 对角
+				else share = 0.5;
+
+				if (top_labels) {
+					if (tl) stripe.stats[top_labels[x - 1]].perimeter += share;
+					if (tr) stripe.stats[top_labels[x]].perimeter += share;
+				}
+				if (bottom_labels) {
+					if (bl) stripe.stats[bottom_labels[x - 1]].perimeter += share;
+					if (br) stripe.stats[bottom_labels[x]].perimeter += share;
+				}
+			}
+		}
+	}
+
+}
+
+
+ParticleResult analyzeParticles(const cv::Mat& mask, const cv::Mat& intensity, const ParticleOptions& options) {
+	ParticleResult result;
+	if (mask.empty()) {
+		std::cerr << "Error: Mask is empty." << std::endl;
+		return result;
+	}
+	CV_Assert(mask.type() == CV_8UC1);
+
+	cv::Mat gray = intensity;
+	if (!gray.empty() && gray.channels() > 1) {
+		cv::cvtColor(gray, gray, (gray.channels() == 4) ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+	}
+	if (!gray.empty() && gray.size() != mask.size()) {
+		std::cerr << "Error: Intensity image and mask differ in size." << std::endl;
+		gray = cv::Mat();
+	}
+
+	const int rows = mask.rows;
+	const int cols = mask.cols;
+	result.labels.create(mask.size(), CV_32SC1);
+
+	// 条带数取线程数的若干倍，交界合并只涉及 (条带数 - 1) 对相邻行
+	const int stripe_count = std::max(1, std::min(rows, 4 * cv::getNumThreads()));
+	std::vector<Stripe> stripes(stripe_count);
+	for (int s = 0; s < stripe_count; ++s) {
+		stripes[s].y0 = static_cast<int>(static_cast<int64_t>(rows) * s / stripe_count);
+		stripes[s].y1 = static_cast<int>(static_cast<int64_t>(rows) * (s + 1) / stripe_count);
+	}
+
+	cv::parallel_for_(cv::Range(0, stripe_count), [&](const cv::Range& range) {
+		for (int s = range.start; s < range.end; ++s) {
+			labelStripe(mask, gray, result.labels, stripes[s], options.eight_connected);
+		}
+	}, stripe_count);
+
+	// 全局并查集：条带 s 的临时标签 l 对应全局编号 offsets[s] + l
+	std::vector<int> offsets(stripe_count + 1, 0);
+	for (int s = 0; s < stripe_count; ++s) {
+		offsets[s + 1] = offsets[s] + static_cast<int>(stripes[s].parent.size()) - 1;
+	}
+	const int provisional = offsets[stripe_count];
+	std::vector<int> parent(provisional + 1);
+	parent[0] = 0;
+	for (int s = 0; s < stripe_count; ++s) {
+		for (int l = 1; l < static_cast<int>(stripes[s].parent.size()); ++l) {
+			parent[offsets[s] + l] = offsets[s] + findRoot(stripes[s].parent, l);
+		}
+	}
+
+	// 合并条带交界处相邻的标签
+	for (int s = 1; s < stripe_count; ++s) {
+		const int y = stripes[s].y0;
+		if (y == 0 || y >= rows) {
+			continue;
+		}
+		const int* l = result.labels.ptr<int>(y);
+		const int* up = result.labels.ptr<int>(y - 1);
+		const int up_offset = offsets[s - 1];
+		for (int x = 0; x < cols; ++x) {
+			if (!l[x]) continue;
+			const int a = offsets[s] + l[x];
+			if (up[x]) unite(parent, a, up_offset + up[x]);
+			if (options.eight_connected) {
+				if (x > 0 && up[x - 1]) unite(parent, a, up_offset + up[x - 1]);
+				if (x + 1 < cols && up[x + 1]) unite(parent, a, up_offset + up[x + 1]);
+			}
+		}
+	}
+
+	// 根的编号不大于其成员，按编号顺序即可分配连续的最终标签
+	std::vector<int> final_label(provisional + 1, 0);
+	int components = 0;
+	for (int g = 1; g <= provisional; ++g) {
+		const int root = findRoot(parent, g);
+		final_label[g] = (root == g) ? ++components : final_label[root];
+	}
+	result.components = components;
+
+	std::vector<Accumulator> totals(components + 1);
+	for (int s = 0; s < stripe_count; ++s) {
+		for (int l = 1; l < static_cast<int>(stripes[s].stats.size()); ++l) {
+			totals[final_label[offsets[s] + l]].merge(stripes[s].stats[l]);
+		}
+	}
+
+	// 临时标签改写为最终标签
+	cv::parallel_for_(cv::Range(0, stripe_count), [&](const cv::Range& range) {
+		for (int s = range.start; s < range.end; ++s) {
+			const int offset = offsets[s];
+			for (int y = stripes[s].y0; y < stripes[s].y1; ++y) {
+				int* l = result.labels.ptr<int>(y);
+				for (int x = 0; x < cols; ++x) {
+					if (l[x]) l[x] = final_label[offset + l[x]];
+				}
+			}
+		}
+	}, stripe_count);
+
+	for (int label = 1; label <= components; ++label) {
+		const Accumulator& a = totals[label];
+		Particle particle;
+		particle.label = label;
+		particle.area = a.area;
+		particle.bounds = cv::Rect(a.min_x, a.min_y, a.max_x - a.min_x + 1, a.max_y - a.min_y + 1);
+		particle.centroid = cv::Point2d(static_cast<double>(a.sum_x) / a.area, static_cast<double>(a.sum_y) / a.area);
+		particle.perimeter = a.perimeter;
+		particle.circularity = (a.perimeter > 0) ? std::min(1.0, 4 * CV_PI * a.area / (a.perimeter * a.perimeter)) : 0;
+		particle.mean = gray.empty() ? 0 : a.sum_intensity / a.area;
+
+		if (particle.area < options.min_area || particle.area > options.max_area) continue;
+		if (particle.circularity < options.min_circularity || particle.circularity > options.max_circularity) continue;
+		if (options.exclude_edges && (a.min_x == 0 || a.min_y == 0 || a.max_x == cols - 1 || a.max_y == rows - 1)) continue;
+		result.particles.push_back(particle);
+	}
+	return result;
+}
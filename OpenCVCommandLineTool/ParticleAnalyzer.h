@@ -0,0 +1,52 @@
+﻿/// ----------------------- ParticleAnalyzer -----------------------
+///
+/// 说明：二值图像的连通域标记与颗粒分析（对应 ImageJ 的 Analyze Particles）；
+///
+///      标记：图像按行分条，各条带并行做一遍光栅扫描，用条带内的并查集合并临时标签，
+///      同一遍中按临时标签累加面积、外接矩形、质心、周长与强度和；
+///      之后只在条带交界的两行之间合并并查集，再并行地把临时标签改写为连续的最终标签，
+///      统计量按最终标签合并，不需要第二次遍历像素来做统计。
+///
+///      周长：按 2 x 2 窗口（marching squares）累加经过像素中心的轮廓长度，
+///      斜边计 √2/2，直边计 1/2，对圆形物体接近 2πr；圆度 = 4π·面积 / 周长²，上限为 1。
+///
+/// ----------------------- ParticleAnalyzer -----------------------
+
+#pragma once
+#ifndef PARTICLE_ANALYZER_H
+#define PARTICLE_ANALYZER_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+struct ParticleOptions {
+	double min_area = 0;                                          // 面积下限（像素）
+	double max_area = std::numeric_limits<double>::infinity();    // 面积上限（像素）
+	double min_circularity = 0;
+	double max_circularity = 1;
+	bool exclude_edges = false;     // 与图像边界相接的颗粒不输出
+	bool eight_connected = true;    // false 时按 4 连通标记
+};
+
+struct Particle {
+	int label = 0;                  // 标签图中的编号（从 1 开始）
+	int64_t area = 0;
+	cv::Rect bounds;
+	cv::Point2d centroid;
+	double perimeter = 0;
+	double circularity = 0;
+	double mean = 0;                // 强度图像在颗粒内的均值；没有强度图像时为 0
+};
+
+struct ParticleResult {
+	int components = 0;             // 连通域总数（筛选前）
+	std::vector<Particle> particles; // 通过面积、圆度与边界筛选的颗粒
+	cv::Mat labels;                 // CV_32SC1 标签图，0 为背景，包含全部连通域
+};
+
+// mask 非零为前景（CV_8UC1）；intensity 可为空，多通道时按灰度统计，尺寸须与 mask 相同
+ParticleResult analyzeParticles(const cv::Mat& mask, const cv::Mat& intensity, const ParticleOptions& options = ParticleOptions());
+
+#endif // PARTICLE_ANALYZER_H
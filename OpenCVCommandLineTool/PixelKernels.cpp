@@ -0,0 +1,124 @@
+﻿/// ----------------------- PixelKernels -----------------------
+///
+/// 说明：按（位深, 通道数）在编译期特化的逐像素内核与分派层，见 PixelKernels.h。
+///
+/// ----------------------- PixelKernels -----------------------
+
+#include "PixelKernels.h"
+
+#include <cmath>
+#include <type_traits>
+
+bool isKernelType(int type) {
+	int depth = CV_MAT_DEPTH(type);
+	int channels = CV_MAT_CN(type);
+	return (depth == CV_8U || depth == CV_16U || depth == CV_32F) && (channels == 1 || channels == 3 || channels == 4);
+}
+
+
+double ChannelStatistics::mean(int c) const {
+	return count > 0 ? sum[c] / count : 0;
+}
+
+double ChannelStatistics::stddev(int c) const {
+	if (count < 2) {
+		return 0;
+	}
+	double variance = (sum_sq[c] - sum[c] * sum[c] / count) / (count - 1);
+	return variance > 0 ? std::sqrt(variance) : 0;
+}
+
+
+void kernelThreshold(const cv::Mat& src, cv::Mat& dst, double thresh, double maxval, bool inverse) {
+	const cv::Mat input = src;
+	bool handled = dispatchType(input.type(), [&](auto depth, auto channels) {
+		using T = typename decltype(depth)::type;
+		constexpr int CN = decltype(channels)::value;
+		// 与 cv::threshold 一致：整数图像的阈值向下取整，最大值取整饱和
+		float t = std::is_integral<T>::value ? static_cast<float>(std::floor(thresh)) : static_cast<float>(thresh);
+		dst.create(input.size(), input.type());
+		thresholdKernel<T, CN>(input, dst, t, cv::saturate_cast<T>(maxval), inverse);
+	});
+	if (!handled) {
+		cv::threshold(input, dst, thresh, maxval, inverse ? cv::THRESH_BINARY_INV : cv::THRESH_BINARY);
+	}
+}
+
+void kernelInvert(cv::Mat& image, double maxval) {
+	bool handled = dispatchType(image.type(), [&](auto depth, auto channels) {
+		using T = typename decltype(depth)::type;
+		constexpr int CN = decltype(channels)::value;
+		invertKernel<T, CN>(image, maxval);
+	});
+	if (!handled) {
+		image.convertTo(image, image.depth(), -1.0, maxval);
+	}
+}
+
+void kernelApplyLut(const cv::Mat& src, cv::Mat& dst, const cv::Mat& lut) {
+	CV_Assert(lut.type() == CV_8UC1 && (src.depth() == CV_8U || src.depth() == CV_16U));
+	CV_Assert(lut.total() == (src.depth() == CV_8U ? 256u : 65536u));
+
+	const cv::Mat input = src;
+	cv::Mat output(input.size(), CV_8UC(input.channels()));
+	const uchar* table = lut.ptr<uchar>();
+
+	// 查表与通道无关，非常规通道数按单通道的加宽行处理
+	cv::Mat flat_in = input.reshape(1);
+	cv::Mat flat_out = output.reshape(1);
+	if (input.depth() == CV_8U) {
+		lutKernel<uchar, 1>(flat_in, flat_out, table);
+	}
+	else {
+		lutKernel<ushort, 1>(flat_in, flat_out, table);
+	}
+	dst = output;
+}
+
+void kernelNonZeroMask(const cv::Mat& src, cv::Mat& dst) {
+	const cv::Mat input = src;
+	cv::Mat output(input.size(), CV_8UC1);
+	bool handled = dispatchType(input.type(), [&](auto depth, auto channels) {
+		using T = typename decltype(depth)::type;
+		constexpr int CN = decltype(channels)::value;
+		nonZeroMaskKernel<T, CN>(input, output);
+	});
+	if (!handled) {
+		cv::Mat as_float;
+		input.convertTo(as_float, CV_32F);
+		if (as_float.channels() > 1) {
+			// 任一通道非零：取各通道绝对值之和
+			as_float = cv::abs(as_float);
+			cv::transform(as_float, as_float, cv::Mat::ones(1, as_float.channels(), CV_32F));
+		}
+		cv::compare(as_float, 0, output, cv::CMP_NE);
+	}
+	dst = output;
+}
+
+ChannelStatistics kernelStatistics(const cv::Mat& src, const cv::Mat& mask) {
+	ChannelStatistics stats;
+	cv::Mat input = src;
+	if (!isKernelType(input.type())) {
+		input.convertTo(input, CV_32F);
+	}
+	if (!mask.empty() && (mask.size() != input.size() || mask.type() != CV_8UC1)) {
+		std::cerr << "Error: Statistics mask must be CV_8UC1 and match the image size." << std::endl;
+		return stats;
+	}
+
+	bool handled = dispatchType(input.type(), [&](auto depth, auto channels) {
+		using T = typename decltype(depth)::type;
+		constexpr int CN = decltype(channels)::value;
+		if (mask.empty()) {
+			statisticsKernel<T, CN, false>(input, mask, stats);
+		}
+		else {
+			statisticsKernel<T, CN, true>(input, mask, stats);
+		}
+	});
+	if (!handled) {
+		std::cerr << "Error: Unsupported channel count for statistics: " << input.channels() << std::endl;
+	}
+	return stats;
+}
@@ -0,0 +1,238 @@
+﻿/// ----------------------- PixelKernels -----------------------
+///
+/// 说明：按（位深, 通道数）在编译期特化的逐像素内核与分派层；
+///      dispatchType() 在每次调用入口根据 Mat 类型分派一次，
+///      内核以 <T, CN> 模板参数实例化，内层循环的通道数为常量，可被编译器完全展开与向量化。
+///
+///      支持的组合：8U / 16U / 32F × 1 / 3 / 4 通道；
+///      其余类型由各包装函数转换为受支持的类型或回退到 OpenCV 实现。
+///
+/// ----------------------- PixelKernels -----------------------
+
+#pragma once
+#ifndef PIXEL_KERNELS_H
+#define PIXEL_KERNELS_H
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+/// ----------------------- 分派 -----------------------
+
+template <typename T>
+struct DepthTag {
+	using type = T;
+};
+
+template <int N>
+struct ChannelTag {
+	static constexpr int value = N;
+};
+
+// 以 fn(DepthTag<T>, ChannelTag<CN>) 调用特化内核；类型不受支持时返回 false
+template <typename T, typename Fn>
+bool dispatchChannels(int channels, Fn&& fn) {
+	switch (channels) {
+	case 1: fn(DepthTag<T>(), ChannelTag<1>()); return true;
+	case 3: fn(DepthTag<T>(), ChannelTag<3>()); return true;
+	case 4: fn(DepthTag<T>(), ChannelTag<4>()); return true;
+	default: return false;
+	}
+}
+
+template <typename Fn>
+bool dispatchType(int type, Fn&& fn) {
+	switch (CV_MAT_DEPTH(type)) {
+	case CV_8U:  return dispatchChannels<uchar>(CV_MAT_CN(type), fn);
+	case CV_16U: return dispatchChannels<ushort>(CV_MAT_CN(type), fn);
+	case CV_32F: return dispatchChannels<float>(CV_MAT_CN(type), fn);
+	default: return false;
+	}
+}
+
+// 仅按位深分派（通道数在运行时处理的内核）
+template <typename Fn>
+bool dispatchDepth(int depth, Fn&& fn) {
+	switch (depth) {
+	case CV_8U:  fn(DepthTag<uchar>()); return true;
+	case CV_16U: fn(DepthTag<ushort>()); return true;
+	case CV_32F: fn(DepthTag<float>()); return true;
+	default: return false;
+	}
+}
+
+bool isKernelType(int type);
+
+/// ----------------------- 内核模板 -----------------------
+
+// 按行并行执行 body(y)
+template <typename Body>
+void forEachRow(int rows, const Body& body) {
+	cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+		for (int y = range.start; y < range.end; ++y) {
+			body(y);
+		}
+	});
+}
+
+// 一个像素各通道的平均值
+template <typename T, int CN>
+inline float pixelMean(const T* p) {
+	float sum = 0;
+	for (int c = 0; c < CN; ++c) {
+		sum += static_cast<float>(p[c]);
+	}
+	return sum / CN;
+}
+
+// v > thresh ? maxval : 0（inverse 时取反），逐通道；阈值以 float 比较，超出 T 的范围时结果仍正确
+template <typename T, int CN>
+void thresholdKernel(const cv::Mat& src, cv::Mat& dst, float thresh, T maxval, bool inverse) {
+	const T above = inverse ? T(0) : maxval;
+	const T below = inverse ? maxval : T(0);
+	const int n = src.cols * CN;
+	forEachRow(src.rows, [&](int y) {
+		const T* in = src.ptr<T>(y);
+		T* out = dst.ptr<T>(y);
+		for (int i = 0; i < n; ++i) {
+			out[i] = in[i] > thresh ? above : below;
+		}
+	});
+}
+
+// maxval - v，逐通道饱和
+template <typename T, int CN>
+void invertKernel(cv::Mat& image, double maxval) {
+	const int n = image.cols * CN;
+	const float m = static_cast<float>(maxval);
+	forEachRow(image.rows, [&](int y) {
+		T* p = image.ptr<T>(y);
+		for (int i = 0; i < n; ++i) {
+			p[i] = cv::saturate_cast<T>(m - static_cast<float>(p[i]));
+		}
+	});
+}
+
+// 整数像素经查找表映射为 8 位（表项数覆盖 T 的取值范围）
+template <typename T, int CN>
+void lutKernel(const cv::Mat& src, cv::Mat& dst, const uchar* table) {
+	const int n = src.cols * CN;
+	forEachRow(src.rows, [&](int y) {
+		const T* in = src.ptr<T>(y);
+		uchar* out = dst.ptr<uchar>(y);
+		for (int i = 0; i < n; ++i) {
+			out[i] = table[in[i]];
+		}
+	});
+}
+
+// 任一通道非零 -> 255，输出 CV_8UC1
+template <typename T, int CN>
+void nonZeroMaskKernel(const cv::Mat& src, cv::Mat& dst) {
+	forEachRow(src.rows, [&](int y) {
+		const T* in = src.ptr<T>(y);
+		uchar* out = dst.ptr<uchar>(y);
+		for (int x = 0; x < src.cols; ++x, in += CN) {
+			bool any = false;
+			for (int c = 0; c < CN; ++c) {
+				any = any || (in[c] != T(0));
+			}
+			out[x] = any ? 255 : 0;
+		}
+	});
+}
+
+/// ----------------------- 统计 -----------------------
+
+struct ChannelStatistics {
+	int channels = 0;
+	uint64_t count = 0;              // 参与统计的像素数
+	double sum[4] = { 0, 0, 0, 0 };
+	double sum_sq[4] = { 0, 0, 0, 0 };
+	double min[4] = { 0, 0, 0, 0 };
+	double max[4] = { 0, 0, 0, 0 };
+
+	double mean(int c) const;
+	double stddev(int c) const;      // 样本标准差（n - 1）
+};
+
+// 掩码内各通道的和、平方和、最小值、最大值；线程私有累加后合并
+template <typename T, int CN, bool UseMask>
+void statisticsKernel(const cv::Mat& src, const cv::Mat& mask, ChannelStatistics& stats) {
+	std::mutex merge_mutex;
+	stats.channels = CN;
+	stats.count = 0;
+	for (int c = 0; c < CN; ++c) {
+		stats.sum[c] = stats.sum_sq[c] = 0;
+		stats.min[c] = std::numeric_limits<double>::max();
+		stats.max[c] = std::numeric_limits<double>::lowest();
+	}
+
+	cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& rows) {
+		uint64_t count = 0;
+		double sum[CN], sum_sq[CN];
+		T lo[CN], hi[CN];
+		for (int c = 0; c < CN; ++c) {
+			sum[c] = sum_sq[c] = 0;
+			lo[c] = std::numeric_limits<T>::max();
+			hi[c] = std::numeric_limits<T>::lowest();
+		}
+		for (int y = rows.start; y < rows.end; ++y) {
+			const T* p = src.ptr<T>(y);
+			const uchar* m = UseMask ? mask.ptr<uchar>(y) : nullptr;
+			for (int x = 0; x < src.cols; ++x, p += CN) {
+				if (UseMask && !m[x]) {
+					continue;
+				}
+				++count;
+				for (int c = 0; c < CN; ++c) {
+					double v = static_cast<double>(p[c]);
+					sum[c] += v;
+					sum_sq[c] += v * v;
+					lo[c] = std::min(lo[c], p[c]);
+					hi[c] = std::max(hi[c], p[c]);
+				}
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(merge_mutex);
+		stats.count += count;
+		for (int c = 0; c < CN; ++c) {
+			stats.sum[c] += sum[c];
+			stats.sum_sq[c] += sum_sq[c];
+			if (count > 0) {
+				stats.min[c] = std::min(stats.min[c], static_cast<double>(lo[c]));
+				stats.max[c] = std::max(stats.max[c], static_cast<double>(hi[c]));
+			}
+		}
+	}, cv::getNumThreads());
+
+	if (stats.count == 0) {
+		for (int c = 0; c < CN; ++c) {
+			stats.min[c] = stats.max[c] = 0;
+		}
+	}
+}
+
+/// ----------------------- 包装函数 -----------------------
+/// 说明：入口处分派一次；不受支持的类型回退到 OpenCV 实现。
+
+// 逐通道阈值，dst 与 src 类型相同（可原地）
+void kernelThreshold(const cv::Mat& src, cv::Mat& dst, double thresh, double maxval, bool inverse = false);
+
+// 原地反相：maxval - v
+void kernelInvert(cv::Mat& image, double maxval);
+
+// 8U/16U 图像经 256/65536 项 CV_8U 查找表映射为 8 位图像
+void kernelApplyLut(const cv::Mat& src, cv::Mat& dst, const cv::Mat& lut);
+
+// 任一通道非零的像素置为 255，输出 CV_8UC1
+void kernelNonZeroMask(const cv::Mat& src, cv::Mat& dst);
+
+// 掩码（可为空）内各通道统计量
+ChannelStatistics kernelStatistics(const cv::Mat& src, const cv::Mat& mask = cv::Mat());
+
+#endif // PIXEL_KERNELS_H
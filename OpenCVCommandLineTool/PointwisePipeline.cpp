@@ -0,0 +1,340 @@
+﻿/// ----------------------- PointwisePipeline -----------------------
+///
+/// 说明：逐像素操作的融合流水线（op-list），见 PointwisePipeline.h。
+///
+/// ----------------------- PointwisePipeline -----------------------
+
+#include "PointwisePipeline.h"
+#include "PixelKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+	/* 流水线中每一步的输入/输出格式 */
+	struct Stage {
+		PointwiseOp op;
+		int channels_in;
+		int channels_out;
+		int depth_in;
+		int depth_out;
+	};
+
+	// cvtColor 整数位深 BGR2GRAY 的定点系数（0.114 / 0.587 / 0.299 乘以 2^14）
+	const int kGrayShift = 14;
+	const uint32_t kGrayB = 1868;
+	const uint32_t kGrayG = 9617;
+	const uint32_t kGrayR = 4899;
+
+	// 融合内核使用 float 行缓冲区，仅在这些位深下与 OpenCV 的结果完全一致
+	bool isFusableDepth(int depth) {
+		return depth == CV_8U || depth == CV_16U || depth == CV_16S || depth == CV_32F;
+	}
+
+	// 按位深取整并饱和（与 saturate_cast 一致，四舍六入五成双）
+	void quantize(float* buf, int n, int depth) {
+		float lo, hi;
+		switch (depth) {
+		case CV_8U:  lo = 0.f;      hi = 255.f;   break;
+		case CV_16U: lo = 0.f;      hi = 65535.f; break;
+		case CV_16S: lo = -32768.f; hi = 32767.f; break;
+		default: return; // 浮点无需取整
+		}
+		for (int i = 0; i < n; ++i) {
+			buf[i] = std::min(std::max(std::nearbyint(buf[i]), lo), hi);
+		}
+	}
+
+	// 整数位深下阈值向下取整、最大值取整饱和，与 cv::threshold 一致
+	void thresholdParams(const PointwiseOp& op, int depth, float& thresh, float& maxval) {
+		if (depth == CV_32F) {
+			thresh = static_cast<float>(op.thresh);
+			maxval = static_cast<float>(op.maxval);
+			return;
+		}
+		thresh = static_cast<float>(std::floor(op.thresh));
+		maxval = static_cast<float>(op.maxval);
+		quantize(&maxval, 1, depth);
+	}
+
+	template <typename T>
+	void loadRow(const cv::Mat& src, int y, float* buf, int n) {
+		const T* in = src.ptr<T>(y);
+		for (int i = 0; i < n; ++i) {
+			buf[i] = static_cast<float>(in[i]);
+		}
+	}
+
+	template <typename T>
+	void storeRow(cv::Mat& dst, int y, const float* buf, int n) {
+		T* out = dst.ptr<T>(y);
+		for (int i = 0; i < n; ++i) {
+			out[i] = cv::saturate_cast<T>(buf[i]);
+		}
+	}
+
+	void loadRow(const cv::Mat& src, int y, float* buf, int n) {
+		switch (src.depth()) {
+		case CV_8U:  loadRow<uchar>(src, y, buf, n);  break;
+		case CV_16U: loadRow<ushort>(src, y, buf, n); break;
+		case CV_16S: loadRow<short>(src, y, buf, n);  break;
+		default:     loadRow<float>(src, y, buf, n);  break;
+		}
+	}
+
+	void storeRow(cv::Mat& dst, int y, const float* buf, int n) {
+		switch (dst.depth()) {
+		case CV_8U:  storeRow<uchar>(dst, y, buf, n);  break;
+		case CV_16U: storeRow<ushort>(dst, y, buf, n); break;
+		case CV_16S: storeRow<short>(dst, y, buf, n);  break;
+		default:     storeRow<float>(dst, y, buf, n);  break;
+		}
+	}
+
+	// 在行缓冲区上执行一步操作，结果写入 out
+	void runStage(const Stage& s, const float* in, float* out, int cols) {
+		const PointwiseOp& op = s.op;
+		const int n = cols * s.channels_out;
+
+		switch (op.type) {
+		case kOpToGray: {
+			const int cn = s.channels_in;
+			if (s.depth_in == CV_8U || s.depth_in == CV_16U) {
+				// 与 cvtColor 的整数路径相同：14 位定点系数，加半后右移
+				for (int x = 0; x < cols; ++x) {
+					const float* p = in + x * cn;
+					const uint32_t sum = static_cast<uint32_t>(p[0]) * kGrayB + static_cast<uint32_t>(p[1]) * kGrayG
+						+ static_cast<uint32_t>(p[2]) * kGrayR + (1u << (kGrayShift - 1));
+					out[x] = static_cast<float>(sum >> kGrayShift);
+				}
+				break;
+			}
+			for (int x = 0; x < cols; ++x) {
+				const float* p = in + x * cn;
+				out[x] = 0.114f * p[0] + 0.587f * p[1] + 0.299f * p[2];
+			}
+			quantize(out, n, s.depth_out);
+			break;
+		}
+		case kOpToColor:
+			for (int x = 0; x < cols; ++x) {
+				out[3 * x] = out[3 * x + 1] = out[3 * x + 2] = in[x];
+			}
+			break;
+		case kOpDropAlpha:
+			for (int x = 0; x < cols; ++x) {
+				out[3 * x] = in[4 * x];
+				out[3 * x + 1] = in[4 * x + 1];
+				out[3 * x + 2] = in[4 * x + 2];
+			}
+			break;
+		case kOpConvert: {
+			const float a = static_cast<float>(op.alpha);
+			const float b = static_cast<float>(op.beta);
+			for (int i = 0; i < n; ++i) {
+				out[i] = in[i] * a + b;
+			}
+			quantize(out, n, s.depth_out);
+			break;
+		}
+		case kOpThreshold: {
+			float thresh, maxval;
+			thresholdParams(op, s.depth_in, thresh, maxval);
+			const float above = op.inverse ? 0.f : maxval;
+			const float below = op.inverse ? maxval : 0.f;
+			for (int i = 0; i < n; ++i) {
+				out[i] = in[i] > thresh ? above : below;
+			}
+			break;
+		}
+		case kOpInvert: {
+			const float m = static_cast<float>(op.maxval);
+			for (int i = 0; i < n; ++i) {
+				out[i] = m - in[i];
+			}
+			quantize(out, n, s.depth_out);
+			break;
+		}
+		}
+	}
+
+	// 逐条执行的参考实现，语义即各 OpenCV 调用本身
+	void applyStep(const PointwiseOp& op, cv::Mat& image) {
+		switch (op.type) {
+		case kOpToGray:
+			cv::cvtColor(image, image, cv::COLOR_BGR2GRAY);
+			break;
+		case kOpToColor:
+			cv::cvtColor(image, image, cv::COLOR_GRAY2BGR);
+			break;
+		case kOpDropAlpha:
+			cv::cvtColor(image, image, cv::COLOR_BGRA2BGR);
+			break;
+		case kOpConvert:
+			image.convertTo(image, op.depth, op.alpha, op.beta);
+			break;
+		case kOpThreshold:
+			cv::threshold(image, image, op.thresh, op.maxval, op.inverse ? cv::THRESH_BINARY_INV : cv::THRESH_BINARY);
+			break;
+		case kOpInvert:
+			image.convertTo(image, image.depth(), -1.0, op.maxval);
+			break;
+		}
+	}
+
+	std::vector<Stage> compile(const std::vector<PointwiseOp>& ops, int input_type) {
+		std::vector<Stage> stages;
+		int cn = CV_MAT_CN(input_type);
+		int depth = CV_MAT_DEPTH(input_type);
+
+		for (const PointwiseOp& op : ops) {
+			Stage s{ op, cn, cn, depth, depth };
+			switch (op.type) {
+			case kOpToGray:    s.channels_out = 1; break;
+			case kOpToColor:   s.channels_out = 3; break;
+			case kOpDropAlpha: s.channels_out = 3; break;
+			case kOpConvert:   s.depth_out = op.depth; break;
+			default: break;
+			}
+			cn = s.channels_out;
+			depth = s.depth_out;
+			stages.push_back(s);
+		}
+		return stages;
+	}
+
+}
+
+
+/// ----------------------- 添加操作 -----------------------
+
+void PointwisePipeline::addToGray() {
+	PointwiseOp op{ kOpToGray };
+	ops.push_back(op);
+}
+
+void PointwisePipeline::addToColor() {
+	PointwiseOp op{ kOpToColor };
+	ops.push_back(op);
+}
+
+void PointwisePipeline::addDropAlpha() {
+	PointwiseOp op{ kOpDropAlpha };
+	ops.push_back(op);
+}
+
+void PointwisePipeline::addConvert(int depth, double alpha, double beta) {
+	PointwiseOp op{ kOpConvert };
+	op.depth = depth;
+	op.alpha = alpha;
+	op.beta = beta;
+	ops.push_back(op);
+}
+
+void PointwisePipeline::addThreshold(double thresh, double maxval, bool inverse) {
+	PointwiseOp op{ kOpThreshold };
+	op.thresh = thresh;
+	op.maxval = maxval;
+	op.inverse = inverse;
+	ops.push_back(op);
+}
+
+void PointwisePipeline::addInvert(double maxval) {
+	PointwiseOp op{ kOpInvert };
+	op.maxval = maxval;
+	ops.push_back(op);
+}
+
+
+/// ----------------------- 状态 -----------------------
+
+bool PointwisePipeline::empty() const {
+	return ops.empty();
+}
+
+size_t PointwisePipeline::size() const {
+	return ops.size();
+}
+
+void PointwisePipeline::clear() {
+	ops.clear();
+}
+
+int PointwisePipeline::outputType(int input_type) const {
+	std::vector<Stage> stages = compile(ops, input_type);
+	if (stages.empty()) {
+		return input_type;
+	}
+	return CV_MAKETYPE(stages.back().depth_out, stages.back().channels_out);
+}
+
+
+/// ----------------------- 执行 -----------------------
+
+void PointwisePipeline::applySequential(const cv::Mat& src, cv::Mat& dst) const {
+	cv::Mat image = src.clone();
+	for (const PointwiseOp& op : ops) {
+		applyStep(op, image);
+	}
+	dst = image;
+}
+
+void PointwisePipeline::apply(const cv::Mat& src, cv::Mat& dst) const {
+	// 持有输入的头，dst 与 src 为同一对象时重新分配也不会释放输入数据
+	const cv::Mat input = src;
+	if (ops.empty()) {
+		if (&dst != &src) input.copyTo(dst);
+		return;
+	}
+
+	// 单个阈值/反相操作直接使用按类型特化的内核，无需经过 float 行缓冲区
+	if (ops.size() == 1 && isKernelType(input.type())) {
+		const PointwiseOp& op = ops.front();
+		if (op.type == kOpThreshold) {
+			kernelThreshold(input, dst, op.thresh, op.maxval, op.inverse);
+			return;
+		}
+		if (op.type == kOpInvert) {
+			if (&dst != &src) input.copyTo(dst);
+			kernelInvert(dst, op.maxval);
+			return;
+		}
+	}
+
+	std::vector<Stage> stages = compile(ops, input.type());
+
+	bool fusable = isFusableDepth(input.depth());
+	int max_channels = input.channels();
+	for (const Stage& s : stages) {
+		fusable = fusable && isFusableDepth(s.depth_out);
+		max_channels = std::max(max_channels, s.channels_out);
+	}
+	if (!fusable) {
+		applySequential(input, dst);
+		return;
+	}
+
+	const Stage& last = stages.back();
+	dst.create(input.size(), CV_MAKETYPE(last.depth_out, last.channels_out));
+	cv::Mat output = dst;
+
+	const int cols = input.cols;
+	const int buffer_length = cols * max_channels;
+
+	// 每个线程持有两块行缓冲区交替使用；同一行先读完再写回，因此可以原地执行
+	cv::parallel_for_(cv::Range(0, input.rows), [&](const cv::Range& rows) {
+		std::vector<float> ping(buffer_length), pong(buffer_length);
+		for (int y = rows.start; y < rows.end; ++y) {
+			float* cur = ping.data();
+			float* next = pong.data();
+			loadRow(input, y, cur, cols * input.channels());
+			for (const Stage& s : stages) {
+				runStage(s, cur, next, cols);
+				std::swap(cur, next);
+			}
+			storeRow(output, y, cur, cols * last.channels_out);
+		}
+	});
+}
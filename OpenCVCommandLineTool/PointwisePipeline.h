@@ -0,0 +1,72 @@
+﻿/// ----------------------- PointwisePipeline -----------------------
+///
+/// 说明：逐像素操作的融合流水线（op-list）；
+///      连续的逐像素命令（灰度/彩色转换、位深转换、阈值、反相）只记录为操作列表，
+///      在真正需要像素数据时一次性执行：每行读入一次、在行缓冲区内依次完成所有操作、写回一次，
+///      并按行并行，避免每个命令各自遍历整幅图像。
+///
+///      每一步的取整与饱和规则与对应的 OpenCV 调用（cvtColor / convertTo / threshold）一致，
+///      因此融合执行与逐条执行的结果相同。
+///
+/// ----------------------- PointwisePipeline -----------------------
+
+#pragma once
+#ifndef POINTWISE_PIPELINE_H
+#define POINTWISE_PIPELINE_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+/* 逐像素操作类型 */
+enum PointwiseOpType {
+	kOpToGray,      // BGR/BGRA -> GRAY
+	kOpToColor,     // GRAY -> BGR
+	kOpDropAlpha,   // BGRA -> BGR
+	kOpConvert,     // v * alpha + beta，并转换到目标位深
+	kOpThreshold,   // v > thresh ? maxval : 0（inverse 时取反）
+	kOpInvert       // maxval - v
+};
+
+struct PointwiseOp {
+	PointwiseOpType type;
+	int depth = -1;        // kOpConvert 的目标位深
+	double alpha = 1;      // kOpConvert 的缩放
+	double beta = 0;       // kOpConvert 的偏移
+	double thresh = 0;     // kOpThreshold 的阈值
+	double maxval = 255;   // kOpThreshold / kOpInvert 的最大值
+	bool inverse = false;  // kOpThreshold 是否取反
+};
+
+class PointwisePipeline {
+private:
+	std::vector<PointwiseOp> ops;
+
+	// 逐条使用 OpenCV 执行（融合内核不支持的位深时使用）
+	void applySequential(const cv::Mat& src, cv::Mat& dst) const;
+
+public:
+	/// ----------------------- 添加操作 -----------------------
+
+	void addToGray();
+	void addToColor();
+	void addDropAlpha();
+	void addConvert(int depth, double alpha = 1, double beta = 0);
+	void addThreshold(double thresh, double maxval, bool inverse = false);
+	void addInvert(double maxval);
+
+	/// ----------------------- 状态 -----------------------
+
+	bool empty() const;
+	size_t size() const;
+	void clear();
+
+	// 输入类型为 input_type 时，流水线输出的类型
+	int outputType(int input_type) const;
+
+	/// ----------------------- 执行 -----------------------
+
+	// 一次遍历执行全部操作；dst 可以与 src 相同（原地执行）
+	void apply(const cv::Mat& src, cv::Mat& dst) const;
+};
+
+#endif // POINTWISE_PIPELINE_H
@@ -0,0 +1,75 @@
+﻿/// ----------------------- PolygonTracing -----------------------
+///
+/// 说明：轮廓追踪与 Douglas-Peucker 简化，见 PolygonTracing.h。
+///
+/// ----------------------- PolygonTracing -----------------------
+
+#include "PolygonTracing.h"
+#include "TileExecutor.h"
+
+#include <atomic>
+
+std::vector<Point> traceMaskPolygon(const cv::Mat& box_mask, cv::Point offset, double tolerance) {
+	std::vector<Point> polygon;
+	if (box_mask.empty()) {
+		return polygon;
+	}
+	cv::Mat mask;
+	if (box_mask.type() == CV_8UC1) {
+		mask = box_mask;
+	}
+	else {
+		box_mask.convertTo(mask, CV_8U);
+	}
+
+	// 四周补一圈背景，贴边的实例也能得到闭合轮廓
+	cv::Mat padded;
+	cv::copyMakeBorder(mask, padded, 1, 1, 1, 1, cv::BORDER_CONSTANT, cv::Scalar(0));
+	std::vector<std::vector<cv::Point>> contours;
+	cv::findContours(padded, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
+	if (contours.empty()) {
+		return polygon;
+	}
+
+	size_t largest = 0;
+	double largest_area = -1;
+	for (size_t i = 0; i < contours.size(); ++i) {
+		const double area = cv::contourArea(contours[i]);
+		if (area > largest_area) {
+			largest_area = area;
+			largest = i;
+		}
+	}
+
+	std::vector<cv::Point> simplified;
+	cv::approxPolyDP(contours[largest], simplified, tolerance, true);
+	if (simplified.size() < 3) {
+		return polygon;
+	}
+	polygon.reserve(simplified.size());
+	for (const cv::Point& p : simplified) {
+		polygon.emplace_back(offset.x + p.x - 1, offset.y + p.y - 1);   // 减去补边
+	}
+	return polygon;
+}
+
+int convertMasksToPolygons(std::vector<MyShape>& shapes, double tolerance) {
+	std::atomic<int> converted(0);
+	const int threads = TileExecutor::threadCount(TileExecutor::getOptions());
+	runWorkStealing(static_cast<int>(shapes.size()), threads, [&](int i) {
+		MyShape& shape = shapes[i];
+		const SegmentOutput& segment = shape.getSegmentOutput();
+		if (segment._boxMask.empty()) {
+			return;
+		}
+		const cv::Point offset(cvRound(segment._box.x), cvRound(segment._box.y));
+		std::vector<Point> polygon = traceMaskPolygon(segment._boxMask, offset, tolerance);
+		if (polygon.empty()) {
+			return;
+		}
+		shape.setPoints(polygon);
+		shape.setShapeType(1);
+		++converted;
+	});
+	return converted;
+}
@@ -0,0 +1,29 @@
+﻿/// ----------------------- PolygonTracing -----------------------
+///
+/// 说明：实例掩码转多边形标注；
+///      模型输出的实例只以两点外接矩形（shape_type 2）保存，掩码仅在内存中，
+///      转换后每个实例保存为一个多边形（shape_type 1），标注 JSON 即可描述实例轮廓，
+///      体积远小于整幅图像的掩码 PNG。
+///
+///      每个实例在自身的框内掩码上追踪外轮廓（取面积最大的一个连通域），
+///      再用 Douglas-Peucker 算法按容差简化：去掉与简化折线距离不超过容差的顶点。
+///      各实例互相独立，由工作窃取线程池并行处理。
+///
+/// ----------------------- PolygonTracing -----------------------
+
+#pragma once
+#ifndef POLYGON_TRACING_H
+#define POLYGON_TRACING_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "MyShape.h"
+#include "Point.h"
+
+// box_mask 非零为前景，offset 为掩码左上角在图像中的位置；返回图像坐标的多边形，不足 3 个顶点时为空
+std::vector<Point> traceMaskPolygon(const cv::Mat& box_mask, cv::Point offset, double tolerance);
+
+// 有实例掩码的形状改为多边形（shape_type 1），实例掩码仍保留在内存中；返回转换的形状数
+int convertMasksToPolygons(std::vector<MyShape>& shapes, double tolerance);
+
+#endif // POLYGON_TRACING_H
@@ -0,0 +1,210 @@
+﻿/// ----------------------- Profile -----------------------
+///
+/// 说明：灰度剖面分析，见 Profile.h。
+///
+/// ----------------------- Profile -----------------------
+
+#include "Profile.h"
+#include "PixelKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+	// 内核支持的类型：深度与通道数在编译期确定
+	template <typename T, int CN>
+	struct FixedPixel {
+		static float mean(const cv::Mat& image, int x, int y) {
+			return pixelMean<T, CN>(image.ptr<T>(y) + static_cast<size_t>(x) * CN);
+		}
+	};
+
+	// 其他深度或通道数：通道数在运行时读取，只读取采样到的像素，不转换整幅图像
+	template <typename T>
+	struct AnyChannelPixel {
+		static float mean(const cv::Mat& image, int x, int y) {
+			const int cn = image.channels();
+			const T* p = image.ptr<T>(y) + static_cast<size_t>(x) * cn;
+			float sum = 0;
+			for (int c = 0; c < cn; ++c) {
+				sum += static_cast<float>(p[c]);
+			}
+			return sum / cn;
+		}
+	};
+
+	// 按图像类型选择像素读取方式并调用 f(Pixel())；不支持的深度（如 16F）返回 false
+	template <typename F>
+	bool dispatchPixel(const cv::Mat& image, F&& f) {
+		bool handled = dispatchType(image.type(), [&](auto depth, auto channels) {
+			using T = typename decltype(depth)::type;
+			constexpr int CN = decltype(channels)::value;
+			f(FixedPixel<T, CN>());
+		});
+		if (handled) {
+			return true;
+		}
+		switch (image.depth()) {
+		case CV_8U: f(AnyChannelPixel<uchar>()); return true;
+		case CV_8S: f(AnyChannelPixel<schar>()); return true;
+		case CV_16U: f(AnyChannelPixel<ushort>()); return true;
+		case CV_16S: f(AnyChannelPixel<short>()); return true;
+		case CV_32S: f(AnyChannelPixel<int>()); return true;
+		case CV_32F: f(AnyChannelPixel<float>()); return true;
+		case CV_64F: f(AnyChannelPixel<double>()); return true;
+		default: return false;
+		}
+	}
+
+	// 双线性插值，坐标超出图像时取边缘像素；多通道取平均
+	template <typename Pixel>
+	float sampleBilinear(const cv::Mat& image, float x, float y) {
+		x = std::min(std::max(x, 0.f), static_cast<float>(image.cols - 1));
+		y = std::min(std::max(y, 0.f), static_cast<float>(image.rows - 1));
+
+		int x0 = static_cast<int>(x);
+		int y0 = static_cast<int>(y);
+		int x1 = std::min(x0 + 1, image.cols - 1);
+		int y1 = std::min(y0 + 1, image.rows - 1);
+		float fx = x - x0;
+		float fy = y - y0;
+
+		float top = (1 - fx) * Pixel::mean(image, x0, y0) + fx * Pixel::mean(image, x1, y0);
+		float bottom = (1 - fx) * Pixel::mean(image, x0, y1) + fx * Pixel::mean(image, x1, y1);
+		return (1 - fy) * top + fy * bottom;
+	}
+
+	template <typename Pixel>
+	std::vector<float> lineProfile(const cv::Mat& image, const std::vector<cv::Point2f>& points, float line_width) {
+		std::vector<float> profile;
+		if (points.size() == 1) {
+			profile.push_back(sampleBilinear<Pixel>(image, points[0].x, points[0].y));
+			return profile;
+		}
+
+		// 法线方向上的采样偏移
+		int width_samples = std::max(1, static_cast<int>(std::lround(line_width)));
+		std::vector<float> offsets(width_samples);
+		for (int j = 0; j < width_samples; ++j) {
+			offsets[j] = j - (width_samples - 1) / 2.0f;
+		}
+
+		for (size_t s = 0; s + 1 < points.size(); ++s) {
+			const cv::Point2f& p0 = points[s];
+			const cv::Point2f& p1 = points[s + 1];
+			float dx = p1.x - p0.x;
+			float dy = p1.y - p0.y;
+			float length = std::sqrt(dx * dx + dy * dy);
+			if (length == 0 && !(s == 0 && points.size() == 2)) {
+				continue;
+			}
+
+			int steps = std::max(1, static_cast<int>(std::lround(length)));
+			float nx = length > 0 ? -dy / length : 0.f;
+			float ny = length > 0 ? dx / length : 0.f;
+
+			// 相邻线段共享端点，只在第一段采样起点
+			for (int i = (profile.empty() ? 0 : 1); i <= steps; ++i) {
+				float t = static_cast<float>(i) / steps;
+				float x = p0.x + t * dx;
+				float y = p0.y + t * dy;
+				float sum = 0;
+				for (float o : offsets) {
+					sum += sampleBilinear<Pixel>(image, x + o * nx, y + o * ny);
+				}
+				profile.push_back(sum / width_samples);
+			}
+		}
+		return profile;
+	}
+
+	template <typename Pixel>
+	std::vector<float> maskProfile(const cv::Mat& image, const RunLengthMask& mask) {
+		const std::vector<MaskRun>& runs = mask.getRuns();
+
+		// 每个 run 在结果中的起始位置
+		std::vector<size_t> starts(runs.size() + 1, 0);
+		for (size_t i = 0; i < runs.size(); ++i) {
+			starts[i + 1] = starts[i] + (runs[i].x_end - runs[i].x_begin);
+		}
+
+		std::vector<float> profile(starts.back());
+		cv::parallel_for_(cv::Range(0, static_cast<int>(runs.size())), [&](const cv::Range& range) {
+			for (int i = range.start; i < range.end; ++i) {
+				const MaskRun& run = runs[i];
+				float* out = profile.data() + starts[i];
+				for (int x = run.x_begin; x < run.x_end; ++x) {
+					*out++ = Pixel::mean(image, x, run.y);
+				}
+			}
+		});
+		return profile;
+	}
+
+	template <typename Pixel>
+	std::vector<float> rectProfile(const cv::Mat& image, const cv::Rect& rect) {
+		std::vector<float> profile(rect.width);
+		cv::parallel_for_(cv::Range(0, rect.width), [&](const cv::Range& columns) {
+			std::vector<double> sums(columns.size(), 0.0);
+			for (int y = rect.y; y < rect.y + rect.height; ++y) {
+				for (int i = columns.start; i < columns.end; ++i) {
+					sums[i - columns.start] += Pixel::mean(image, rect.x + i, y);
+				}
+			}
+			for (int i = columns.start; i < columns.end; ++i) {
+				profile[i] = static_cast<float>(sums[i - columns.start] / rect.height);
+			}
+		});
+		return profile;
+	}
+
+}
+
+
+std::vector<float> computeLineProfile(const cv::Mat& image, const std::vector<cv::Point2f>& points, float line_width) {
+	if (image.empty() || points.empty()) {
+		return {};
+	}
+	std::vector<float> profile;
+	bool handled = dispatchPixel(image, [&](auto pixel) {
+		profile = lineProfile<decltype(pixel)>(image, points, line_width);
+	});
+	if (!handled) {
+		std::cerr << "Error: Unsupported image depth for profile." << std::endl;
+	}
+	return profile;
+}
+
+std::vector<float> computeMaskProfile(const cv::Mat& image, const RunLengthMask& mask) {
+	if (image.empty() || mask.empty()) {
+		return {};
+	}
+	if (mask.getSize() != image.size()) {
+		std::cerr << "Error: Mask size does not match the image." << std::endl;
+		return {};
+	}
+	std::vector<float> profile;
+	bool handled = dispatchPixel(image, [&](auto pixel) {
+		profile = maskProfile<decltype(pixel)>(image, mask);
+	});
+	if (!handled) {
+		std::cerr << "Error: Unsupported image depth for profile." << std::endl;
+	}
+	return profile;
+}
+
+std::vector<float> computeRectProfile(const cv::Mat& image, const cv::Rect& rect) {
+	const cv::Rect clipped = rect & cv::Rect(0, 0, image.cols, image.rows);
+	if (image.empty() || clipped.empty()) {
+		return {};
+	}
+	std::vector<float> profile;
+	bool handled = dispatchPixel(image, [&](auto pixel) {
+		profile = rectProfile<decltype(pixel)>(image, clipped);
+	});
+	if (!handled) {
+		std::cerr << "Error: Unsupported image depth for profile." << std::endl;
+	}
+	return profile;
+}
@@ -0,0 +1,29 @@
+﻿/// ----------------------- Profile -----------------------
+///
+/// 说明：灰度剖面分析；
+///      1. 折线剖面：沿形状的点以 1 像素间距采样，双线性插值，可设置线宽（沿法线方向取平均），
+///         开销与路径长度 × 线宽成正比；
+///      2. 掩码剖面：按 RunLengthMask 的 run 遍历掩码内像素，开销与掩码面积成正比；
+///      3. 矩形剖面：矩形内每一列的平均值（与 ImageJ 矩形选区的 Plot Profile 相同），开销与矩形面积成正比。
+///      均支持任意位深；多通道图像取各通道平均值。
+///
+/// ----------------------- Profile -----------------------
+
+#pragma once
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "RunLengthMask.h"
+
+// 沿折线 points 采样；line_width > 1 时对法线方向上 round(line_width) 个采样点取平均
+std::vector<float> computeLineProfile(const cv::Mat& image, const std::vector<cv::Point2f>& points, float line_width = 1);
+
+// 掩码内的像素值，按行优先顺序排列
+std::vector<float> computeMaskProfile(const cv::Mat& image, const RunLengthMask& mask);
+
+// rect（裁剪到图像内）每一列的平均值，从左到右排列
+std::vector<float> computeRectProfile(const cv::Mat& image, const cv::Rect& rect);
+
+#endif // PROFILE_H
@@ -0,0 +1,518 @@
+﻿/// ----------------------- RankFilters -----------------------
+///
+/// 说明：最小值 / 最大值 / 中值滤波，见 RankFilters.h。
+///
+/// ----------------------- RankFilters -----------------------
+
+#include "RankFilters.h"
+#include "PixelKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_set>
+
+namespace {
+
+	// 方形核中值在半径达到该值后改用常数时间的 Perreault-Hébert 算法，较小半径时 Huang 算法更快
+	const int kConstantTimeMedianRadius = 8;
+
+	/* ----------------------- 最小值 / 最大值 ----------------------- */
+
+	// 方形核：水平、垂直两遍一维滤波
+	template <typename T, bool IsMax>
+	void separableExtremum(const cv::Mat& src, cv::Mat& dst, int w) {
+		cv::Mat padded;
+		cv::copyMakeBorder(src, padded, w, w, w, w, cv::BORDER_REPLICATE);
+		const int cols = src.cols;
+		const int k = 2 * w + 1;
+
+		// 水平：padded 的每一行 -> horizontal 的同一行
+		cv::Mat horizontal(padded.rows, cols, src.type());
+		cv::parallel_for_(cv::Range(0, padded.rows), [&](const cv::Range& rows) {
+			std::vector<T> g(padded.cols), h(padded.cols);
+			for (int y = rows.start; y < rows.end; ++y) {
+				vhgwLine<T, IsMax>(padded.ptr<T>(y), horizontal.ptr<T>(y), cols, w, g.data(), h.data());
+			}
+		});
+
+		// 垂直：按列条带并行，每个条带内逐行处理以保持连续访问
+		cv::Mat g(horizontal.size(), src.type());
+		cv::Mat h(horizontal.size(), src.type());
+		cv::Mat output(src.size(), src.type());
+		const int length = horizontal.rows;
+		cv::parallel_for_(cv::Range(0, cols), [&](const cv::Range& range) {
+			const int x0 = range.start;
+			const int x1 = range.end;
+			for (int y = 0; y < length; ++y) {
+				const T* in = horizontal.ptr<T>(y);
+				T* gr = g.ptr<T>(y);
+				if (y % k == 0) {
+					std::copy(in + x0, in + x1, gr + x0);
+				}
+				else {
+					const T* prev = g.ptr<T>(y - 1);
+					for (int x = x0; x < x1; ++x) gr[x] = rankPick<T, IsMax>(prev[x], in[x]);
+				}
+			}
+			for (int y = length - 1; y >= 0; --y) {
+				const T* in = horizontal.ptr<T>(y);
+				T* hr = h.ptr<T>(y);
+				if (y == length - 1 || y % k == k - 1) {
+					std::copy(in + x0, in + x1, hr + x0);
+				}
+				else {
+					const T* next = h.ptr<T>(y + 1);
+					for (int x = x0; x < x1; ++x) hr[x] = rankPick<T, IsMax>(next[x], in[x]);
+				}
+			}
+			for (int y = 0; y < src.rows; ++y) {
+				const T* hr = h.ptr<T>(y);
+				const T* gr = g.ptr<T>(y + k - 1);
+				T* out = output.ptr<T>(y);
+				for (int x = x0; x < x1; ++x) out[x] = rankPick<T, IsMax>(hr[x], gr[x]);
+			}
+		}, cv::getNumThreads());
+
+		dst = output;
+	}
+
+	// 任意按行拆分的核（圆形）：每个行偏移做一次一维滤波后合并，每像素开销 O(r)
+	template <typename T, bool IsMax>
+	void lineKernelExtremum(const cv::Mat& src, cv::Mat& dst, const std::vector<int>& lines) {
+		const int r = static_cast<int>(lines.size()) / 2;
+		cv::Mat padded;
+		cv::copyMakeBorder(src, padded, r, r, r, r, cv::BORDER_REPLICATE);
+		const int cols = src.cols;
+
+		cv::Mat output(src.size(), src.type());
+		cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& rows) {
+			std::vector<T> g(padded.cols), h(padded.cols), line(cols);
+			for (int y = rows.start; y < rows.end; ++y) {
+				T* out = output.ptr<T>(y);
+				for (int dy = 0; dy <= 2 * r; ++dy) {
+					const int w = lines[dy];
+					const T* in = padded.ptr<T>(y + dy) + (r - w);
+					vhgwLine<T, IsMax>(in, dy == 0 ? out : line.data(), cols, w, g.data(), h.data());
+					if (dy > 0) {
+						for (int x = 0; x < cols; ++x) out[x] = rankPick<T, IsMax>(out[x], line[x]);
+					}
+				}
+			}
+		});
+
+		dst = output;
+	}
+
+	/* ----------------------- 中值 ----------------------- */
+
+	// 两级直方图：粗直方图定位区段，细直方图在区段内定位键值
+	template <int Bits>
+	struct RankHistogram {
+		static constexpr int kFine = 1 << Bits;
+		static constexpr int kShift = Bits / 2;
+		static constexpr int kCoarse = 1 << (Bits - kShift);
+
+		std::vector<uint32_t> fine;
+		std::vector<uint32_t> coarse;
+
+		RankHistogram() : fine(kFine, 0), coarse(kCoarse, 0) {}
+
+		void clear() {
+			std::fill(fine.begin(), fine.end(), 0);
+			std::fill(coarse.begin(), coarse.end(), 0);
+		}
+		void add(int key) {
+			++fine[key];
+			++coarse[key >> kShift];
+		}
+		void remove(int key) {
+			--fine[key];
+			--coarse[key >> kShift];
+		}
+		// 第 rank 小（从 0 计）的键；within 不为空时返回该元素在同键元素中的名次
+		int select(uint32_t rank, uint32_t* within = nullptr) const {
+			int c = 0;
+			while (rank >= coarse[c]) {
+				rank -= coarse[c++];
+			}
+			int key = c << kShift;
+			while (rank >= fine[key]) {
+				rank -= fine[key++];
+			}
+			if (within) {
+				*within = rank;
+			}
+			return key;
+		}
+	};
+
+	// Huang 滑动窗口：每行开头建立窗口直方图，向右移动时每个行偏移移出一个、移入一个像素
+	template <typename T, int Bits>
+	void lineKernelMedian(const cv::Mat& src, cv::Mat& dst, const std::vector<int>& lines) {
+		const int r = static_cast<int>(lines.size()) / 2;
+		cv::Mat padded;
+		cv::copyMakeBorder(src, padded, r, r, r, r, cv::BORDER_REPLICATE);
+		const int cols = src.cols;
+		const uint32_t rank = static_cast<uint32_t>(std::accumulate(lines.begin(), lines.end(), 0,
+			[](int sum, int w) { return sum + 2 * w + 1; })) / 2;
+
+		cv::Mat output(src.size(), src.type());
+		cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& rows) {
+			RankHistogram<Bits> hist;
+			for (int y = rows.start; y < rows.end; ++y) {
+				hist.clear();
+				for (int dy = 0; dy <= 2 * r; ++dy) {
+					const T* row = padded.ptr<T>(y + dy);
+					for (int x = r - lines[dy]; x <= r + lines[dy]; ++x) hist.add(row[x]);
+				}
+				T* out = output.ptr<T>(y);
+				out[0] = static_cast<T>(hist.select(rank));
+				for (int x = 1; x < cols; ++x) {
+					for (int dy = 0; dy <= 2 * r; ++dy) {
+						const T* row = padded.ptr<T>(y + dy);
+						hist.remove(row[x - 1 + r - lines[dy]]);
+						hist.add(row[x + r + lines[dy]]);
+					}
+					out[x] = static_cast<T>(hist.select(rank));
+				}
+			}
+		});
+
+		dst = output;
+	}
+
+	// Perreault-Hébert：每列维护 2r + 1 行的列直方图，核直方图向右移动时加一列、减一列，与半径无关
+	void squareMedian8U(const cv::Mat& src, cv::Mat& dst, int r) {
+		cv::Mat padded;
+		cv::copyMakeBorder(src, padded, r, r, r, r, cv::BORDER_REPLICATE);
+		const int cols = src.cols;
+		const int padded_cols = padded.cols;
+		const int k = 2 * r + 1;
+		const uint32_t rank = static_cast<uint32_t>(k) * k / 2;
+
+		cv::Mat output(src.size(), CV_8UC1);
+		cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& band) {
+			// 列直方图：细 256 项、粗 16 项
+			std::vector<uint16_t> column_fine(static_cast<size_t>(padded_cols) * 256, 0);
+			std::vector<uint16_t> column_coarse(static_cast<size_t>(padded_cols) * 16, 0);
+			auto updateRow = [&](int py, int delta) {
+				const uchar* row = padded.ptr<uchar>(py);
+				for (int x = 0; x < padded_cols; ++x) {
+					column_fine[x * 256 + row[x]] += delta;
+					column_coarse[x * 16 + (row[x] >> 4)] += delta;
+				}
+			};
+			for (int py = band.start; py < band.start + k; ++py) {
+				updateRow(py, 1);
+			}
+
+			uint32_t fine[256];
+			uint32_t coarse[16];
+			for (int y = band.start; y < band.end; ++y) {
+				if (y > band.start) {
+					updateRow(y - 1, -1);
+					updateRow(y + k - 1, 1);
+				}
+
+				std::fill(fine, fine + 256, 0);
+				std::fill(coarse, coarse + 16, 0);
+				for (int x = 0; x < k; ++x) {
+					for (int i = 0; i < 256; ++i) fine[i] += column_fine[x * 256 + i];
+					for (int i = 0; i < 16; ++i) coarse[i] += column_coarse[x * 16 + i];
+				}
+
+				uchar* out = output.ptr<uchar>(y);
+				for (int x = 0; ; ++x) {
+					uint32_t remaining = rank;
+					int c = 0;
+					while (remaining >= coarse[c]) remaining -= coarse[c++];
+					int v = c << 4;
+					while (remaining >= fine[v]) remaining -= fine[v++];
+					out[x] = static_cast<uchar>(v);
+
+					if (x + 1 == cols) break;
+					const uint16_t* add_fine = &column_fine[(x + k) * 256];
+					const uint16_t* sub_fine = &column_fine[x * 256];
+					for (int i = 0; i < 256; ++i) fine[i] += add_fine[i] - sub_fine[i];
+					const uint16_t* add_coarse = &column_coarse[(x + k) * 16];
+					const uint16_t* sub_coarse = &column_coarse[x * 16];
+					for (int i = 0; i < 16; ++i) coarse[i] += add_coarse[i] - sub_coarse[i];
+				}
+			}
+		}, cv::getNumThreads());
+
+		dst = output;
+	}
+
+	// 浮点取值的全序：NaN 排在所有数值之后且互相相等，含 NaN 的数据也可排序、二分查找与求中值
+	inline bool floatLess(float a, float b) {
+		return !std::isnan(a) && (std::isnan(b) || a < b);
+	}
+
+	// 取值的键：所有 NaN 归为同一个值，-0 与 +0 相同
+	inline uint32_t floatKey(float v) {
+		if (std::isnan(v)) {
+			v = std::numeric_limits<float>::quiet_NaN();
+		}
+		else if (v == 0) {
+			v = 0;
+		}
+		uint32_t bits;
+		std::memcpy(&bits, &v, sizeof(bits));
+		return bits;
+	}
+
+	// 32 位浮点取值过多、无法一一映射为 16 位键时：按取值分为 65536 个桶（边界取自等间隔抽样的分位数），
+	// 滑动窗口直方图在桶上选出中值所在的桶，再在窗口内落入该桶的取值中选出精确中值。
+	// 每个桶另存窗口内的原始取值，随窗口移入移出；桶内数量大致相等，窗口内每个桶通常只有几个像素，
+	// 每像素开销与 Huang 算法相同（与半径线性相关），而不是逐像素收集整个窗口的 O(r^2)
+	void bucketMedian32F(const cv::Mat& src, cv::Mat& dst, const std::vector<int>& lines) {
+		const int r = static_cast<int>(lines.size()) / 2;
+		const int buckets = 65536;
+
+		// 抽样排序得到桶边界，不对全部像素排序
+		const size_t total = src.total();
+		const size_t stride = std::max<size_t>(1, total / (static_cast<size_t>(buckets) * 4));
+		std::vector<float> sample;
+		sample.reserve(total / stride + 1);
+		for (int y = 0; y < src.rows; ++y) {
+			const float* row = src.ptr<float>(y);
+			for (int x = static_cast<int>((static_cast<size_t>(y) * src.cols) % stride); x < src.cols; x += static_cast<int>(stride)) {
+				sample.push_back(row[x]);
+			}
+		}
+		std::sort(sample.begin(), sample.end(), floatLess);
+		std::vector<float> bounds(buckets - 1);
+		for (int i = 1; i < buckets; ++i) {
+			bounds[i - 1] = sample[static_cast<size_t>(i) * sample.size() / buckets];
+		}
+
+		// NaN 统一为同一位模式，移出窗口时按位查找
+		cv::Mat padded;
+		cv::copyMakeBorder(src, padded, r, r, r, r, cv::BORDER_REPLICATE);
+		cv::Mat keys(padded.size(), CV_16UC1);
+		forEachRow(padded.rows, [&](int y) {
+			float* in = padded.ptr<float>(y);
+			ushort* out = keys.ptr<ushort>(y);
+			for (int x = 0; x < padded.cols; ++x) {
+				if (std::isnan(in[x])) {
+					in[x] = std::numeric_limits<float>::quiet_NaN();
+				}
+				out[x] = static_cast<ushort>(std::upper_bound(bounds.begin(), bounds.end(), in[x], floatLess) - bounds.begin());
+			}
+		});
+
+		const int cols = src.cols;
+		const uint32_t rank = static_cast<uint32_t>(std::accumulate(lines.begin(), lines.end(), 0,
+			[](int sum, int w) { return sum + 2 * w + 1; })) / 2;
+
+		cv::Mat output(src.size(), CV_32FC1);
+		cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& rows) {
+			RankHistogram<16> hist;
+			std::vector<std::vector<float>> members(buckets);
+			auto add = [&](int key, float v) {
+				hist.add(key);
+				members[key].push_back(v);
+			};
+			auto remove = [&](int key, float v) {
+				hist.remove(key);
+				// 按位比较，NaN 也能找到
+				std::vector<float>& m = members[key];
+				*std::find_if(m.begin(), m.end(), [&](float u) { return std::memcmp(&u, &v, sizeof(float)) == 0; }) = m.back();
+				m.pop_back();
+			};
+			auto median = [&]() {
+				uint32_t within = 0;
+				std::vector<float>& m = members[hist.select(rank, &within)];
+				std::nth_element(m.begin(), m.begin() + within, m.end(), floatLess);
+				return m[within];
+			};
+
+			for (int y = rows.start; y < rows.end; ++y) {
+				hist.clear();
+				for (std::vector<float>& m : members) m.clear();
+				for (int dy = 0; dy <= 2 * r; ++dy) {
+					const float* row = padded.ptr<float>(y + dy);
+					const ushort* key = keys.ptr<ushort>(y + dy);
+					for (int x = r - lines[dy]; x <= r + lines[dy]; ++x) add(key[x], row[x]);
+				}
+				float* out = output.ptr<float>(y);
+				out[0] = median();
+				for (int x = 1; x < cols; ++x) {
+					for (int dy = 0; dy <= 2 * r; ++dy) {
+						const float* row = padded.ptr<float>(y + dy);
+						const ushort* key = keys.ptr<ushort>(y + dy);
+						const int left = x - 1 + r - lines[dy];
+						const int right = x + r + lines[dy];
+						remove(key[left], row[left]);
+						add(key[right], row[right]);
+					}
+					out[x] = median();
+				}
+			}
+		});
+
+		dst = output;
+	}
+
+	// 32 位浮点：不同取值不超过 65536 个时映射为 16 位排序键，在键上求中值后映射回原值；
+	// 统计不同取值时超过 65536 个即停止（实际的浮点数据通常如此），改用分桶方法
+	void median32F(const cv::Mat& src, cv::Mat& dst, const std::vector<int>& lines) {
+		std::unordered_set<uint32_t> distinct;
+		for (int y = 0; y < src.rows; ++y) {
+			const float* row = src.ptr<float>(y);
+			for (int x = 0; x < src.cols; ++x) {
+				distinct.insert(floatKey(row[x]));
+			}
+			if (distinct.size() > 65536) {
+				bucketMedian32F(src, dst, lines);
+				return;
+			}
+		}
+		std::vector<float> values;
+		values.reserve(distinct.size());
+		for (uint32_t bits : distinct) {
+			float v;
+			std::memcpy(&v, &bits, sizeof(v));
+			values.push_back(v);
+		}
+		std::sort(values.begin(), values.end(), floatLess);
+
+		cv::Mat keys(src.size(), CV_16UC1);
+		forEachRow(src.rows, [&](int y) {
+			const float* in = src.ptr<float>(y);
+			ushort* out = keys.ptr<ushort>(y);
+			for (int x = 0; x < src.cols; ++x) {
+				out[x] = static_cast<ushort>(std::lower_bound(values.begin(), values.end(), in[x], floatLess) - values.begin());
+			}
+		});
+
+		cv::Mat filtered;
+		lineKernelMedian<ushort, 16>(keys, filtered, lines);
+
+		cv::Mat output(src.size(), CV_32FC1);
+		forEachRow(src.rows, [&](int y) {
+			const ushort* in = filtered.ptr<ushort>(y);
+			float* out = output.ptr<float>(y);
+			for (int x = 0; x < src.cols; ++x) {
+				out[x] = values[in[x]];
+			}
+		});
+		dst = output;
+	}
+
+	/* ----------------------- 分派 ----------------------- */
+
+	enum RankType {
+		kRankMin,
+		kRankMax,
+		kRankMedian
+	};
+
+	void filterChannel(const cv::Mat& src, cv::Mat& dst, RankType type, float radius, bool circular) {
+		const std::vector<int> lines = rankKernelLines(radius, circular);
+		const int r = static_cast<int>(lines.size()) / 2;
+
+		if (type == kRankMedian) {
+			if (src.depth() == CV_8U) {
+				if (!circular && r >= kConstantTimeMedianRadius) {
+					squareMedian8U(src, dst, r);
+				}
+				else {
+					lineKernelMedian<uchar, 8>(src, dst, lines);
+				}
+			}
+			else if (src.depth() == CV_16U) {
+				lineKernelMedian<ushort, 16>(src, dst, lines);
+			}
+			else {
+				median32F(src, dst, lines);
+			}
+			return;
+		}
+
+		dispatchDepth(src.depth(), [&](auto depth) {
+			using T = typename decltype(depth)::type;
+			if (type == kRankMax) {
+				circular ? lineKernelExtremum<T, true>(src, dst, lines) : separableExtremum<T, true>(src, dst, r);
+			}
+			else {
+				circular ? lineKernelExtremum<T, false>(src, dst, lines) : separableExtremum<T, false>(src, dst, r);
+			}
+		});
+	}
+
+	void rankFilter(const cv::Mat& src, cv::Mat& dst, RankType type, float radius, bool circular) {
+		if (src.empty()) {
+			std::cerr << "Error: Image is empty." << std::endl;
+			return;
+		}
+		if (rankKernelLines(radius, circular).size() == 1) {
+			if (&dst != &src) src.copyTo(dst);
+			return;
+		}
+
+		// 内核支持 8U / 16U / 32F，其余位深经 32F 处理后转换回原位深
+		const int depth = src.depth();
+		cv::Mat input = src;
+		if (depth != CV_8U && depth != CV_16U && depth != CV_32F) {
+			src.convertTo(input, CV_32F);
+		}
+
+		cv::Mat output;
+		if (input.channels() == 1) {
+			filterChannel(input, output, type, radius, circular);
+		}
+		else {
+			std::vector<cv::Mat> planes;
+			cv::split(input, planes);
+			for (cv::Mat& plane : planes) {
+				filterChannel(plane, plane, type, radius, circular);
+			}
+			cv::merge(planes, output);
+		}
+
+		if (output.depth() != depth) {
+			output.convertTo(output, depth);
+		}
+		dst = output;
+	}
+
+}
+
+
+std::vector<int> rankKernelLines(float radius, bool circular) {
+	if (!circular) {
+		int r = std::max(0, static_cast<int>(radius));
+		return std::vector<int>(2 * r + 1, r);
+	}
+
+	// 与 ImageJ RankFilters.makeLineRadii 一致，小半径时略微放大以得到更圆的核
+	double rr = std::max(0.f, radius);
+	if (rr >= 1.5 && rr < 1.75) rr = 1.75;
+	else if (rr >= 2.5 && rr < 2.85) rr = 2.85;
+	int r2 = static_cast<int>(rr * rr) + 1;
+	int r = static_cast<int>(std::sqrt(r2 + 1e-10));
+
+	std::vector<int> lines(2 * r + 1);
+	for (int dy = -r; dy <= r; ++dy) {
+		lines[dy + r] = static_cast<int>(std::sqrt(r2 - dy * dy + 1e-10));
+	}
+	return lines;
+}
+
+void rankMinimum(const cv::Mat& src, cv::Mat& dst, float radius, bool circular) {
+	rankFilter(src, dst, kRankMin, radius, circular);
+}
+
+void rankMaximum(const cv::Mat& src, cv::Mat& dst, float radius, bool circular) {
+	rankFilter(src, dst, kRankMax, radius, circular);
+}
+
+void rankMedian(const cv::Mat& src, cv::Mat& dst, float radius, bool circular) {
+	rankFilter(src, dst, kRankMedian, radius, circular);
+}
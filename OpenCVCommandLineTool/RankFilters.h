@@ -0,0 +1,60 @@
+﻿/// ----------------------- RankFilters -----------------------
+///
+/// 说明：大半径下每像素开销与半径无关（或仅线性相关）的排序滤波；
+///      1. 最小值 / 最大值：van Herk/Gil-Werman 算法，每像素约 3 次比较；
+///         方形核可分离为水平与垂直两遍，圆形核按行拆分为线段逐行合并；
+///      2. 中值：8 位方形核使用 Perreault-Hébert 列直方图算法（每像素开销为常数），
+///         其余情况使用 Huang 滑动窗口直方图（两级直方图，16 位也可快速查找中值）；
+///         32 位浮点图像先映射为 16 位的排序键；不同取值超过 65536 个时按取值分为 65536 个桶，
+///         在桶上选出中值所在的桶后，再在窗口内该桶的取值中取精确中值；NaN 按大于所有数值排序。
+///      圆形核与 ImageJ 的 RankFilters 一致，支持小数半径；方形核边长为 2 * floor(radius) + 1。
+///      边界按边缘像素复制处理；多通道图像逐通道滤波；按行分块并行。
+///
+/// ----------------------- RankFilters -----------------------
+
+#pragma once
+#ifndef RANK_FILTERS_H
+#define RANK_FILTERS_H
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <vector>
+
+// 核在每个行偏移 dy = -r..r 上的半宽，共 2r + 1 项
+std::vector<int> rankKernelLines(float radius, bool circular);
+
+void rankMinimum(const cv::Mat& src, cv::Mat& dst, float radius, bool circular = false);
+void rankMaximum(const cv::Mat& src, cv::Mat& dst, float radius, bool circular = false);
+void rankMedian(const cv::Mat& src, cv::Mat& dst, float radius, bool circular = false);
+
+// 一维极值内核，Morphology 的对角线方向分解也使用
+template <typename T, bool IsMax>
+inline T rankPick(T a, T b) {
+	return IsMax ? std::max(a, b) : std::min(a, b);
+}
+
+// van Herk/Gil-Werman：in 长度为 n + 2w，out[i] 为 in[i .. i + 2w] 的极值；g、h 为长度 n + 2w 的缓冲区
+template <typename T, bool IsMax>
+inline void vhgwLine(const T* in, T* out, int n, int w, T* g, T* h) {
+	if (w == 0) {
+		std::copy(in, in + n, out);
+		return;
+	}
+	const int k = 2 * w + 1;
+	const int length = n + 2 * w;
+
+	// g：块内从左到右的前缀极值；h：块内从右到左的后缀极值
+	for (int i = 0, j = 0; i < length; ++i, j = (j + 1 == k) ? 0 : j + 1) {
+		g[i] = (j == 0) ? in[i] : rankPick<T, IsMax>(g[i - 1], in[i]);
+	}
+	h[length - 1] = in[length - 1];
+	for (int i = length - 2; i >= 0; --i) {
+		h[i] = (i % k == k - 1) ? in[i] : rankPick<T, IsMax>(h[i + 1], in[i]);
+	}
+	// 窗口 [i, i + k - 1] 恰好跨过一个块边界
+	for (int i = 0; i < n; ++i) {
+		out[i] = rankPick<T, IsMax>(h[i], g[i + k - 1]);
+	}
+}
+
+#endif // RANK_FILTERS_H
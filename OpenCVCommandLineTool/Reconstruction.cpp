@@ -0,0 +1,219 @@
+﻿/// ----------------------- Reconstruction -----------------------
+///
+/// 说明：混合扫描 + FIFO 的形态学重建，见 Reconstruction.h。
+///
+/// ----------------------- Reconstruction -----------------------
+
+#include "Reconstruction.h"
+#include "PixelKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <vector>
+
+namespace {
+
+	// 邻点偏移（带 1 像素边框的连续缓冲区）：前 half 个在光栅顺序中位于当前像素之前
+	std::vector<int> neighbourOffsets(int step, bool eight_connected) {
+		if (eight_connected) {
+			return { -1, -step - 1, -step, -step + 1, 1, step + 1, step, step - 1 };
+		}
+		return { -1, -step, 1, step };
+	}
+
+	// 边框取类型的最小值：不会抬升任何邻点，且 marker == mask，不会被传播改写
+	template <typename T>
+	cv::Mat padded(const cv::Mat& src) {
+		cv::Mat out;
+		cv::copyMakeBorder(src, out, 1, 1, 1, 1, cv::BORDER_CONSTANT, cv::Scalar(std::numeric_limits<T>::lowest()));
+		return out;
+	}
+
+	template <typename T>
+	void reconstructPadded(cv::Mat& marker, const cv::Mat& mask, bool eight_connected) {
+		const int step = static_cast<int>(marker.step1());
+		const std::vector<int> offsets = neighbourOffsets(step, eight_connected);
+		const size_t half = offsets.size() / 2;
+		T* j = marker.ptr<T>();
+		const T* m = mask.ptr<T>();
+
+		// 正向扫描：上方与左侧邻点
+		for (int y = 1; y < marker.rows - 1; ++y) {
+			for (int x = 1; x < marker.cols - 1; ++x) {
+				const int i = y * step + x;
+				T v = j[i];
+				for (size_t k = 0; k < half; ++k) {
+					v = std::max(v, j[i + offsets[k]]);
+				}
+				j[i] = std::min(v, m[i]);
+			}
+		}
+
+		// 反向扫描：下方与右侧邻点；仍能抬升下方邻点的像素进入队列
+		std::queue<int> fifo;
+		for (int y = marker.rows - 2; y >= 1; --y) {
+			for (int x = marker.cols - 2; x >= 1; --x) {
+				const int i = y * step + x;
+				T v = j[i];
+				for (size_t k = half; k < offsets.size(); ++k) {
+					v = std::max(v, j[i + offsets[k]]);
+				}
+				j[i] = std::min(v, m[i]);
+				for (size_t k = half; k < offsets.size(); ++k) {
+					const int q = i + offsets[k];
+					if (j[q] < j[i] && j[q] < m[q]) {
+						fifo.push(i);
+						break;
+					}
+				}
+			}
+		}
+
+		// 队列传播
+		while (!fifo.empty()) {
+			const int p = fifo.front();
+			fifo.pop();
+			for (int offset : offsets) {
+				const int q = p + offset;
+				if (j[q] < j[p] && m[q] != j[q]) {
+					j[q] = std::min(j[p], m[q]);
+					fifo.push(q);
+				}
+			}
+		}
+	}
+
+	template <typename T>
+	void regionalMaximaPadded(const cv::Mat& src, cv::Mat& dst, bool eight_connected) {
+		const int step = static_cast<int>(src.step1());
+		const std::vector<int> offsets = neighbourOffsets(step, eight_connected);
+		const T* v = src.ptr<T>();
+
+		// 有更高邻点的像素不是极大值；边框预先标记，不参与传播
+		cv::Mat lower(src.size(), CV_8UC1, cv::Scalar(1));
+		uchar* flag = lower.ptr<uchar>();   // 两个缓冲区都是连续的，按元素的步长相同
+		cv::parallel_for_(cv::Range(1, src.rows - 1), [&](const cv::Range& range) {
+			for (int y = range.start; y < range.end; ++y) {
+				for (int x = 1; x < src.cols - 1; ++x) {
+					const int i = y * step + x;
+					uchar higher = 0;
+					for (int offset : offsets) {
+						if (v[i + offset] > v[i]) {
+							higher = 1;
+							break;
+						}
+					}
+					flag[i] = higher;
+				}
+			}
+		});
+
+		// 非极大值沿等值邻点扩散到整个平台
+		std::queue<int> fifo;
+		for (int y = 1; y < src.rows - 1; ++y) {
+			for (int x = 1; x < src.cols - 1; ++x) {
+				if (flag[y * step + x]) fifo.push(y * step + x);
+			}
+		}
+		while (!fifo.empty()) {
+			const int p = fifo.front();
+			fifo.pop();
+			for (int offset : offsets) {
+				const int q = p + offset;
+				if (!flag[q] && v[q] == v[p]) {
+					flag[q] = 1;
+					fifo.push(q);
+				}
+			}
+		}
+
+		cv::compare(lower(cv::Rect(1, 1, src.cols - 2, src.rows - 2)), 0, dst, cv::CMP_EQ);
+	}
+
+	// 只保留图像边界上的像素
+	cv::Mat borderMarker(const cv::Mat& src) {
+		cv::Mat marker = cv::Mat::zeros(src.size(), src.type());
+		src.row(0).copyTo(marker.row(0));
+		src.row(src.rows - 1).copyTo(marker.row(src.rows - 1));
+		src.col(0).copyTo(marker.col(0));
+		src.col(src.cols - 1).copyTo(marker.col(src.cols - 1));
+		return marker;
+	}
+
+	bool isSupported(const cv::Mat& src) {
+		return src.channels() == 1 && (src.depth() == CV_8U || src.depth() == CV_16U || src.depth() == CV_32F);
+	}
+
+}
+
+
+void reconstructByDilation(const cv::Mat& marker, const cv::Mat& mask, cv::Mat& dst, bool eight_connected) {
+	CV_Assert(marker.size() == mask.size() && marker.type() == mask.type() && isSupported(mask));
+	if (mask.empty()) {
+		dst = cv::Mat();
+		return;
+	}
+	dispatchDepth(mask.depth(), [&](auto depth) {
+		using T = typename decltype(depth)::type;
+		cv::Mat bounded;
+		cv::min(marker, mask, bounded);
+		cv::Mat j = padded<T>(bounded);
+		const cv::Mat m = padded<T>(mask);
+		reconstructPadded<T>(j, m, eight_connected);
+		j(cv::Rect(1, 1, mask.cols, mask.rows)).copyTo(dst);
+	});
+}
+
+void fillHolesMask(const cv::Mat& src, cv::Mat& dst) {
+	CV_Assert(src.type() == CV_8UC1);
+	if (src.empty()) {
+		dst = cv::Mat();
+		return;
+	}
+	// 背景按 4 连通从边界重建，未到达的背景是被前景包围的孔洞
+	cv::Mat background, reached;
+	cv::compare(src, 0, background, cv::CMP_EQ);
+	reconstructByDilation(borderMarker(background), background, reached, false);
+	cv::compare(reached, 0, dst, cv::CMP_EQ);
+}
+
+void clearBorderMask(const cv::Mat& src, cv::Mat& dst) {
+	CV_Assert(src.type() == CV_8UC1);
+	if (src.empty()) {
+		dst = cv::Mat();
+		return;
+	}
+	cv::Mat foreground, touching;
+	cv::compare(src, 0, foreground, cv::CMP_NE);
+	reconstructByDilation(borderMarker(foreground), foreground, touching, true);
+	cv::subtract(foreground, touching, dst);
+}
+
+void regionalMaxima(const cv::Mat& src, cv::Mat& dst, bool eight_connected) {
+	CV_Assert(isSupported(src));
+	if (src.empty()) {
+		dst = cv::Mat();
+		return;
+	}
+	dispatchDepth(src.depth(), [&](auto depth) {
+		using T = typename decltype(depth)::type;
+		regionalMaximaPadded<T>(padded<T>(src), dst, eight_connected);
+	});
+}
+
+void hMaxima(const cv::Mat& src, double h, cv::Mat& dst, bool eight_connected) {
+	CV_Assert(isSupported(src));
+	// 整数图像减去非整数 h 会被取整，此时改在 32F 上计算
+	if (src.depth() != CV_32F && h != std::floor(h)) {
+		cv::Mat values;
+		src.convertTo(values, CV_32F);
+		hMaxima(values, h, dst, eight_connected);
+		return;
+	}
+	cv::Mat lowered, reconstructed;
+	cv::subtract(src, cv::Scalar(h), lowered);
+	reconstructByDilation(lowered, src, reconstructed, eight_connected);
+	regionalMaxima(reconstructed, dst, eight_connected);
+}
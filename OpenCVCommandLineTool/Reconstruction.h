@@ -0,0 +1,38 @@
+﻿/// ----------------------- Reconstruction -----------------------
+///
+/// 说明：形态学重建（按膨胀重建）及以它为基础的二值 / 灰度操作；
+///
+///      重建：marker 在 mask 之下反复做测地膨胀直到稳定。采用 Vincent 的混合算法：
+///        1. 正向光栅扫描，用已扫描的上方与左侧邻点抬升 marker（不超过 mask）；
+///        2. 反向光栅扫描，同理使用下方与右侧邻点，并把仍能抬升下方邻点的像素放入 FIFO 队列；
+///        3. 从队列出发向外传播，直到队列为空。
+///      两次扫描已完成绝大部分传播，队列只处理蜿蜒结构，总开销近似线性，与迭代次数无关。
+///      二值图像按 0 / 255 的灰度图处理，使用同一实现。
+///
+///      - fillHolesMask：  从图像边界的背景重建，未被到达的背景即为孔洞
+///      - clearBorderMask：从图像边界的前景重建，去掉与边界相连的物体
+///      - regionalMaxima： 区域极大值（没有更高邻点的等值平台），队列传播，对浮点图像也是精确的
+///      - hMaxima：        深度不小于 h 的极大值，regionalMaxima(重建(f - h, f))；整数图像的 h 非整数时在 32F 上计算
+///
+///      支持 CV_8UC1 / CV_16UC1 / CV_32FC1。
+///
+/// ----------------------- Reconstruction -----------------------
+
+#pragma once
+#ifndef RECONSTRUCTION_H
+#define RECONSTRUCTION_H
+
+#include <opencv2/opencv.hpp>
+
+// 按膨胀重建 marker（先截断到 mask 之下）；marker 与 mask 的尺寸和类型须相同
+void reconstructByDilation(const cv::Mat& marker, const cv::Mat& mask, cv::Mat& dst, bool eight_connected = true);
+
+// 以下 src 非零为前景（CV_8UC1），结果为 0 / 255；前景按 8 连通，背景按 4 连通
+void fillHolesMask(const cv::Mat& src, cv::Mat& dst);
+void clearBorderMask(const cv::Mat& src, cv::Mat& dst);
+
+// 结果为 CV_8UC1 掩码，极大值平台为 255
+void regionalMaxima(const cv::Mat& src, cv::Mat& dst, bool eight_connected = true);
+void hMaxima(const cv::Mat& src, double h, cv::Mat& dst, bool eight_connected = true);
+
+#endif // RECONSTRUCTION_H
@@ -0,0 +1,208 @@
+﻿/// ----------------------- RecursiveGaussian -----------------------
+///
+/// 说明：Young-van Vliet 递归高斯滤波与融合的反锐化掩模，见 RecursiveGaussian.h。
+///
+/// ----------------------- RecursiveGaussian -----------------------
+
+#include "RecursiveGaussian.h"
+#include "PixelKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+	// 小于该 sigma 时使用 cv::GaussianBlur
+	const double kRecursiveMinSigma = 2.0;
+
+	/* w[n] = B * x[n] + a1 * w[n-1] + a2 * w[n-2] + a3 * w[n-3] */
+	struct Coefficients {
+		float B;
+		float a1;
+		float a2;
+		float a3;
+	};
+
+	// Young & van Vliet (1995)
+	Coefficients computeCoefficients(double sigma) {
+		double q = (sigma >= 2.5)
+			? 0.98711 * sigma - 0.96330
+			: 3.97156 - 4.14554 * std::sqrt(1 - 0.26891 * sigma);
+		double b0 = 1.57825 + 2.44413 * q + 1.4281 * q * q + 0.422205 * q * q * q;
+		double b1 = 2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q;
+		double b2 = -(1.4281 * q * q + 1.26661 * q * q * q);
+		double b3 = 0.422205 * q * q * q;
+
+		Coefficients c;
+		c.a1 = static_cast<float>(b1 / b0);
+		c.a2 = static_cast<float>(b2 / b0);
+		c.a3 = static_cast<float>(b3 / b0);
+		c.B = 1.f - (c.a1 + c.a2 + c.a3);
+		return c;
+	}
+
+	// 水平方向：每行每通道独立递推，结果写入 CV_32F 缓冲区
+	template <typename T>
+	void horizontalPass(const cv::Mat& src, cv::Mat& buffer, const Coefficients& c) {
+		const int cols = src.cols;
+		const int cn = src.channels();
+		cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& rows) {
+			for (int y = rows.start; y < rows.end; ++y) {
+				const T* in = src.ptr<T>(y);
+				float* out = buffer.ptr<float>(y);
+				for (int ch = 0; ch < cn; ++ch) {
+					// 正向，初值为左边缘的稳态值
+					float w1, w2, w3;
+					w1 = w2 = w3 = static_cast<float>(in[ch]);
+					for (int x = 0, i = ch; x < cols; ++x, i += cn) {
+						float w = c.B * static_cast<float>(in[i]) + c.a1 * w1 + c.a2 * w2 + c.a3 * w3;
+						w3 = w2; w2 = w1; w1 = w;
+						out[i] = w;
+					}
+					// 反向，初值为右边缘的稳态值
+					w1 = w2 = w3 = out[(cols - 1) * cn + ch];
+					for (int x = cols - 1, i = (cols - 1) * cn + ch; x >= 0; --x, i -= cn) {
+						float w = c.B * out[i] + c.a1 * w1 + c.a2 * w2 + c.a3 * w3;
+						w3 = w2; w2 = w1; w1 = w;
+						out[i] = w;
+					}
+				}
+			}
+		});
+	}
+
+	// 垂直方向：按列条带并行，同时递推条带内所有列；反向递推得到第 y 行的结果后立即调用 emit(y, x0, x1, row)
+	template <typename Emit>
+	void verticalPass(cv::Mat& buffer, const Coefficients& c, const Emit& emit) {
+		const int rows = buffer.rows;
+		const int length = buffer.cols * buffer.channels();
+		cv::parallel_for_(cv::Range(0, length), [&](const cv::Range& range) {
+			const int x0 = range.start;
+			const int x1 = range.end;
+			const int width = x1 - x0;
+			std::vector<float> w1(width), w2(width), w3(width);
+
+			// 正向
+			const float* first = buffer.ptr<float>(0) + x0;
+			std::copy(first, first + width, w1.begin());
+			std::copy(first, first + width, w2.begin());
+			std::copy(first, first + width, w3.begin());
+			for (int y = 0; y < rows; ++y) {
+				float* r = buffer.ptr<float>(y) + x0;
+				for (int i = 0; i < width; ++i) {
+					float w = c.B * r[i] + c.a1 * w1[i] + c.a2 * w2[i] + c.a3 * w3[i];
+					w3[i] = w2[i]; w2[i] = w1[i]; w1[i] = w;
+					r[i] = w;
+				}
+			}
+
+			// 反向
+			const float* last = buffer.ptr<float>(rows - 1) + x0;
+			std::copy(last, last + width, w1.begin());
+			std::copy(last, last + width, w2.begin());
+			std::copy(last, last + width, w3.begin());
+			for (int y = rows - 1; y >= 0; --y) {
+				float* r = buffer.ptr<float>(y) + x0;
+				for (int i = 0; i < width; ++i) {
+					float w = c.B * r[i] + c.a1 * w1[i] + c.a2 * w2[i] + c.a3 * w3[i];
+					w3[i] = w2[i]; w2[i] = w1[i]; w1[i] = w;
+					r[i] = w;
+				}
+				emit(y, x0, x1, r - x0);
+			}
+		}, cv::getNumThreads());
+	}
+
+	// 内核支持 8U / 16U / 32F，其余位深先转换为 32F
+	cv::Mat recursiveInput(const cv::Mat& src) {
+		int depth = src.depth();
+		if (depth == CV_8U || depth == CV_16U || depth == CV_32F) {
+			return src;
+		}
+		cv::Mat converted;
+		src.convertTo(converted, CV_32F);
+		return converted;
+	}
+
+	// 对 input 做两个方向的递推；emit 在每行结果就绪时写出
+	// 缓冲区为整幅图像：垂直反向递推从最后一行开始，需要保留所有行的正向结果
+	template <typename EmitFactory>
+	void runRecursive(const cv::Mat& input, double sigma, const EmitFactory& make_emit) {
+		const Coefficients c = computeCoefficients(sigma);
+		cv::Mat buffer(input.size(), CV_32FC(input.channels()));
+		dispatchDepth(input.depth(), [&](auto depth) {
+			using T = typename decltype(depth)::type;
+			horizontalPass<T>(input, buffer, c);
+			verticalPass(buffer, c, make_emit(depth));
+		});
+	}
+
+}
+
+
+void recursiveGaussian(const cv::Mat& src, cv::Mat& dst, double sigma) {
+	if (src.empty()) {
+		std::cerr << "Error: Image is empty." << std::endl;
+		return;
+	}
+	if (sigma < kRecursiveMinSigma) {
+		cv::GaussianBlur(src, dst, cv::Size(0, 0), sigma);
+		return;
+	}
+
+	const int depth = src.depth();
+	const cv::Mat input = recursiveInput(src);
+	cv::Mat output(input.size(), input.type());
+
+	runRecursive(input, sigma, [&](auto tag) {
+		using T = typename decltype(tag)::type;
+		return [&](int y, int x0, int x1, const float* blurred) {
+			T* out = output.ptr<T>(y);
+			for (int i = x0; i < x1; ++i) {
+				out[i] = cv::saturate_cast<T>(blurred[i]);
+			}
+		};
+	});
+
+	if (output.depth() != depth) {
+		output.convertTo(output, depth);
+	}
+	dst = output;
+}
+
+void recursiveUnsharpMask(const cv::Mat& src, cv::Mat& dst, double sigma, double weight) {
+	if (src.empty()) {
+		std::cerr << "Error: Image is empty." << std::endl;
+		return;
+	}
+	if (sigma < kRecursiveMinSigma) {
+		cv::Mat blurred;
+		cv::GaussianBlur(src, blurred, cv::Size(0, 0), sigma);
+		cv::addWeighted(src, 1.0 + weight, blurred, -weight, 0, dst);
+		return;
+	}
+
+	const int depth = src.depth();
+	const cv::Mat input = recursiveInput(src);
+	cv::Mat output(input.size(), input.type());
+	const float keep = static_cast<float>(1.0 + weight);
+	const float subtract = static_cast<float>(weight);
+
+	// 模糊结果只存在于 CV_32F 中间缓冲区中，与原始像素加权后直接写出
+	runRecursive(input, sigma, [&](auto tag) {
+		using T = typename decltype(tag)::type;
+		return [&](int y, int x0, int x1, const float* blurred) {
+			const T* in = input.ptr<T>(y);
+			T* out = output.ptr<T>(y);
+			for (int i = x0; i < x1; ++i) {
+				out[i] = cv::saturate_cast<T>(keep * static_cast<float>(in[i]) - subtract * blurred[i]);
+			}
+		};
+	});
+
+	if (output.depth() != depth) {
+		output.convertTo(output, depth);
+	}
+	dst = output;
+}
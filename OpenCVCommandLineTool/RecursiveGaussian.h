@@ -0,0 +1,29 @@
+﻿/// ----------------------- RecursiveGaussian -----------------------
+///
+/// 说明：Young-van Vliet 递归（IIR）高斯滤波；
+///      每个方向先正向、再反向各做一次三阶递推，每像素开销与 sigma 无关。
+///      水平方向每行独立递推，行间并行；垂直方向按列条带并行，
+///      内层循环沿行连续访问，同时处理一整段列，可被编译器向量化。
+///      边界按边缘像素延拓（递推初值取稳态值）。
+///      sigma 较小时递推近似误差较大，改用 cv::GaussianBlur（此时核本身很小）。
+///
+///      两个方向共用一块与图像同尺寸的 CV_32F 中间缓冲区（原地递推）：
+///      垂直反向递推需要整列的正向结果，无法按行带流式处理。
+///      反锐化掩模在垂直方向的反向递推中直接计算 (1 + w) * x - w * blur 并写出，
+///      不再另外生成一幅输出位深的模糊图像，也不需要额外的 addWeighted 遍历。
+///
+/// ----------------------- RecursiveGaussian -----------------------
+
+#pragma once
+#ifndef RECURSIVE_GAUSSIAN_H
+#define RECURSIVE_GAUSSIAN_H
+
+#include <opencv2/opencv.hpp>
+
+// 输出位深、通道数与输入相同
+void recursiveGaussian(const cv::Mat& src, cv::Mat& dst, double sigma);
+
+// dst = (1 + weight) * src - weight * gaussian(src, sigma)
+void recursiveUnsharpMask(const cv::Mat& src, cv::Mat& dst, double sigma, double weight);
+
+#endif // RECURSIVE_GAUSSIAN_H
@@ -0,0 +1,79 @@
+﻿/// ----------------------- RunLengthMask -----------------------
+///
+/// 说明：掩码的行程编码（RLE）索引，见 RunLengthMask.h。
+///
+/// ----------------------- RunLengthMask -----------------------
+
+#include "RunLengthMask.h"
+
+RunLengthMask RunLengthMask::fromMat(const cv::Mat& mask, cv::Point offset, cv::Size image_size) {
+	RunLengthMask result;
+	result.size = image_size.empty() ? mask.size() : image_size;
+	if (mask.empty()) {
+		return result;
+	}
+	CV_Assert(mask.type() == CV_8UC1);
+
+	// 裁剪到图像范围内
+	cv::Rect placed(offset, mask.size());
+	cv::Rect visible = placed & cv::Rect(0, 0, result.size.width, result.size.height);
+	if (visible.empty()) {
+		return result;
+	}
+	cv::Mat clipped = mask(cv::Rect(visible.tl() - offset, visible.size()));
+
+	// 各行独立编码，并行后按行顺序拼接
+	std::vector<std::vector<MaskRun>> row_runs(clipped.rows);
+	cv::parallel_for_(cv::Range(0, clipped.rows), [&](const cv::Range& rows) {
+		for (int y = rows.start; y < rows.end; ++y) {
+			const uchar* m = clipped.ptr<uchar>(y);
+			std::vector<MaskRun>& out = row_runs[y];
+			int x = 0;
+			while (x < clipped.cols) {
+				while (x < clipped.cols && !m[x]) ++x;
+				if (x >= clipped.cols) break;
+				int begin = x;
+				while (x < clipped.cols && m[x]) ++x;
+				out.push_back({ y + visible.y, begin + visible.x, x + visible.x });
+			}
+		}
+	});
+
+	size_t total_runs = 0;
+	for (const auto& r : row_runs) {
+		total_runs += r.size();
+	}
+	result.runs.reserve(total_runs);
+	for (const auto& r : row_runs) {
+		for (const MaskRun& run : r) {
+			result.runs.push_back(run);
+			result.pixel_count += run.x_end - run.x_begin;
+		}
+	}
+	return result;
+}
+
+const std::vector<MaskRun>& RunLengthMask::getRuns() const {
+	return runs;
+}
+
+cv::Size RunLengthMask::getSize() const {
+	return size;
+}
+
+size_t RunLengthMask::area() const {
+	return pixel_count;
+}
+
+bool RunLengthMask::empty() const {
+	return runs.empty();
+}
+
+cv::Mat RunLengthMask::toMat() const {
+	cv::Mat mask = cv::Mat::zeros(size, CV_8UC1);
+	for (const MaskRun& run : runs) {
+		uchar* m = mask.ptr<uchar>(run.y);
+		std::fill(m + run.x_begin, m + run.x_end, static_cast<uchar>(255));
+	}
+	return mask;
+}
@@ -0,0 +1,44 @@
+﻿/// ----------------------- RunLengthMask -----------------------
+///
+/// 说明：掩码的行程编码（RLE）索引；
+///      每个 run 记录一行中连续非零像素的区间 [x_begin, x_end)。
+///      索引只需在掩码变化时构建一次，之后按 run 遍历掩码像素，
+///      开销与掩码面积成正比，而不是与整幅图像面积成正比。
+///
+/// ----------------------- RunLengthMask -----------------------
+
+#pragma once
+#ifndef RUN_LENGTH_MASK_H
+#define RUN_LENGTH_MASK_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+struct MaskRun {
+	int y;          // 所在行（图像坐标）
+	int x_begin;    // 起始列（含）
+	int x_end;      // 结束列（不含）
+};
+
+class RunLengthMask {
+private:
+	cv::Size size;                 // 对应图像的尺寸
+	std::vector<MaskRun> runs;     // 按行、列有序
+	size_t pixel_count = 0;        // 掩码内像素总数
+
+public:
+	RunLengthMask() = default;
+
+	// 从 CV_8UC1 掩码构建索引；offset 为掩码左上角在图像中的位置，image_size 为图像尺寸（为空时取掩码尺寸）
+	static RunLengthMask fromMat(const cv::Mat& mask, cv::Point offset = cv::Point(0, 0), cv::Size image_size = cv::Size());
+
+	const std::vector<MaskRun>& getRuns() const;
+	cv::Size getSize() const;
+	size_t area() const;
+	bool empty() const;
+
+	// 还原为与图像同尺寸的 CV_8UC1 掩码（0/255）
+	cv::Mat toMat() const;
+};
+
+#endif // RUN_LENGTH_MASK_H
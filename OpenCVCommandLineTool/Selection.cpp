@@ -0,0 +1,146 @@
+﻿/// ----------------------- Selection -----------------------
+///
+/// 说明：选区与选区内执行，见 Selection.h。
+///
+/// ----------------------- Selection -----------------------
+
+#include "Selection.h"
+
+#include <algorithm>
+
+namespace {
+
+	// 按通道数与位深转换为 type（饱和转换，不缩放）
+	cv::Mat matchType(const cv::Mat& src, int type) {
+		cv::Mat result = src;
+		const int from = result.channels();
+		const int to = CV_MAT_CN(type);
+		if (from != to) {
+			if (from == 1 && to == 3) cv::cvtColor(result, result, cv::COLOR_GRAY2BGR);
+			else if (from == 1 && to == 4) cv::cvtColor(result, result, cv::COLOR_GRAY2BGRA);
+			else if (from == 3 && to == 1) cv::cvtColor(result, result, cv::COLOR_BGR2GRAY);
+			else if (from == 4 && to == 1) cv::cvtColor(result, result, cv::COLOR_BGRA2GRAY);
+			else if (from == 3 && to == 4) cv::cvtColor(result, result, cv::COLOR_BGR2BGRA);
+			else if (from == 4 && to == 3) cv::cvtColor(result, result, cv::COLOR_BGRA2BGR);
+			else return cv::Mat();
+		}
+		if (result.depth() != CV_MAT_DEPTH(type)) {
+			result.convertTo(result, CV_MAT_DEPTH(type));
+		}
+		return result;
+	}
+
+	std::vector<cv::Point> toCvPoints(const std::vector<Point>& points) {
+		std::vector<cv::Point> result;
+		result.reserve(points.size());
+		for (const Point& p : points) {
+			result.emplace_back(cvRound(p.x), cvRound(p.y));
+		}
+		return result;
+	}
+
+}
+
+
+bool Selection::empty() const {
+	return bounds.area() == 0;
+}
+
+bool Selection::isValidFor(cv::Size size) const {
+	return !empty() && size == image_size;
+}
+
+Selection Selection::fromRect(const cv::Rect& rect, cv::Size image_size) {
+	Selection selection;
+	selection.image_size = image_size;
+	selection.bounds = rect & cv::Rect(0, 0, image_size.width, image_size.height);
+	return selection;
+}
+
+Selection Selection::fromPolygon(const std::vector<Point>& points, cv::Size image_size) {
+	Selection selection;
+	selection.image_size = image_size;
+	if (points.size() < 3) {
+		return selection;
+	}
+
+	std::vector<cv::Point> polygon = toCvPoints(points);
+	cv::Rect rect = cv::boundingRect(polygon) & cv::Rect(0, 0, image_size.width, image_size.height);
+	if (rect.area() == 0) {
+		return selection;
+	}
+
+	// 掩码只覆盖外接矩形
+	for (cv::Point& p : polygon) {
+		p -= rect.tl();
+	}
+	selection.bounds = rect;
+	selection.mask = cv::Mat::zeros(rect.size(), CV_8UC1);
+	std::vector<std::vector<cv::Point>> polygons = { polygon };
+	cv::fillPoly(selection.mask, polygons, cv::Scalar(255));
+	return selection;
+}
+
+Selection Selection::fromShape(const MyShape& shape, cv::Size image_size) {
+	const SegmentOutput& segment = shape.getSegmentOutput();
+	if (!segment._boxMask.empty()) {
+		Selection selection;
+		selection.image_size = image_size;
+		cv::Rect box(cvRound(segment._box.x), cvRound(segment._box.y), segment._boxMask.cols, segment._boxMask.rows);
+		cv::Rect rect = box & cv::Rect(0, 0, image_size.width, image_size.height);
+		if (rect.area() == 0) {
+			return selection;
+		}
+		cv::Mat box_mask = segment._boxMask(cv::Rect(rect.x - box.x, rect.y - box.y, rect.width, rect.height));
+		box_mask.convertTo(selection.mask, CV_8U);
+		selection.bounds = rect;
+		return selection;
+	}
+
+	const std::vector<Point>& points = shape.getPoints();
+	if (shape.getShapeType() == 1 && points.size() >= 3) {
+		return fromPolygon(points, image_size);
+	}
+	if (points.empty()) {
+		Selection selection;
+		selection.image_size = image_size;
+		return selection;
+	}
+	return fromRect(cv::boundingRect(toCvPoints(points)), image_size);
+}
+
+
+void applyToSelection(cv::Mat& image, const Selection& selection, int halo, const std::function<void(cv::Mat& region)>& op) {
+	const cv::Rect full(0, 0, image.cols, image.rows);
+	const cv::Rect bounds = selection.bounds & full;
+	if (bounds.area() == 0) {
+		return;
+	}
+
+	cv::Rect expanded = full;
+	if (halo != kWholeImageHalo) {
+		halo = std::max(0, halo);
+		expanded = cv::Rect(bounds.x - halo, bounds.y - halo, bounds.width + 2 * halo, bounds.height + 2 * halo) & full;
+	}
+	cv::Mat region = image(expanded).clone();
+	op(region);
+
+	if (region.size() != expanded.size()) {
+		std::cerr << "Error: Operation changed the size of the selection." << std::endl;
+		return;
+	}
+	cv::Mat result = matchType(region, image.type());
+	if (result.empty()) {
+		std::cerr << "Error: Cannot write the result back to an image with " << image.channels() << " channels." << std::endl;
+		return;
+	}
+
+	const cv::Rect core(bounds.x - expanded.x, bounds.y - expanded.y, bounds.width, bounds.height);
+	if (selection.mask.empty()) {
+		result(core).copyTo(image(bounds));
+	}
+	else {
+		cv::Mat mask = selection.mask(cv::Rect(bounds.x - selection.bounds.x, bounds.y - selection.bounds.y, bounds.width, bounds.height));
+		result(core).copyTo(image(bounds), mask);
+	}
+}
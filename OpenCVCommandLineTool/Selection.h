@@ -0,0 +1,43 @@
+﻿/// ----------------------- Selection -----------------------
+///
+/// 说明：当前选区（矩形、多边形或某个标注的形状 / 实例掩码）；
+///      设置选区后，filter / binary / type 命令只在选区外接矩形加上算子 halo 的区域上执行，
+///      结果按选区掩码混合回原图，开销与选区大小成正比，而不是与整幅图像成正比；
+///      依赖整幅图像的运算（填充孔洞、重建、距离图、分水岭等）以 kWholeImageHalo 在整幅图像上执行，
+///      同样只把选区内的结果写回；
+///      set_brightness_contrast 未指定 min / max 时取选区内的数据范围。
+///
+/// ----------------------- Selection -----------------------
+
+#pragma once
+#ifndef SELECTION_H
+#define SELECTION_H
+
+#include <opencv2/opencv.hpp>
+#include <functional>
+#include <vector>
+#include "MyShape.h"
+#include "Point.h"
+
+struct Selection {
+	cv::Rect bounds;          // 外接矩形（图像坐标），空矩形表示没有选区
+	cv::Mat mask;             // CV_8UC1，与 bounds 同尺寸；为空时整个矩形都被选中
+	cv::Size image_size;      // 创建选区时的图像尺寸，几何变换后选区失效
+
+	bool empty() const;
+	bool isValidFor(cv::Size size) const;
+
+	static Selection fromRect(const cv::Rect& rect, cv::Size image_size);
+	static Selection fromPolygon(const std::vector<Point>& points, cv::Size image_size);
+	// 有实例掩码时使用掩码，否则矩形（type 0）取外接矩形、多边形（type 1）填充多边形
+	static Selection fromShape(const MyShape& shape, cv::Size image_size);
+};
+
+// 结果不只取决于邻域、必须看到整幅图像的运算使用该 halo
+const int kWholeImageHalo = -1;
+
+// 在选区外接矩形扩展 halo 后的区域副本上执行 op（op 可改变区域的类型），
+// 再按原图类型转换，只把外接矩形内、掩码非零处写回 image；halo 为 kWholeImageHalo 时区域为整幅图像
+void applyToSelection(cv::Mat& image, const Selection& selection, int halo, const std::function<void(cv::Mat& region)>& op);
+
+#endif // SELECTION_H
@@ -0,0 +1,173 @@
+﻿/// ----------------------- Thinning -----------------------
+///
+/// 说明：查找表细化，见 Thinning.h。
+///
+/// ----------------------- Thinning -----------------------
+
+#include "Thinning.h"
+
+#include <array>
+#include <vector>
+
+namespace {
+
+	// 邻域编码：bit0 = E, bit1 = NE, bit2 = N, bit3 = NW, bit4 = W, bit5 = SW, bit6 = S, bit7 = SE
+	const int kDirectionBits[4] = { 1 << 2, 1 << 6, 1 << 0, 1 << 4 };   // 北、南、东、西
+
+	// 可删除：简单点且非端点
+	std::array<bool, 256> buildDeletableTable() {
+		std::array<bool, 256> table{};
+		for (int code = 0; code < 256; ++code) {
+			int x[10];
+			int count = 0;
+			for (int k = 1; k <= 8; ++k) {
+				x[k] = (code >> (k - 1)) & 1;
+				count += x[k];
+			}
+			x[9] = x[1];
+			// Yokoi 8 连通数：sum_{k = 1, 3, 5, 7} (~x[k] - ~x[k] * ~x[k+1] * ~x[k+2])
+			int connectivity = 0;
+			for (int k = 1; k <= 7; k += 2) {
+				const int a = 1 - x[k], b = 1 - x[k + 1], c = 1 - x[k + 2];
+				connectivity += a - a * b * c;
+			}
+			table[code] = (count >= 2) && (connectivity == 1);
+		}
+		return table;
+	}
+
+	const std::array<bool, 256>& deletableTable() {
+		static const std::array<bool, 256> table = buildDeletableTable();
+		return table;
+	}
+
+	// p 指向带 1 像素零边框的缓冲区中的前景像素
+	inline int neighbourCode(const uchar* p, int step) {
+		return (p[1] ? 1 : 0) | (p[-step + 1] ? 2 : 0) | (p[-step] ? 4 : 0) | (p[-step - 1] ? 8 : 0)
+			| (p[-1] ? 16 : 0) | (p[step - 1] ? 32 : 0) | (p[step] ? 64 : 0) | (p[step + 1] ? 128 : 0);
+	}
+
+	inline bool deletable(const uchar* p, int step, int direction_bit) {
+		const int code = neighbourCode(p, step);
+		return !(code & direction_bit) && deletableTable()[code];
+	}
+
+	// 第一轮：按行分条并行扫描整幅图像，每个方向先标记再删除
+	void firstPass(cv::Mat& padded) {
+		const int step = static_cast<int>(padded.step);
+		cv::Mat marks(padded.size(), CV_8UC1);
+		for (int d = 0; d < 4; ++d) {
+			cv::parallel_for_(cv::Range(1, padded.rows - 1), [&](const cv::Range& range) {
+				for (int y = range.start; y < range.end; ++y) {
+					const uchar* p = padded.ptr<uchar>(y);
+					uchar* m = marks.ptr<uchar>(y);
+					for (int x = 1; x < padded.cols - 1; ++x) {
+						m[x] = (p[x] && deletable(p + x, step, kDirectionBits[d])) ? 1 : 0;
+					}
+				}
+			});
+			cv::parallel_for_(cv::Range(1, padded.rows - 1), [&](const cv::Range& range) {
+				for (int y = range.start; y < range.end; ++y) {
+					uchar* p = padded.ptr<uchar>(y);
+					const uchar* m = marks.ptr<uchar>(y);
+					for (int x = 1; x < padded.cols - 1; ++x) {
+						if (m[x]) p[x] = 0;
+					}
+				}
+			});
+		}
+	}
+
+	// 收集边界点（8 邻域中有背景的前景像素），按行分条并行后合并
+	std::vector<int> collectBorder(const cv::Mat& padded) {
+		const int step = static_cast<int>(padded.step);
+		const int stripes = std::max(1, cv::getNumThreads());
+		std::vector<std::vector<int>> parts(stripes);
+		cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+			for (int s = range.start; s < range.end; ++s) {
+				const int y0 = 1 + (padded.rows - 2) * s / stripes;
+				const int y1 = 1 + (padded.rows - 2) * (s + 1) / stripes;
+				for (int y = y0; y < y1; ++y) {
+					const uchar* p = padded.ptr<uchar>(y);
+					for (int x = 1; x < padded.cols - 1; ++x) {
+						if (p[x] && neighbourCode(p + x, step) != 255) {
+							parts[s].push_back(y * step + x);
+						}
+					}
+				}
+			}
+		});
+		std::vector<int> border;
+		for (const std::vector<int>& part : parts) {
+			border.insert(border.end(), part.begin(), part.end());
+		}
+		return border;
+	}
+
+}
+
+
+void thinBinary(const cv::Mat& src, cv::Mat& dst) {
+	if (src.empty()) {
+		dst = cv::Mat();
+		return;
+	}
+	CV_Assert(src.type() == CV_8UC1);
+
+	// 1 像素零边框，邻域访问不需要边界判断
+	cv::Mat padded;
+	cv::copyMakeBorder(src, padded, 1, 1, 1, 1, cv::BORDER_CONSTANT, cv::Scalar(0));
+	const int step = static_cast<int>(padded.step);
+	uchar* data = padded.data;
+
+	firstPass(padded);
+
+	// 之后只处理边界点列表
+	std::vector<int> candidates = collectBorder(padded);
+	std::vector<uchar> queued(padded.total(), 0);
+	for (int i : candidates) {
+		queued[i] = 1;
+	}
+	const int offsets[8] = { 1, -step + 1, -step, -step - 1, -1, step - 1, step, step + 1 };
+
+	std::vector<int> removed;
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (int d = 0; d < 4; ++d) {
+			// 先按删除前的状态判断，再统一删除（子迭代内并行语义）
+			removed.clear();
+			for (int i : candidates) {
+				if (data[i] && deletable(data + i, step, kDirectionBits[d])) {
+					removed.push_back(i);
+				}
+			}
+			if (removed.empty()) {
+				continue;
+			}
+			changed = true;
+			for (int i : removed) {
+				data[i] = 0;
+			}
+			// 被删除点的前景邻点成为新的边界点
+			for (int i : removed) {
+				for (int k = 0; k < 8; ++k) {
+					const int n = i + offsets[k];
+					if (data[n] && !queued[n]) {
+						queued[n] = 1;
+						candidates.push_back(n);
+					}
+				}
+			}
+		}
+		// 去掉已删除的点
+		size_t kept = 0;
+		for (int i : candidates) {
+			if (data[i]) candidates[kept++] = i;
+		}
+		candidates.resize(kept);
+	}
+
+	cv::Mat result = padded(cv::Rect(1, 1, src.cols, src.rows));
+	cv::compare(result, 0, dst, cv::CMP_NE);
+}
@@ -0,0 +1,26 @@
+﻿/// ----------------------- Thinning -----------------------
+///
+/// 说明：查找表驱动的二值细化（骨架化）；
+///      每轮按 北、南、东、西 四个方向各做一次子迭代，子迭代内并行删除该方向上的边界点，
+///      删除条件由 3x3 邻域编码的 256 项查找表给出：
+///        - 简单点（Yokoi 8 连通数为 1，删除后不改变连通性与孔洞数）
+///        - 非端点（至少两个前景邻点，保留分支末端）
+///      同一方向的简单边界点同时删除不会改变拓扑（Rosenfeld），因此结果与原图拓扑一致，
+///      2 x 2 方块等 Zhang-Suen 会整体删除的结构也会保留下来，结果为单像素宽的骨架。
+///
+///      第一轮按行分条并行扫描整幅图像，同时收集边界点；
+///      之后只处理边界点列表，删除一个点后把它的前景邻点加入列表，
+///      开销与边界长度成正比，而不是 (物体厚度) x (图像面积)。
+///
+/// ----------------------- Thinning -----------------------
+
+#pragma once
+#ifndef THINNING_H
+#define THINNING_H
+
+#include <opencv2/opencv.hpp>
+
+// 细化 CV_8UC1 掩码（非零为前景），结果为 0 / 255；图像外按背景处理
+void thinBinary(const cv::Mat& src, cv::Mat& dst);
+
+#endif // THINNING_H
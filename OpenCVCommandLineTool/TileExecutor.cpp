@@ -0,0 +1,303 @@
+﻿/// ----------------------- TileExecutor -----------------------
+///
+/// 说明：邻域滤波的分块并行执行器与工作窃取线程池，见 TileExecutor.h。
+///
+/// ----------------------- TileExecutor -----------------------
+
+#include "TileExecutor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+	struct TaskQueue {
+		std::mutex mutex;
+		std::deque<int> tasks;
+	};
+
+}
+
+
+/// ----------------------- 工作窃取线程池 -----------------------
+
+/* 一次 runWorkStealing 调用：每个参与者一个任务队列，调用线程为参与者 0 */
+struct WorkStealingPool::Job {
+	const std::function<void(int)>* task = nullptr;
+	std::vector<std::unique_ptr<TaskQueue>> queues;
+	int joined = 0;                     // 已加入的工作线程数（受 pool mutex 保护）
+	std::atomic<int> pending{ 0 };      // 尚未被取走的任务数
+	std::atomic<int> remaining{ 0 };    // 尚未完成的任务数
+	std::mutex error_mutex;
+	std::exception_ptr error;
+};
+
+WorkStealingPool::WorkStealingPool(int threads) {
+	grow(threads);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+int WorkStealingPool::size() const {
+	std::lock_guard<std::mutex> lock(grow_mutex);
+	return static_cast<int>(workers.size()) + 1;
+}
+
+void WorkStealingPool::grow(int threads) {
+	std::lock_guard<std::mutex> lock(grow_mutex);
+	while (static_cast<int>(workers.size()) + 1 < threads) {
+		workers.emplace_back([this]() { workerLoop(); });
+	}
+}
+
+void WorkStealingPool::run(int task_count, int threads, const std::function<void(int)>& task) {
+	if (task_count <= 0) {
+		return;
+	}
+	threads = std::max(1, std::min(threads, task_count));
+	if (threads == 1) {
+		for (int i = 0; i < task_count; ++i) {
+			task(i);
+		}
+		return;
+	}
+	grow(threads);
+
+	// 连续分配任务，相邻的块留在同一线程上
+	std::shared_ptr<Job> job = std::make_shared<Job>();
+	job->task = &task;
+	for (int id = 0; id < threads; ++id) {
+		job->queues.push_back(std::make_unique<TaskQueue>());
+	}
+	for (int i = 0; i < task_count; ++i) {
+		job->queues[static_cast<long long>(i) * threads / task_count]->tasks.push_back(i);
+	}
+	job->pending = task_count;
+	job->remaining = task_count;
+
+	// 池任务内不再使用 OpenCV 的内部并行，避免两层线程数相乘；最后一个并行任务结束时恢复
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (parallel_jobs++ == 0) {
+			saved_cv_threads = cv::getNumThreads();
+			cv::setNumThreads(1);
+		}
+		jobs.push_back(job);
+	}
+	wake.notify_all();
+
+	drain(*job, 0);
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&]() { return job->remaining == 0; });
+		jobs.erase(std::find(jobs.begin(), jobs.end(), job));
+		if (--parallel_jobs == 0) {
+			cv::setNumThreads(saved_cv_threads);
+		}
+	}
+	if (job->error) {
+		std::rethrow_exception(job->error);
+	}
+}
+
+void WorkStealingPool::workerLoop() {
+	while (true) {
+		std::shared_ptr<Job> job;
+		int id = 0;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			// 加入还有未取走任务、参与者未满的调用（包括任务内嵌套的调用）
+			wake.wait(lock, [&]() {
+				if (stopping) {
+					return true;
+				}
+				for (const std::shared_ptr<Job>& candidate : jobs) {
+					if (candidate->pending > 0 && candidate->joined + 1 < static_cast<int>(candidate->queues.size())) {
+						job = candidate;
+						return true;
+					}
+				}
+				return false;
+			});
+			if (stopping) {
+				return;
+			}
+			id = ++job->joined;
+		}
+		drain(*job, id);
+	}
+}
+
+void WorkStealingPool::drain(Job& job, int id) {
+	const int threads = static_cast<int>(job.queues.size());
+	while (true) {
+		int t = -1;
+		{
+			TaskQueue& own = *job.queues[id];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.tasks.empty()) {
+				t = own.tasks.front();
+				own.tasks.pop_front();
+			}
+		}
+		// 自己的队列为空时，从其他参与者的队列尾部窃取
+		for (int k = 1; t < 0 && k < threads; ++k) {
+			TaskQueue& victim = *job.queues[(id + k) % threads];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.tasks.empty()) {
+				t = victim.tasks.back();
+				victim.tasks.pop_back();
+			}
+		}
+		// 任务不会再产生，所有队列均为空即结束
+		if (t < 0) {
+			return;
+		}
+		--job.pending;
+
+		try {
+			(*job.task)(t);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(job.error_mutex);
+			if (!job.error) job.error = std::current_exception();
+		}
+
+		if (--job.remaining == 0) {
+			std::lock_guard<std::mutex> lock(mutex);
+			done.notify_all();
+		}
+	}
+}
+
+void runWorkStealing(int task_count, int threads, const std::function<void(int)>& task) {
+	TileExecutor::workerPool().run(task_count, threads, task);
+}
+
+
+/// ----------------------- 配置 -----------------------
+
+TileOptions& TileExecutor::globalOptions() {
+	static TileOptions options;
+	return options;
+}
+
+const TileOptions& TileExecutor::getOptions() {
+	return globalOptions();
+}
+
+void TileExecutor::setOptions(const TileOptions& options) {
+	globalOptions() = options;
+}
+
+WorkStealingPool& TileExecutor::workerPool() {
+	static WorkStealingPool pool(threadCount(getOptions()));
+	return pool;
+}
+
+int TileExecutor::threadCount(const TileOptions& options) {
+	if (options.threads > 0) {
+		return options.threads;
+	}
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+
+/// ----------------------- 分块执行 -----------------------
+
+void TileExecutor::run(cv::Mat& image, int halo, const TileOperation& op, int output_type) {
+	run(image, halo, op, output_type, getOptions());
+}
+
+void TileExecutor::run(cv::Mat& image, int halo, const TileOperation& op, int output_type, const TileOptions& options) {
+	if (image.empty()) {
+		return;
+	}
+	const int tile = options.tile_size;
+	const int rows = image.rows;
+	const int cols = image.cols;
+
+	// 不分块，或图像不超过一个块
+	if (tile <= 0 || (rows <= tile && cols <= tile)) {
+		cv::Mat out;
+		op(image, out);
+		image = out;
+		return;
+	}
+
+	halo = std::max(0, halo);
+	const int out_type = (output_type < 0) ? image.type() : output_type;
+	const bool in_place = (out_type == image.type());
+	cv::Mat output = in_place ? image : cv::Mat(image.size(), out_type);
+
+	// 每个条带至少包含 2 * threads 个块，且高度不小于 halo（下一条带的上方 halo 只来自当前条带）
+	const int threads = threadCount(options);
+	const int tiles_x = (cols + tile - 1) / tile;
+	const int band_tile_rows = std::max((2 * threads + tiles_x - 1) / tiles_x, (halo + tile - 1) / tile);
+	const int band_height = std::max(1, band_tile_rows) * tile;
+
+	cv::Mat saved_top;                                   // 当前条带上方 halo 行的原始数据
+	cv::Mat band_output(std::min(band_height, rows), cols, out_type);
+
+	for (int y0 = 0; y0 < rows; y0 += band_height) {
+		const int y1 = std::min(y0 + band_height, rows);
+		const int top = std::min(halo, y0);
+		const int bottom = std::min(halo, rows - y1);
+
+		// 条带输入：原地写回时上方 halo 已被覆盖，改用保存的原始行
+		cv::Mat band_input;
+		if (in_place && top > 0) {
+			band_input.create(top + (y1 - y0) + bottom, cols, image.type());
+			saved_top.copyTo(band_input.rowRange(0, top));
+			image.rowRange(y0, y1 + bottom).copyTo(band_input.rowRange(top, band_input.rows));
+		}
+		else {
+			band_input = image.rowRange(y0 - top, y1 + bottom);
+		}
+
+		const int tiles_y = (y1 - y0 + tile - 1) / tile;
+		runWorkStealing(tiles_y * tiles_x, threads, [&](int t) {
+			// 块的核心区域（条带坐标）
+			const int cy0 = (t / tiles_x) * tile;
+			const int cy1 = std::min(cy0 + tile, y1 - y0);
+			const int cx0 = (t % tiles_x) * tile;
+			const int cx1 = std::min(cx0 + tile, cols);
+
+			// 向外扩展 halo，裁剪到图像范围
+			const int ey0 = std::max(cy0 + top - halo, 0);
+			const int ey1 = std::min(cy1 + top + halo, band_input.rows);
+			const int ex0 = std::max(cx0 - halo, 0);
+			const int ex1 = std::min(cx1 + halo, cols);
+
+			cv::Mat in = band_input(cv::Rect(ex0, ey0, ex1 - ex0, ey1 - ey0));
+			cv::Mat out;
+			op(in, out);
+			out(cv::Rect(cx0 - ex0, cy0 + top - ey0, cx1 - cx0, cy1 - cy0))
+				.copyTo(band_output(cv::Rect(cx0, cy0, cx1 - cx0, cy1 - cy0)));
+		});
+
+		// 写回前保存下一条带需要的原始行
+		if (in_place && halo > 0 && y1 < rows) {
+			saved_top = image.rowRange(y1 - halo, y1).clone();
+		}
+		band_output.rowRange(0, y1 - y0).copyTo(output.rowRange(y0, y1));
+	}
+
+	image = output;
+}
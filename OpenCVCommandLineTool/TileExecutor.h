@@ -0,0 +1,90 @@
+﻿/// ----------------------- TileExecutor -----------------------
+///
+/// 说明：邻域滤波的分块并行执行器；
+///      图像按 tile_size 划分为块，每块按算子的邻域半径（halo）向外扩展后独立计算，
+///      只写回块的核心区域，因此块与块之间没有接缝；图像边缘处不扩展，边界处理与整幅计算相同。
+///
+///      执行方式：按行把若干行块组成一个条带（band），条带内的块交给工作窃取线程池并行计算；
+///      条带结果写回原图前保存下一条带需要的原始 halo 行，因此可以原地写回，
+///      额外内存只有一个条带及其 halo，而不是若干份整幅图像。
+///      线程池中每个线程有自己的任务队列，队列空时从其他线程的队列尾部窃取。
+///      线程池由 TileExecutor 持有，首次使用时按 TileOptions 的线程数创建，之后常驻复用，
+///      请求更多线程时扩充；每次调用只占用其 threads 个参与者（含调用线程）。
+///      任务内可以再次调用（如 stack apply 的每页滤波），空闲线程会加入内层调用，调用线程自己也会执行内层任务。
+///      池任务执行期间 OpenCV 的内部并行被关闭（cv::setNumThreads(1)），避免线程数相乘。
+///
+///      块大小与线程数通过 `tiles` 命令配置；tile_size 为 0 时不分块，直接整幅计算。
+///
+/// ----------------------- TileExecutor -----------------------
+
+#pragma once
+#ifndef TILE_EXECUTOR_H
+#define TILE_EXECUTOR_H
+
+#include <opencv2/opencv.hpp>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct TileOptions {
+	int tile_size = 512;     // 块边长（像素），0 表示不分块
+	int threads = 0;         // 线程数，0 表示使用硬件线程数
+};
+
+// 分块执行时的算子：in 为带 halo 的块，out 与 in 尺寸相同
+using TileOperation = std::function<void(const cv::Mat& in, cv::Mat& out)>;
+
+/* 常驻的工作窃取线程池 */
+class WorkStealingPool {
+public:
+	explicit WorkStealingPool(int threads);
+	~WorkStealingPool();
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	int size() const;                  // 线程数（含调用线程）
+	void grow(int threads);
+
+	// 执行 task(0 .. task_count - 1)，最多 threads 个参与者；返回时所有任务已完成，任务抛出的第一个异常在此重新抛出
+	void run(int task_count, int threads, const std::function<void(int)>& task);
+
+private:
+	struct Job;
+
+	void workerLoop();
+	void drain(Job& job, int id);
+
+	mutable std::mutex grow_mutex;
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;                  // 保护以下成员
+	std::condition_variable wake;
+	std::condition_variable done;
+	std::vector<std::shared_ptr<Job>> jobs;
+	int parallel_jobs = 0;
+	int saved_cv_threads = 1;
+	bool stopping = false;
+};
+
+class TileExecutor {
+private:
+	static TileOptions& globalOptions();
+
+public:
+	static WorkStealingPool& workerPool();
+	static const TileOptions& getOptions();
+	static void setOptions(const TileOptions& options);
+	static int threadCount(const TileOptions& options);
+
+	// 在 image 上执行 op；output_type 为 -1 或与输入类型相同时原地写回，否则 image 被替换为新类型的结果
+	static void run(cv::Mat& image, int halo, const TileOperation& op, int output_type = -1);
+	static void run(cv::Mat& image, int halo, const TileOperation& op, int output_type, const TileOptions& options);
+};
+
+// 在 TileExecutor 的线程池上执行 task(0 .. task_count - 1)
+void runWorkStealing(int task_count, int threads, const std::function<void(int)>& task);
+
+#endif // TILE_EXECUTOR_H
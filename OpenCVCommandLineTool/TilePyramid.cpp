@@ -0,0 +1,165 @@
+﻿/// ----------------------- TilePyramid -----------------------
+///
+/// 说明：瓦片金字塔导出，见 TilePyramid.h。
+///
+/// ----------------------- TilePyramid -----------------------
+
+#include "TilePyramid.h"
+#include "TileExecutor.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+	// 瓦片内容的 64 位哈希，用于判断瓦片是否变化（非加密用途）
+	uint64_t tileHash(const cv::Mat& tile) {
+		uint64_t h = 0x9E3779B97F4A7C15ull ^ (static_cast<uint64_t>(tile.rows) << 32) ^ (static_cast<uint64_t>(tile.cols) << 8) ^ tile.type();
+		const size_t row_bytes = tile.cols * tile.elemSize();
+		for (int y = 0; y < tile.rows; ++y) {
+			const unsigned char* p = tile.ptr<unsigned char>(y);
+			size_t i = 0;
+			for (; i + 8 <= row_bytes; i += 8) {
+				uint64_t v;
+				std::memcpy(&v, p + i, 8);
+				h = (h ^ v) * 0x100000001B3ull;
+				h ^= h >> 29;
+			}
+			for (; i < row_bytes; ++i) {
+				h = (h ^ p[i]) * 0x100000001B3ull;
+			}
+		}
+		return h;
+	}
+
+	std::string tileKey(int level, int col, int row) {
+		return std::to_string(level) + "/" + std::to_string(col) + "_" + std::to_string(row);
+	}
+
+	// 读取上次导出的哈希；图像尺寸、瓦片大小或格式不同则全部重建
+	std::map<std::string, uint64_t> loadManifest(const fs::path& path, const cv::Size& size, const PyramidOptions& options) {
+		std::map<std::string, uint64_t> hashes;
+		std::ifstream file(path);
+		if (!file) {
+			return hashes;
+		}
+		nlohmann::json j = nlohmann::json::parse(file, nullptr, false);
+		if (j.is_discarded() || j.value("width", 0) != size.width || j.value("height", 0) != size.height
+			|| j.value("tile_size", 0) != options.tile_size || j.value("format", std::string()) != options.format) {
+			return hashes;
+		}
+		if (j.contains("tiles") && j["tiles"].is_object()) {
+			for (auto it = j["tiles"].begin(); it != j["tiles"].end(); ++it) {
+				hashes[it.key()] = it.value().get<uint64_t>();
+			}
+		}
+		return hashes;
+	}
+
+}
+
+
+PyramidResult exportPyramid(const cv::Mat& image, const std::string& dir, const std::string& name, const PyramidOptions& options) {
+	PyramidResult result;
+	if (image.empty() || options.tile_size <= 0) {
+		std::cerr << "Error: Image is empty or tile size is not positive." << std::endl;
+		return result;
+	}
+
+	const fs::path root = fs::u8path(dir);
+	const fs::path files_dir = root / (name + "_files");
+	const fs::path manifest_path = files_dir / "tiles.json";
+	const int tile = options.tile_size;
+
+	std::map<std::string, uint64_t> previous = loadManifest(manifest_path, image.size(), options);
+	if (previous.empty() && fs::exists(files_dir)) {
+		// 布局已变化，旧瓦片不再对应任何层
+		std::error_code ec;
+		fs::remove_all(files_dir, ec);
+	}
+	fs::create_directories(files_dir);
+
+	// Deep Zoom 层号：最高层 ceil(log2(max(w, h)))，第 0 层为 1 x 1
+	const int max_level = static_cast<int>(std::ceil(std::log2(std::max(image.cols, image.rows))));
+	result.levels = max_level + 1;
+
+	nlohmann::json tiles_json = nlohmann::json::object();
+	std::atomic<int> written(0);
+	std::atomic<bool> failed(false);
+	const int threads = TileExecutor::threadCount(TileExecutor::getOptions());
+
+	cv::Mat level_image = image;
+	for (int level = max_level; level >= 0; --level) {
+		const fs::path level_dir = files_dir / std::to_string(level);
+		fs::create_directories(level_dir);
+
+		const int cols = (level_image.cols + tile - 1) / tile;
+		const int rows = (level_image.rows + tile - 1) / tile;
+		std::vector<uint64_t> hashes(static_cast<size_t>(cols) * rows);
+
+		runWorkStealing(cols * rows, threads, [&](int t) {
+			const int col = t % cols;
+			const int row = t / cols;
+			const cv::Rect rect(col * tile, row * tile,
+				std::min(tile, level_image.cols - col * tile), std::min(tile, level_image.rows - row * tile));
+			const cv::Mat tile_mat = level_image(rect);
+			hashes[t] = tileHash(tile_mat);
+
+			// 内容与上次导出相同且文件存在时跳过编码
+			const fs::path tile_path = level_dir / (std::to_string(col) + "_" + std::to_string(row) + "." + options.format);
+			auto it = previous.find(tileKey(level, col, row));
+			if (it != previous.end() && it->second == hashes[t] && fs::exists(tile_path)) {
+				return;
+			}
+			if (cv::imwrite(tile_path.string(), tile_mat)) {
+				++written;
+			}
+			else {
+				failed = true;
+			}
+		});
+
+		for (int t = 0; t < cols * rows; ++t) {
+			tiles_json[tileKey(level, t % cols, t / cols)] = hashes[t];
+		}
+		result.tiles += cols * rows;
+
+		// 下一层由本层缩小一半（向上取整）
+		if (level > 0) {
+			cv::Mat next;
+			cv::resize(level_image, next, cv::Size((level_image.cols + 1) / 2, (level_image.rows + 1) / 2), 0, 0, options.interpolation);
+			level_image = next;
+		}
+	}
+	result.tiles_written = written;
+
+	std::ofstream dzi(root / (name + ".dzi"));
+	dzi << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		<< "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" Format=\"" << options.format
+		<< "\" Overlap=\"0\" TileSize=\"" << tile << "\">\n"
+		<< "  <Size Width=\"" << image.cols << "\" Height=\"" << image.rows << "\"/>\n"
+		<< "</Image>\n";
+
+	nlohmann::json manifest;
+	manifest["width"] = image.cols;
+	manifest["height"] = image.rows;
+	manifest["tile_size"] = tile;
+	manifest["format"] = options.format;
+	manifest["tiles"] = tiles_json;
+	std::ofstream(manifest_path) << manifest.dump();
+
+	result.ok = dzi.good() && !failed;
+	if (failed) {
+		std::cerr << "Error: Failed to write some tiles to " << files_dir.string() << std::endl;
+	}
+	return result;
+}
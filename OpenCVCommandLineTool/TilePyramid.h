@@ -0,0 +1,38 @@
+﻿/// ----------------------- TilePyramid -----------------------
+///
+/// 说明：Deep Zoom 风格的多分辨率瓦片金字塔导出，供前端浏览超大图像；
+///      目录结构：<dir>/<name>.dzi 与 <dir>/<name>_files/<level>/<col>_<row>.<format>，
+///      最高层为原始分辨率，每层由上一层经 INTER_AREA 缩小一半得到，直到 1 x 1。
+///
+///      每层的瓦片交给工作窃取线程池并行编码。
+///      增量导出：每个瓦片内容的哈希记录在 <name>_files/tiles.json 中，
+///      再次导出到同一目录时只重新编码内容发生变化（或文件缺失）的瓦片，
+///      因此只修改了局部区域（如选区内滤波）时，只有该区域及其在各层对应的瓦片被重写。
+///
+/// ----------------------- TilePyramid -----------------------
+
+#pragma once
+#ifndef TILE_PYRAMID_H
+#define TILE_PYRAMID_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+
+struct PyramidOptions {
+	int tile_size = 256;          // 瓦片边长（像素）
+	std::string format = "png";   // 瓦片文件格式
+	int interpolation = cv::INTER_AREA;
+};
+
+struct PyramidResult {
+	bool ok = false;
+	int levels = 0;               // 层数（含 1 x 1 层）
+	int tiles = 0;                // 瓦片总数
+	int tiles_written = 0;        // 本次重新编码的瓦片数
+};
+
+// 导出 image（通常为 8 位显示图像）的瓦片金字塔；内容未变化的瓦片不重新编码
+PyramidResult exportPyramid(const cv::Mat& image, const std::string& dir, const std::string& name,
+	const PyramidOptions& options = PyramidOptions());
+
+#endif // TILE_PYRAMID_H
@@ -0,0 +1,146 @@
+﻿/// ----------------------- Watershed -----------------------
+///
+/// 说明：桶队列淹没的二值分水岭，见 Watershed.h。
+///
+/// ----------------------- Watershed -----------------------
+
+#include "Watershed.h"
+#include "DistanceMap.h"
+#include "Reconstruction.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+	const int kLevelsPerPixel = 4;     // EDM 量化精度：1/4 像素一层
+	const int kMaxLevel = 65535;
+
+	// 标签缓冲区中的特殊值（种子标签从 1 开始）
+	const int kUnlabeled = 0;
+	const int kQueued = -1;
+	const int kLine = -2;
+	const int kOutside = -3;           // 背景与边框
+
+	// 每层一个 FIFO 桶；淹没只会从当前层向更低层推进
+	class BucketQueue {
+	private:
+		std::vector<std::vector<int>> buckets;
+		std::vector<size_t> heads;
+		int current;
+
+	public:
+		explicit BucketQueue(int levels) : buckets(levels), heads(levels, 0), current(levels - 1) {}
+
+		void push(int index, int level) {
+			buckets[level].push_back(index);
+		}
+
+		// 取出最高非空层的下一个像素；队列为空时返回 false
+		bool pop(int& index, int& level) {
+			while (current >= 0) {
+				std::vector<int>& bucket = buckets[current];
+				if (heads[current] < bucket.size()) {
+					index = bucket[heads[current]++];
+					level = current;
+					return true;
+				}
+				std::vector<int>().swap(bucket);   // 已处理完的层释放内存
+				--current;
+			}
+			return false;
+		}
+	};
+
+}
+
+
+void watershedSeparate(const cv::Mat& mask, cv::Mat& dst, double tolerance) {
+	CV_Assert(mask.type() == CV_8UC1);
+	if (mask.empty()) {
+		dst = cv::Mat();
+		return;
+	}
+
+	// 种子：EDM 的 h 极大值区域，按 8 连通编号
+	cv::Mat edm, maxima, seeds;
+	euclideanDistanceMap(mask, edm);
+	hMaxima(edm, tolerance, maxima);
+	cv::bitwise_and(maxima, mask, maxima);
+	const int seed_count = cv::connectedComponents(maxima, seeds, 8, CV_32S) - 1;
+
+	// 带 1 像素边框的标签与层级缓冲区，邻域访问不需要边界判断
+	cv::Mat labels(mask.rows + 2, mask.cols + 2, CV_32SC1, cv::Scalar(kOutside));
+	cv::Mat levels(mask.rows + 2, mask.cols + 2, CV_16UC1, cv::Scalar(0));
+	int max_level = 0;
+	for (int y = 0; y < mask.rows; ++y) {
+		const uchar* m = mask.ptr<uchar>(y);
+		const float* e = edm.ptr<float>(y);
+		const int* s = seeds.ptr<int>(y);
+		int* l = labels.ptr<int>(y + 1) + 1;
+		ushort* v = levels.ptr<ushort>(y + 1) + 1;
+		for (int x = 0; x < mask.cols; ++x) {
+			if (!m[x]) continue;
+			l[x] = s[x];
+			v[x] = static_cast<ushort>(std::min<double>(kMaxLevel, e[x] * kLevelsPerPixel));
+			max_level = std::max<int>(max_level, v[x]);
+		}
+	}
+
+	const int step = labels.cols;
+	const int offsets[8] = { -1, 1, -step, step, -step - 1, -step + 1, step - 1, step + 1 };
+	int* label = labels.ptr<int>();
+	const ushort* level = levels.ptr<ushort>();
+
+	// 种子的未标记邻点按自身层级入队
+	BucketQueue queue(max_level + 1);
+	if (seed_count > 0) {
+		for (int y = 1; y < labels.rows - 1; ++y) {
+			for (int x = 1; x < labels.cols - 1; ++x) {
+				const int p = y * step + x;
+				if (label[p] <= 0) continue;
+				for (int offset : offsets) {
+					const int q = p + offset;
+					if (label[q] == kUnlabeled) {
+						label[q] = kQueued;
+						queue.push(q, level[q]);
+					}
+				}
+			}
+		}
+	}
+
+	// 由高到低淹没；比当前层高的邻点在当前层处理，保证出队层级单调不增
+	int p, current;
+	while (queue.pop(p, current)) {
+		int owner = 0;
+		bool conflict = false;
+		for (int offset : offsets) {
+			const int n = label[p + offset];
+			if (n > 0) {
+				if (owner == 0) owner = n;
+				else if (n != owner) conflict = true;
+			}
+		}
+		if (conflict || owner == 0) {
+			label[p] = kLine;
+			continue;
+		}
+		label[p] = owner;
+		for (int offset : offsets) {
+			const int q = p + offset;
+			if (label[q] == kUnlabeled) {
+				label[q] = kQueued;
+				queue.push(q, std::min<int>(level[q], current));
+			}
+		}
+	}
+
+	// 分界线像素置 0
+	cv::Mat output;
+	cv::compare(mask, 0, output, cv::CMP_NE);
+	cv::Mat line_mask;
+	cv::compare(labels(cv::Rect(1, 1, mask.cols, mask.rows)), kLine, line_mask, cv::CMP_EQ);
+	output.setTo(0, line_mask);
+	dst = output;
+}
@@ -0,0 +1,23 @@
+﻿/// ----------------------- Watershed -----------------------
+///
+/// 说明：基于 EDM 的二值分水岭，用 1 像素宽的分界线切开相互粘连的颗粒（对应 ImageJ 的 Binary > Watershed）；
+///
+///      1. 精确 EDM（DistanceMap.h），种子为深度不小于 tolerance 的极大值区域（Reconstruction.h 的 hMaxima），
+///         每个连通的极大值区域一个标签；
+///      2. 从种子沿 EDM 由高到低淹没：EDM 按 1/kLevelsPerPixel 像素量化为整数层级，
+///         以每层一个 FIFO 桶的桶队列代替堆，入队与出队都是 O(1)，总开销与像素数成线性关系；
+///      3. 出队像素的 8 邻域已有两个不同标签时成为分界线，不再向外传播；
+///         因此不同标签的像素之间不存在 8 邻接，分界线能切断 8 连通的颗粒。
+///
+/// ----------------------- Watershed -----------------------
+
+#pragma once
+#ifndef WATERSHED_H
+#define WATERSHED_H
+
+#include <opencv2/opencv.hpp>
+
+// mask 为 CV_8UC1（非零为前景），dst 为 0 / 255 掩码，分界线像素置 0；dst 可与 mask 相同
+void watershedSeparate(const cv::Mat& mask, cv::Mat& dst, double tolerance = 0.5);
+
+#endif // WATERSHED_H
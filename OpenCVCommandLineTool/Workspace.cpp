@@ -27,6 +27,7 @@
 /// ----------------------- Workspace类 -----------------------
 
 #include "Workspace.h"
+#include "PolygonTracing.h"
 #include <fstream>
 #include <nlohmann/json.hpp> // 需要安装 JSON 库
 #include <filesystem>
@@ -35,8 +36,28 @@ using json = nlohmann::json;
 namespace fs = std::filesystem;
 
 /// ----------------------- 构造函数 -----------------------
-Workspace::Workspace(const std::filesystem::path& image_path)
-	: image(std::make_unique<MyImage>(image_path.string())),
+Workspace::Workspace(const std::filesystem::path& image_path, bool unchanged)
+	: image(std::make_unique<MyImage>(image_path.string(), unchanged)),
+	image_path(image_path.string()),
+	annotation_path((image_path.parent_path() / (image_path.stem().string() + ".json")).string()),
+	mask_path((image_path.parent_path() / (image_path.stem().string() + "_mask.png")).string()) {
+	loadFromAnnotationFile();
+	loadFromMaskFile();
+}
+
+Workspace::Workspace(const std::filesystem::path& image_path, const cv::Mat& image_mat, bool load_sidecars)
+	: image(std::make_unique<MyImage>(image_path.string(), image_mat)),
+	image_path(image_path.string()),
+	annotation_path((image_path.parent_path() / (image_path.stem().string() + ".json")).string()),
+	mask_path((image_path.parent_path() / (image_path.stem().string() + "_mask.png")).string()) {
+	if (load_sidecars) {
+		loadFromAnnotationFile();
+		loadFromMaskFile();
+	}
+}
+
+Workspace::Workspace(const std::filesystem::path& image_path, const RawImageInfo& raw_info)
+	: image(std::make_unique<MyImage>(image_path.string(), raw_info)),
 	image_path(image_path.string()),
 	annotation_path((image_path.parent_path() / (image_path.stem().string() + ".json")).string()),
 	mask_path((image_path.parent_path() / (image_path.stem().string() + "_mask.png")).string()) {
@@ -90,6 +111,16 @@ void Workspace::importShapes(const std::vector<MyShape>& new_shapes) {
 	shapes.insert(shapes.end(), new_shapes.begin(), new_shapes.end());
 }
 
+// 删除全部标注
+void Workspace::clearShapes() {
+	shapes.clear();
+}
+
+// 实例掩码转多边形
+int Workspace::polygonizeShapes(double tolerance) {
+	return convertMasksToPolygons(shapes, tolerance);
+}
+
 
 
 /// ----------------------- JSON文件的读写 -----------------------
@@ -188,7 +219,7 @@ bool Workspace::saveToAnnotationFile() const {
 /// ----------------------- PNG掩码图像的读写 -----------------------
 // 保存掩码图像为PNG
 void Workspace::saveBinaryMaskAsPng() {
-	cv::imwrite(mask_path, binary_mask);
+	cv::imwrite(mask_path, binary_mask.toMat());
 }
 
 // 读取PNG掩码图像，放入binary_mask
@@ -204,8 +235,10 @@ bool Workspace::loadFromMaskFile() {
 		return false; // 读取失败
 	}
 
-	// 转成二值图：像素值为0或255
-	cv::threshold(mask, binary_mask, 127, 255, cv::THRESH_BINARY);
+	// 转成二值图：大于 127 为前景，按位打包保存
+	cv::threshold(mask, mask, 127, 255, cv::THRESH_BINARY);
+	binary_mask = BitMask::fromMat(mask);
+	binary_mask_runs_dirty = true;
 
 	return true;
 }
@@ -215,11 +248,24 @@ bool Workspace::loadFromMaskFile() {
 // 运行YoloModelProcessor
 void Workspace::runYoloModelProcessor(std::shared_ptr<YoloModelProcessor> processor) {
 	setYoloModelProcessor(processor);
-	
-	yolo_model_processor->infer(image->getImageMat());
+
+	// 模型输入为 8 位三通道；RAW 载入或转换过位深的图像在副本上转换，不改动当前图像
+	cv::Mat& source = image->getImageMat();
+	if (source.type() == CV_8UC3) {
+		yolo_model_processor->infer(source);
+	}
+	else {
+		PointwisePipeline ops;
+		appendColorDepthOps(ops, source.type(), kRGBColor);
+		cv::Mat input;
+		ops.apply(source, input);
+		yolo_model_processor->infer(input);
+	}
 
 	importShapes(yolo_model_processor->getShapes());
-	binary_mask = yolo_model_processor->getBinaryMask();
+	const cv::Mat& mask = yolo_model_processor->getBinaryMask();
+	binary_mask = mask.empty() ? BitMask() : BitMask::fromMat(mask);
+	binary_mask_runs_dirty = true;
 }
 
 
@@ -255,8 +301,43 @@ const std::vector<MyShape>& Workspace::getShapes() const {
 }
 
 // 获取 binary_mask 的方法
-const cv::Mat& Workspace::getBinaryMask() const {
-	return binary_mask;
+cv::Mat Workspace::getBinaryMask() const {
+	return binary_mask.toMat();
+}
+
+bool Workspace::hasBinaryMask() const {
+	return !binary_mask.empty();
+}
+
+// 获取 binary_mask 的 RLE 索引
+const RunLengthMask& Workspace::getBinaryMaskRuns() {
+	if (binary_mask_runs_dirty) {
+		binary_mask_runs = RunLengthMask::fromMat(binary_mask.toMat());
+		binary_mask_runs_dirty = false;
+	}
+	return binary_mask_runs;
+}
+
+// 设置 / 清除选区
+void Workspace::setSelection(const Selection& selection) {
+	this->selection = selection;
+}
+
+void Workspace::clearSelection() {
+	selection = Selection();
+}
+
+// 裁剪、缩放、旋转等改变图像尺寸后，选区坐标不再对应原来的像素
+const Selection* Workspace::getActiveSelection() {
+	if (selection.empty()) {
+		return nullptr;
+	}
+	if (!selection.isValidFor(image->getImageMat().size())) {
+		std::cout << "Warning: Image size changed, selection cleared.\n";
+		clearSelection();
+		return nullptr;
+	}
+	return &selection;
 }
 
 void Workspace::setYoloModelProcessor(std::shared_ptr<YoloModelProcessor> processor) {
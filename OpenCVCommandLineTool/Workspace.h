@@ -36,6 +36,9 @@
 #include "MyShape.h"
 #include "MyImage.h"
 #include "YoloModelProcessor.h"
+#include "RunLengthMask.h"
+#include "BitMask.h"
+#include "Selection.h"
 
 
 class Workspace {
@@ -53,10 +56,22 @@ private:
 	//std::unique_ptr<YoloModelProcessor> yolo_model_processor;
 	std::shared_ptr<YoloModelProcessor> yolo_model_processor; // 外部注入
 
-	cv::Mat binary_mask;
+	BitMask binary_mask;                   // 模型或掩码文件得到的二值掩码，每像素 1 位
+	RunLengthMask binary_mask_runs;        // binary_mask 的 RLE 索引，按需构建
+	bool binary_mask_runs_dirty = true;    // binary_mask 变化后需要重建索引
+
+	Selection selection;                   // 当前选区，为空时命令作用于整幅图像
 
 public:
-	Workspace(const std::filesystem::path& image_path);
+	// unchanged 为 true 时保留图像文件的原始位深与通道数（见 MyImage）
+	Workspace(const std::filesystem::path& image_path, bool unchanged = false);
+
+	// 使用已解码的图像（如图像栈的某一页）；标注与掩码文件按 image_path 命名，
+	// load_sidecars 为 false 时不读取已有的标注与掩码文件（逐页处理会重新生成它们）
+	Workspace(const std::filesystem::path& image_path, const cv::Mat& image_mat, bool load_sidecars = true);
+
+	// RAW 文件按给定布局内存映射
+	Workspace(const std::filesystem::path& image_path, const RawImageInfo& raw_info);
 
 	/// ----------------------- 获取 MyImage 引用 -----------------------
 	// 获取 MyImage 的引用
@@ -79,6 +94,12 @@ public:
 	// 批量添加标注
 	void importShapes(const std::vector<MyShape>& new_shapes);
 
+	// 删除全部标注
+	void clearShapes();
+
+	// 有实例掩码的标注转换为简化后的多边形（见 PolygonTracing.h），返回转换的数量
+	int polygonizeShapes(double tolerance);
+
 
 	/// ----------------------- JSON文件的读写 -----------------------
 	// 读取标注文件
@@ -119,8 +140,18 @@ public:
 	// 获取所有标注
 	const std::vector<MyShape>& getShapes() const;
 	
-	// 获取 binary_mask 的方法
-	const cv::Mat& getBinaryMask() const;
+	// 获取 binary_mask 的方法：解包为 0 / 255 的 CV_8UC1，没有掩码时为空
+	cv::Mat getBinaryMask() const;
+	bool hasBinaryMask() const;
+
+	// 获取 binary_mask 的 RLE 索引（掩码变化后首次调用时重建）
+	const RunLengthMask& getBinaryMaskRuns();
+
+	/// ----------------------- 选区 -----------------------
+	void setSelection(const Selection& selection);
+	void clearSelection();
+	// 当前有效的选区；没有选区，或图像尺寸已改变（选区随之清除）时返回 nullptr
+	const Selection* getActiveSelection();
 
 	void setYoloModelProcessor(std::shared_ptr<YoloModelProcessor> processor);
 